@@ -0,0 +1,121 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#include "dsd_modulator_service.h"
+
+static_assert(sizeof(audio_sample) == sizeof(float), "PCM to DSD modulator expects 32-bit float audio_sample");
+
+dsd_modulator_service_t::dsd_modulator_service_t() {
+	m_channels = 0;
+	m_pcm_samplerate = 0;
+	m_dsd_samplerate = 0;
+	m_audio_seconds = 0;
+	m_volume = 1.0f;
+	m_active = false;
+}
+
+bool dsd_modulator_service_t::is_active() {
+	return m_active;
+}
+
+bool dsd_modulator_service_t::is_changed() {
+	return false;
+}
+
+void dsd_modulator_service_t::set_volume(double p_volume_dB) {
+	m_volume = (float)pow(10.0, p_volume_dB / 20.0);
+}
+
+bool dsd_modulator_service_t::start(t_size p_inp_channels, unsigned p_inp_samplerate, unsigned p_inp_channel_config, t_size& p_out_channels, unsigned& p_out_samplerate, unsigned& p_out_channel_config) {
+	stop();
+	if (p_inp_samplerate >= 1000000) {
+		return false; // DSD input
+	}
+	auto dsd_samplerate = DSDModulatorEngine::get_dsd_samplerate(p_inp_samplerate, get_dsd_multiplier());
+	if (dsd_samplerate == 0 || m_engine.init((int)p_inp_channels, (int)p_inp_samplerate, dsd_samplerate, DSD_MODULATOR_ORDER) < 0) {
+		return false;
+	}
+	m_engine.reset();
+	m_channels = p_inp_channels;
+	m_pcm_samplerate = p_inp_samplerate;
+	m_dsd_samplerate = dsd_samplerate;
+	m_audio_seconds = 0;
+	m_active = true;
+	p_out_channels = p_inp_channels;
+	p_out_samplerate = m_dsd_samplerate;
+	p_out_channel_config = p_inp_channel_config;
+	return true;
+}
+
+void dsd_modulator_service_t::stop() {
+	if (m_active && m_audio_seconds > 0) {
+		for (size_t ch = 0; ch < m_channels; ch++) {
+			console::printf("%s => channel %d [rtf = %s]", get_name(), (int)ch, pfc::format_float(m_engine.get_cpu_time((int)ch) / m_audio_seconds, 0, 4).toString());
+		}
+	}
+	m_active = false;
+}
+
+const t_uint8* dsd_modulator_service_t::run(const void* p_inp_pcmdsd, t_size p_inp_samples, t_size* p_out_samples) {
+	if (!m_active) {
+		*p_out_samples = 0;
+		return nullptr;
+	}
+	auto pcm_data = reinterpret_cast<const float*>(p_inp_pcmdsd);
+	if (m_volume != 1.0f) {
+		m_pcm_data.resize(p_inp_samples * m_channels);
+		for (size_t i = 0; i < m_pcm_data.size(); i++) {
+			m_pcm_data[i] = m_volume * pcm_data[i];
+		}
+		pcm_data = m_pcm_data.data();
+	}
+	m_dsd_data.resize(p_inp_samples * (m_dsd_samplerate / m_pcm_samplerate) / 8 * m_channels);
+	*p_out_samples = m_engine.convert(pcm_data, (int)p_inp_samples, m_dsd_data.data());
+	m_audio_seconds += (double)p_inp_samples / m_pcm_samplerate;
+	return m_dsd_data.data();
+}
+
+GUID dsd_modulator_dsd64_service_t::get_guid() {
+	static const GUID guid = { 0x5c8d13a2, 0x64e7, 0x4f1b, { 0xb0, 0x29, 0x7e, 0x3a, 0xd5, 0x86, 0x1c, 0x44 } };
+	return guid;
+}
+
+const char* dsd_modulator_dsd64_service_t::get_name() {
+	return "PCM to DSD64 (Sigma-Delta)";
+}
+
+int dsd_modulator_dsd64_service_t::get_dsd_multiplier() {
+	return 1;
+}
+
+GUID dsd_modulator_dsd128_service_t::get_guid() {
+	static const GUID guid = { 0xa91f6e08, 0x2d5b, 0x47c3, { 0x8f, 0x61, 0x0b, 0xe4, 0x92, 0x3d, 0x7a, 0x15 } };
+	return guid;
+}
+
+const char* dsd_modulator_dsd128_service_t::get_name() {
+	return "PCM to DSD128 (Sigma-Delta)";
+}
+
+int dsd_modulator_dsd128_service_t::get_dsd_multiplier() {
+	return 2;
+}
+
+GUID dsd_modulator_dsd256_service_t::get_guid() {
+	static const GUID guid = { 0x0e47b9c5, 0xc3a8, 0x4d92, { 0x96, 0x7d, 0x21, 0x5f, 0xe8, 0x0a, 0xb6, 0x3e } };
+	return guid;
+}
+
+const char* dsd_modulator_dsd256_service_t::get_name() {
+	return "PCM to DSD256 (Sigma-Delta)";
+}
+
+int dsd_modulator_dsd256_service_t::get_dsd_multiplier() {
+	return 4;
+}
+
+static service_factory_single_t<dsd_modulator_dsd64_service_t> g_dsd_modulator_dsd64_service_factory;
+static service_factory_single_t<dsd_modulator_dsd128_service_t> g_dsd_modulator_dsd128_service_factory;
+static service_factory_single_t<dsd_modulator_dsd256_service_t> g_dsd_modulator_dsd256_service_factory;
@@ -0,0 +1,61 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#ifndef _DSD_MODULATOR_SERVICE_H_INCLUDED
+#define _DSD_MODULATOR_SERVICE_H_INCLUDED
+
+#include "dsd_processor_service.h"
+#include "../libdsdmod/DSDModulatorEngine.h"
+
+constexpr int DSD_MODULATOR_ORDER = 7;
+
+// PCM -> DSD processor, DSD input is left alone (start() fails and the stream passes through)
+class dsd_modulator_service_t : public dsd_processor_service {
+	DSDModulatorEngine m_engine;
+	vector<float>      m_pcm_data;
+	vector<uint8_t>    m_dsd_data;
+	size_t             m_channels;
+	unsigned           m_pcm_samplerate;
+	unsigned           m_dsd_samplerate;
+	double             m_audio_seconds;
+	float              m_volume;
+	bool               m_active;
+public:
+	dsd_modulator_service_t();
+	virtual bool is_active();
+	virtual bool is_changed();
+	virtual void set_volume(double p_volume_dB);
+	virtual bool start(t_size p_inp_channels, unsigned p_inp_samplerate, unsigned p_inp_channel_config, t_size& p_out_channels, unsigned& p_out_samplerate, unsigned& p_out_channel_config);
+	virtual void stop();
+	virtual const t_uint8* run(const void* p_inp_pcmdsd, t_size p_inp_samples, t_size* p_out_samples);
+protected:
+	virtual int get_dsd_multiplier() = 0;
+};
+
+class dsd_modulator_dsd64_service_t : public dsd_modulator_service_t {
+public:
+	virtual GUID get_guid();
+	virtual const char* get_name();
+protected:
+	virtual int get_dsd_multiplier();
+};
+
+class dsd_modulator_dsd128_service_t : public dsd_modulator_service_t {
+public:
+	virtual GUID get_guid();
+	virtual const char* get_name();
+protected:
+	virtual int get_dsd_multiplier();
+};
+
+class dsd_modulator_dsd256_service_t : public dsd_modulator_service_t {
+public:
+	virtual GUID get_guid();
+	virtual const char* get_name();
+protected:
+	virtual int get_dsd_multiplier();
+};
+
+#endif
@@ -0,0 +1,232 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#include <chrono>
+#include "dsd_processor_chain.h"
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+dsd_processor_chain_t::dsd_processor_chain_t() {
+	m_channels = 0;
+	m_inp_samplerate = 0;
+	m_out_samplerate = 0;
+	m_inp_data = nullptr;
+	m_inp_samples = 0;
+	m_out_samples = 0;
+	m_audio_seconds = 0;
+	m_active = false;
+}
+
+dsd_processor_chain_t::~dsd_processor_chain_t() {
+	stop();
+}
+
+void dsd_processor_chain_t::add_stage(unique_ptr<dsd_processor_stage_t> p_stage) {
+	m_stages.push_back(std::move(p_stage));
+}
+
+size_t dsd_processor_chain_t::get_stage_count() const {
+	return m_stages.size();
+}
+
+const char* dsd_processor_chain_t::get_stage_name(size_t p_stage) const {
+	return m_stages[p_stage]->get_name();
+}
+
+// CPU time of the stage summed over all channels divided by the duration of the processed audio
+double dsd_processor_chain_t::get_stage_rtf(size_t p_stage) const {
+	double seconds = 0;
+	for (auto& slot : m_slots) {
+		if (p_stage < slot.stage_seconds.size()) {
+			seconds += slot.stage_seconds[p_stage];
+		}
+	}
+	return (m_audio_seconds > 0) ? seconds / m_audio_seconds : 0;
+}
+
+bool dsd_processor_chain_t::is_active() const {
+	return m_active;
+}
+
+bool dsd_processor_chain_t::start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate) {
+	stop();
+	auto samplerate = p_inp_samplerate;
+	for (auto& stage : m_stages) {
+		unsigned out_samplerate;
+		if (!stage->start(p_channels, samplerate, out_samplerate)) {
+			return false;
+		}
+		samplerate = out_samplerate;
+	}
+	m_channels = p_channels;
+	m_inp_samplerate = p_inp_samplerate;
+	m_out_samplerate = samplerate;
+	m_audio_seconds = 0;
+	m_slots.resize(p_channels);
+	for (size_t ch = 0; ch < p_channels; ch++) {
+		auto& slot = m_slots[ch];
+		slot.channel = ch;
+		slot.stage_seconds.assign(m_stages.size(), 0.0);
+		slot.run_slot = true;
+		slot.run_thread = thread(run_thread, this, &slot);
+	}
+	m_active = true;
+	p_out_samplerate = m_out_samplerate;
+	return true;
+}
+
+void dsd_processor_chain_t::stop() {
+	for (auto& slot : m_slots) {
+		if (slot.run_thread.joinable()) {
+			slot.run_slot = false;
+			slot.inp_semaphore.notify(); // Release worker thread for exit
+			slot.run_thread.join(); // Wait until worker thread exit
+		}
+	}
+	m_slots.clear(); // Exiting workers leave out_semaphore signalled, start() must not reuse the slots
+	m_active = false;
+}
+
+void dsd_processor_chain_t::set_volume(double p_volume_dB) {
+	for (auto& stage : m_stages) {
+		stage->set_volume(p_volume_dB);
+	}
+}
+
+const uint8_t* dsd_processor_chain_t::run(const uint8_t* p_inp_data, size_t p_inp_samples, size_t* p_out_samples) {
+	if (!m_active) {
+		*p_out_samples = 0;
+		return nullptr;
+	}
+	auto out_samples = p_inp_samples;
+	for (auto& stage : m_stages) {
+		out_samples = stage->get_out_bytes(out_samples);
+	}
+	m_inp_data = p_inp_data;
+	m_inp_samples = p_inp_samples;
+	m_out_samples = out_samples;
+	m_out_data.resize(m_out_samples * m_channels);
+	for (auto& slot : m_slots) {
+		slot.inp_semaphore.notify();
+	}
+	for (auto& slot : m_slots) {
+		slot.out_semaphore.wait();
+	}
+	m_audio_seconds += 8.0 * p_inp_samples / m_inp_samplerate;
+	*p_out_samples = m_out_samples;
+	return m_out_data.data();
+}
+
+void dsd_processor_chain_t::run_thread(dsd_processor_chain_t* p_chain, dsd_processor_chain_slot_t* p_slot) {
+	while (p_slot->run_slot) {
+		p_slot->inp_semaphore.wait();
+		if (p_slot->run_slot) {
+			p_chain->run_channel(*p_slot);
+		}
+		p_slot->out_semaphore.notify();
+	}
+}
+
+// Stage buffers are ping-ponged and keep their capacity between calls
+void dsd_processor_chain_t::run_channel(dsd_processor_chain_slot_t& p_slot) {
+	auto ch = p_slot.channel;
+	auto cur = 0;
+	auto bytes = m_inp_samples;
+	p_slot.buffer[cur].resize(bytes);
+	for (size_t i = 0; i < bytes; i++) {
+		p_slot.buffer[cur][i] = m_inp_data[i * m_channels + ch];
+	}
+	for (size_t s = 0; s < m_stages.size(); s++) {
+		auto& stage = m_stages[s];
+		p_slot.buffer[cur ^ 1].resize(stage->get_out_bytes(bytes));
+		auto t0 = steady_clock::now();
+		bytes = stage->process(ch, p_slot.buffer[cur].data(), bytes, p_slot.buffer[cur ^ 1].data());
+		p_slot.stage_seconds[s] += duration<double>(steady_clock::now() - t0).count();
+		cur ^= 1;
+	}
+	for (size_t i = 0; i < m_out_samples; i++) {
+		m_out_data[i * m_channels + ch] = p_slot.buffer[cur][i];
+	}
+}
+
+dsd_processor_chain_service_t::dsd_processor_chain_service_t() {
+	m_volume_dB = 0;
+}
+
+bool dsd_processor_chain_service_t::is_active() {
+	return m_chain.is_active();
+}
+
+bool dsd_processor_chain_service_t::is_changed() {
+	return false;
+}
+
+void dsd_processor_chain_service_t::set_volume(double p_volume_dB) {
+	m_volume_dB = p_volume_dB;
+	m_chain.set_volume(m_volume_dB);
+}
+
+bool dsd_processor_chain_service_t::start(t_size p_inp_channels, unsigned p_inp_samplerate, unsigned p_inp_channel_config, t_size& p_out_channels, unsigned& p_out_samplerate, unsigned& p_out_channel_config) {
+	stop();
+	if (p_inp_samplerate < 1000000) {
+		return false; // PCM input
+	}
+	if (m_chain.get_stage_count() == 0) {
+		add_stages(m_chain);
+	}
+	unsigned out_samplerate;
+	if (!m_chain.start(p_inp_channels, p_inp_samplerate, out_samplerate)) {
+		return false;
+	}
+	m_chain.set_volume(m_volume_dB);
+	p_out_channels = p_inp_channels;
+	p_out_samplerate = out_samplerate;
+	p_out_channel_config = p_inp_channel_config;
+	return true;
+}
+
+void dsd_processor_chain_service_t::stop() {
+	if (m_chain.is_active()) {
+		for (size_t s = 0; s < m_chain.get_stage_count(); s++) {
+			console::printf("%s => %s [rtf = %s]", get_name(), m_chain.get_stage_name(s), pfc::format_float(m_chain.get_stage_rtf(s), 0, 4).toString());
+		}
+	}
+	m_chain.stop();
+}
+
+const t_uint8* dsd_processor_chain_service_t::run(const void* p_inp_pcmdsd, t_size p_inp_samples, t_size* p_out_samples) {
+	return m_chain.run(reinterpret_cast<const t_uint8*>(p_inp_pcmdsd), p_inp_samples, p_out_samples);
+}
+
+GUID dsd_volume_service_t::get_guid() {
+	static const GUID guid = { 0x3f0c2b7e, 0x8d41, 0x4c5a, { 0x9e, 0x12, 0x6b, 0x57, 0xa4, 0x0d, 0xc3, 0x91 } };
+	return guid;
+}
+
+const char* dsd_volume_service_t::get_name() {
+	return "DSD Volume (Re-modulation)";
+}
+
+void dsd_volume_service_t::add_stages(dsd_processor_chain_t& p_chain) {
+	p_chain.add_stage(std::make_unique<dsd_volume_stage_t>());
+}
+
+GUID dsd_upsampler_service_t::get_guid() {
+	static const GUID guid = { 0x7a2e91d4, 0x1b6f, 0x4e08, { 0xa3, 0x5c, 0xd2, 0x8e, 0x47, 0x19, 0xf0, 0x6b } };
+	return guid;
+}
+
+const char* dsd_upsampler_service_t::get_name() {
+	return "DSD 2x Upsampler (DSD64 -> DSD128)";
+}
+
+void dsd_upsampler_service_t::add_stages(dsd_processor_chain_t& p_chain) {
+	p_chain.add_stage(std::make_unique<dsd_upsampler_stage_t>());
+	p_chain.add_stage(std::make_unique<dsd_volume_stage_t>());
+}
+
+static service_factory_single_t<dsd_volume_service_t> g_dsd_volume_service_factory;
+static service_factory_single_t<dsd_upsampler_service_t> g_dsd_upsampler_service_factory;
@@ -0,0 +1,97 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#ifndef _DSD_PROCESSOR_CHAIN_H_INCLUDED
+#define _DSD_PROCESSOR_CHAIN_H_INCLUDED
+
+#include <memory>
+#include <thread>
+#include "../libdsdpcm/semaphore.h"
+#include "dsd_processor_service.h"
+#include "dsd_processor_stages.h"
+
+using std::thread;
+using std::unique_ptr;
+
+class dsd_processor_chain_slot_t {
+public:
+	size_t          channel;
+	bool            run_slot;
+	thread          run_thread;
+	semaphore       inp_semaphore;
+	semaphore       out_semaphore;
+	vector<uint8_t> buffer[2];
+	vector<double>  stage_seconds;
+	dsd_processor_chain_slot_t() {
+		channel = 0;
+		run_slot = false;
+	}
+	dsd_processor_chain_slot_t(const dsd_processor_chain_slot_t& slot) : dsd_processor_chain_slot_t() {
+	}
+};
+
+// Stages run back to back on every channel, channels run in parallel on a thread per channel
+class dsd_processor_chain_t {
+	vector<unique_ptr<dsd_processor_stage_t>> m_stages;
+	vector<dsd_processor_chain_slot_t> m_slots;
+	size_t          m_channels;
+	unsigned        m_inp_samplerate;
+	unsigned        m_out_samplerate;
+	const uint8_t*  m_inp_data;
+	size_t          m_inp_samples;
+	vector<uint8_t> m_out_data;
+	size_t          m_out_samples;
+	double          m_audio_seconds;
+	bool            m_active;
+public:
+	dsd_processor_chain_t();
+	~dsd_processor_chain_t();
+	void add_stage(unique_ptr<dsd_processor_stage_t> p_stage);
+	size_t get_stage_count() const;
+	const char* get_stage_name(size_t p_stage) const;
+	double get_stage_rtf(size_t p_stage) const;
+	bool is_active() const;
+	bool start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate);
+	void stop();
+	void set_volume(double p_volume_dB);
+	const uint8_t* run(const uint8_t* p_inp_data, size_t p_inp_samples, size_t* p_out_samples);
+private:
+	static void run_thread(dsd_processor_chain_t* p_chain, dsd_processor_chain_slot_t* p_slot);
+	void run_channel(dsd_processor_chain_slot_t& p_slot);
+};
+
+// dsd_processor_service backed by a chain, derived services only pick the stages
+class dsd_processor_chain_service_t : public dsd_processor_service {
+	dsd_processor_chain_t m_chain;
+	double                m_volume_dB;
+public:
+	dsd_processor_chain_service_t();
+	virtual bool is_active();
+	virtual bool is_changed();
+	virtual void set_volume(double p_volume_dB);
+	virtual bool start(t_size p_inp_channels, unsigned p_inp_samplerate, unsigned p_inp_channel_config, t_size& p_out_channels, unsigned& p_out_samplerate, unsigned& p_out_channel_config);
+	virtual void stop();
+	virtual const t_uint8* run(const void* p_inp_pcmdsd, t_size p_inp_samples, t_size* p_out_samples);
+protected:
+	virtual void add_stages(dsd_processor_chain_t& p_chain) = 0;
+};
+
+class dsd_volume_service_t : public dsd_processor_chain_service_t {
+public:
+	virtual GUID get_guid();
+	virtual const char* get_name();
+protected:
+	virtual void add_stages(dsd_processor_chain_t& p_chain);
+};
+
+class dsd_upsampler_service_t : public dsd_processor_chain_service_t {
+public:
+	virtual GUID get_guid();
+	virtual const char* get_name();
+protected:
+	virtual void add_stages(dsd_processor_chain_t& p_chain);
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#include <math.h>
+#include <string.h>
+#include "dsd_processor_stages.h"
+
+constexpr double STAGE_CUTOFF_HZ = 100000.0;
+constexpr int STAGE_VOLUME_FIR_TAPS = 64;
+constexpr int STAGE_UPSAMPLER_FIR_TAPS = 128;
+constexpr int STAGE_MODULATOR_ORDER = 7;
+
+static vector<double> design_lowpass(int p_taps, double p_cutoff, double p_gain) {
+	const double PI = 3.14159265358979323846;
+	vector<double> taps(p_taps);
+	double sum = 0;
+	for (int n = 0; n < p_taps; n++) {
+		auto t = n - 0.5 * (p_taps - 1);
+		auto sinc = (t == 0) ? 2 * p_cutoff : sin(2 * PI * p_cutoff * t) / (PI * t);
+		auto window = 0.42 - 0.5 * cos(2 * PI * n / (p_taps - 1)) + 0.08 * cos(4 * PI * n / (p_taps - 1));
+		taps[n] = sinc * window;
+		sum += taps[n];
+	}
+	for (auto& tap : taps) {
+		tap *= p_gain / sum;
+	}
+	return taps;
+}
+
+dsd_fir_lut_t::dsd_fir_lut_t() {
+	m_bytes = 0;
+}
+
+void dsd_fir_lut_t::init(const vector<double>& p_taps) {
+	auto taps = (int)p_taps.size();
+	m_bytes = (taps + 6) / 8 + 1;
+	m_table.assign(8 * m_bytes * 256, 0.0f);
+	for (int bit = 0; bit < 8; bit++) {
+		for (int k = 0; k < m_bytes; k++) {
+			for (int v = 0; v < 256; v++) {
+				double sum = 0;
+				for (int b = 0; b < 8; b++) {
+					auto j = 8 * k + bit - b;
+					if (j >= 0 && j < taps) {
+						sum += ((v >> (7 - b)) & 1) ? p_taps[j] : -p_taps[j];
+					}
+				}
+				m_table[(bit * m_bytes + k) * 256 + v] = (float)sum;
+			}
+		}
+	}
+}
+
+int dsd_fir_lut_t::get_history_bytes() const {
+	return m_bytes - 1;
+}
+
+// p_newest points to the byte holding the newest bit, older bytes precede it
+float dsd_fir_lut_t::filter(const uint8_t* p_newest, int p_bit) const {
+	auto table = m_table.data() + p_bit * m_bytes * 256;
+	float sum = 0;
+	for (int k = 0; k < m_bytes; k++) {
+		sum += table[k * 256 + p_newest[-k]];
+	}
+	return sum;
+}
+
+static const uint8_t* append_history(vector<uint8_t>& p_history, vector<uint8_t>& p_work, int p_history_bytes, const uint8_t* p_inp_data, size_t p_inp_bytes) {
+	p_work.resize(p_history_bytes + p_inp_bytes);
+	memcpy(p_work.data(), p_history.data(), p_history_bytes);
+	memcpy(p_work.data() + p_history_bytes, p_inp_data, p_inp_bytes);
+	memcpy(p_history.data(), p_work.data() + p_inp_bytes, p_history_bytes);
+	return p_work.data() + p_history_bytes;
+}
+
+dsd_volume_stage_t::dsd_volume_stage_t() {
+	m_gain = 1.0f;
+}
+
+const char* dsd_volume_stage_t::get_name() {
+	return "DSD Volume";
+}
+
+bool dsd_volume_stage_t::start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate) {
+	if (p_inp_samplerate == 0) {
+		return false;
+	}
+	m_fir.init(design_lowpass(STAGE_VOLUME_FIR_TAPS, STAGE_CUTOFF_HZ / p_inp_samplerate, MODULATOR_INPUT_GAIN));
+	m_channels.resize(p_channels);
+	for (auto& channel : m_channels) {
+		channel.history.assign(m_fir.get_history_bytes(), 0x69);
+		if (!channel.modulator.init(STAGE_MODULATOR_ORDER)) {
+			return false;
+		}
+	}
+	p_out_samplerate = p_inp_samplerate;
+	return true;
+}
+
+void dsd_volume_stage_t::set_volume(double p_volume_dB) {
+	m_gain = (float)pow(10.0, fmin(p_volume_dB, 0.0) / 20.0);
+}
+
+size_t dsd_volume_stage_t::get_out_bytes(size_t p_inp_bytes) {
+	return p_inp_bytes;
+}
+
+size_t dsd_volume_stage_t::process(size_t p_channel, const uint8_t* p_inp_data, size_t p_inp_bytes, uint8_t* p_out_data) {
+	auto& channel = m_channels[p_channel];
+	auto inp = append_history(channel.history, channel.work, m_fir.get_history_bytes(), p_inp_data, p_inp_bytes);
+	auto gain = m_gain.load(); // latched once per chunk, the setter runs on another thread
+	if (gain == 1.0f) {
+		memcpy(p_out_data, p_inp_data, p_inp_bytes);
+		return p_inp_bytes;
+	}
+	channel.pcm.resize(8 * p_inp_bytes);
+	for (size_t i = 0; i < p_inp_bytes; i++) {
+		for (int bit = 0; bit < 8; bit++) {
+			channel.pcm[8 * i + bit] = gain * m_fir.filter(inp + i, bit);
+		}
+	}
+	channel.modulator.modulate(channel.pcm.data(), nullptr, (int)channel.pcm.size(), p_out_data, nullptr, 1);
+	return p_inp_bytes;
+}
+
+const char* dsd_upsampler_stage_t::get_name() {
+	return "DSD 2x Upsampler";
+}
+
+bool dsd_upsampler_stage_t::start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate) {
+	if (p_inp_samplerate == 0) {
+		return false;
+	}
+	p_out_samplerate = 2 * p_inp_samplerate;
+	auto taps = design_lowpass(STAGE_UPSAMPLER_FIR_TAPS, STAGE_CUTOFF_HZ / p_out_samplerate, 2.0 * MODULATOR_INPUT_GAIN);
+	for (int phase = 0; phase < 2; phase++) {
+		vector<double> phase_taps;
+		for (size_t n = phase; n < taps.size(); n += 2) {
+			phase_taps.push_back(taps[n]);
+		}
+		m_fir[phase].init(phase_taps);
+	}
+	m_channels.resize(p_channels);
+	for (auto& channel : m_channels) {
+		channel.history.assign(m_fir[0].get_history_bytes(), 0x69);
+		if (!channel.modulator.init(STAGE_MODULATOR_ORDER)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t dsd_upsampler_stage_t::get_out_bytes(size_t p_inp_bytes) {
+	return 2 * p_inp_bytes;
+}
+
+size_t dsd_upsampler_stage_t::process(size_t p_channel, const uint8_t* p_inp_data, size_t p_inp_bytes, uint8_t* p_out_data) {
+	auto& channel = m_channels[p_channel];
+	auto inp = append_history(channel.history, channel.work, m_fir[0].get_history_bytes(), p_inp_data, p_inp_bytes);
+	channel.pcm.resize(16 * p_inp_bytes);
+	for (size_t i = 0; i < p_inp_bytes; i++) {
+		for (int bit = 0; bit < 8; bit++) {
+			channel.pcm[16 * i + 2 * bit + 0] = m_fir[0].filter(inp + i, bit);
+			channel.pcm[16 * i + 2 * bit + 1] = m_fir[1].filter(inp + i, bit);
+		}
+	}
+	channel.modulator.modulate(channel.pcm.data(), nullptr, (int)channel.pcm.size(), p_out_data, nullptr, 1);
+	return 2 * p_inp_bytes;
+}
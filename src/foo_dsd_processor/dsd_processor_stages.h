@@ -0,0 +1,79 @@
+/*
+* DSD Processor plugin
+* Copyright (c) 2016-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*/
+
+#ifndef _DSD_PROCESSOR_STAGES_H_INCLUDED
+#define _DSD_PROCESSOR_STAGES_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "../libdsdmod/DSDModulatorEngine.h"
+
+using std::atomic;
+using std::vector;
+
+// One stage of a DSD processor chain, works on one channel of MSB first 1-bit data at a time
+class dsd_processor_stage_t {
+public:
+	virtual ~dsd_processor_stage_t() {}
+	virtual const char* get_name() = 0;
+	virtual bool start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate) = 0;
+	virtual void set_volume(double p_volume_dB) {}
+	virtual size_t get_out_bytes(size_t p_inp_bytes) = 0;
+	virtual size_t process(size_t p_channel, const uint8_t* p_inp_data, size_t p_inp_bytes, uint8_t* p_out_data) = 0;
+};
+
+// FIR over 1-bit input using per-phase byte lookup tables, a tap costs nothing once the tables are built
+class dsd_fir_lut_t {
+	int           m_bytes;
+	vector<float> m_table;
+public:
+	dsd_fir_lut_t();
+	void init(const vector<double>& p_taps);
+	int get_history_bytes() const;
+	float filter(const uint8_t* p_newest, int p_bit) const;
+};
+
+// DSD volume by low-pass filtering, scaling and re-modulating the 1-bit stream, 0 dB passes the stream through untouched
+class dsd_volume_stage_t : public dsd_processor_stage_t {
+	class channel_t {
+	public:
+		vector<uint8_t>  history;
+		vector<uint8_t>  work;
+		vector<float>    pcm;
+		DSDModulatorPair modulator;
+	};
+	dsd_fir_lut_t     m_fir;
+	vector<channel_t> m_channels;
+	atomic<float>     m_gain;
+public:
+	dsd_volume_stage_t();
+	virtual const char* get_name();
+	virtual bool start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate);
+	virtual void set_volume(double p_volume_dB);
+	virtual size_t get_out_bytes(size_t p_inp_bytes);
+	virtual size_t process(size_t p_channel, const uint8_t* p_inp_data, size_t p_inp_bytes, uint8_t* p_out_data);
+};
+
+// 2x DSD upsampler (DSD64 -> DSD128, DSD128 -> DSD256), polyphase interpolation followed by re-modulation
+class dsd_upsampler_stage_t : public dsd_processor_stage_t {
+	class channel_t {
+	public:
+		vector<uint8_t>  history;
+		vector<uint8_t>  work;
+		vector<float>    pcm;
+		DSDModulatorPair modulator;
+	};
+	dsd_fir_lut_t     m_fir[2];
+	vector<channel_t> m_channels;
+public:
+	virtual const char* get_name();
+	virtual bool start(size_t p_channels, unsigned p_inp_samplerate, unsigned& p_out_samplerate);
+	virtual size_t get_out_bytes(size_t p_inp_bytes);
+	virtual size_t process(size_t p_channel, const uint8_t* p_inp_data, size_t p_inp_bytes, uint8_t* p_out_data);
+};
+
+#endif
@@ -301,7 +301,18 @@ int mlp_audio_stream_t::decode(uint8_t* data, int* data_size, uint8_t* buf, int
 	return 0;
 }
 
-int mlp_audio_stream_t::resync(uint8_t* buf, int buf_size) {
+void mlp_audio_stream_t::take_integrity(integrity_report_t& report) {
+	MLPIntegrity& integrity = mlpDecodeCtx.integrity;
+	report.access_units    += integrity.access_units;
+	report.parity_errors   += integrity.parity_errors;
+	report.checksums       += integrity.checksums;
+	report.checksum_errors += integrity.checksum_errors;
+	report.lossless_checks += integrity.lossless_checks;
+	report.lossless_errors += integrity.lossless_errors;
+	memset(&integrity, 0, sizeof(integrity));
+}
+
+int mlp_audio_stream_t::find_major_sync(uint8_t* buf, int buf_size) {
 	uint32_t major_sync = 0;
 	for (int i = 4; i < buf_size; i++) {
 		major_sync = (major_sync << 8) | buf[i];
@@ -311,6 +322,10 @@ int mlp_audio_stream_t::resync(uint8_t* buf, int buf_size) {
 	return -1;
 }
 
+int mlp_audio_stream_t::resync(uint8_t* buf, int buf_size) {
+	return find_major_sync(buf, buf_size);
+}
+
 typedef struct {
 	uint16_t first_audio_frame;
 	uint8_t  padding1;
@@ -354,13 +369,8 @@ audio_stream_info_t* pcm_audio_stream_t::get_info(uint8_t* buf, int buf_size) {
 int pcm_audio_stream_t::init(uint8_t* buf, int buf_size, bool downmix, bool reset_statistics) {
 	if (!get_info(buf, buf_size))
 		return -1;
-	raw_group2_index = 0;
-	raw_group2_factor = group2_channels > 0 ? group1_samplerate / group2_samplerate : 1;
-	raw_group1_size = group1_channels * group1_bits / 4;
-	raw_group2_size = group2_channels * group2_bits / 4;
 	pcm_sample_size = group1_bits > 16 ? 4 : 2;
-	pcm_group1_size = 2 * group1_channels * pcm_sample_size;
-	pcm_group2_size = 2 * group2_channels * pcm_sample_size;
+	pcm_unpacker.init(group1_channels, group1_bits, group2_channels, group2_bits, group2_channels > 0 ? group1_samplerate / group2_samplerate : 1);
 	do_downmix = downmix;
 	if (downmix)
 		set_downmix_coef();
@@ -371,86 +381,7 @@ int pcm_audio_stream_t::init(uint8_t* buf, int buf_size, bool downmix, bool rese
 
 int pcm_audio_stream_t::decode(uint8_t* data, int* data_size, uint8_t* buf, int buf_size) {
 	try {
-		uint8_t* buf_out = data;
-		uint8_t* buf_inp = buf;
-		if (buf_size > DVD_BLOCK_SIZE)
-			buf_size = DVD_BLOCK_SIZE;
-		while (buf_inp + raw_group1_size + (raw_group2_index == 0 ? raw_group2_size : 0) <= buf + buf_size) {
-			int pcm_byte_index;
-			pcm_byte_index = 0;
-			if (raw_group2_index == 0) {
-				for (int i = 0; i < 2 * group2_channels; i++) {
-					switch (group2_bits) {
-					case 16:
-						if (group1_bits > 16) {
-							pcm_group2_pack[pcm_byte_index++] = 0;
-							pcm_group2_pack[pcm_byte_index++] = 0;
-						}
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-						break;
-					case 20:
-						pcm_group2_pack[pcm_byte_index++] = 0;
-						if (i % 2)
-							pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i / 2] & 0x0f;
-						else
-							pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i / 2] >> 4;
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-						break;
-					case 24:
-						pcm_group2_pack[pcm_byte_index++] = 0;
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[4 * group2_channels + i];
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-						pcm_group2_pack[pcm_byte_index++] = buf_inp[2 * i];
-						break;
-					default:
-						break;
-					}
-				}
-				buf_inp += raw_group2_size;
-			}
-			raw_group2_index++;
-			if (raw_group2_index == raw_group2_factor)
-				raw_group2_index = 0;
-			pcm_byte_index = 0;
-			for (int i = 0; i < 2 * group1_channels; i++) {
-				switch (group1_bits) {
-				case 16:
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				case 20:
-					pcm_group1_pack[pcm_byte_index++] = 0;
-					if (i % 2)
-						pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i / 2] << 4;
-					else
-						pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i / 2] & 0xf0;
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				case 24:
-					pcm_group1_pack[pcm_byte_index++] = 0;
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[4 * group1_channels + i];
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i + 1];
-					pcm_group1_pack[pcm_byte_index++] = buf_inp[2 * i];
-					break;
-				default:
-					break;
-				}
-			}
-			buf_inp += raw_group1_size;
-			memcpy(buf_out, pcm_group1_pack, pcm_group1_size / 2);
-			buf_out += pcm_group1_size / 2;
-			memcpy(buf_out, pcm_group2_pack, pcm_group2_size / 2);
-			buf_out += pcm_group2_size / 2;
-			memcpy(buf_out, pcm_group1_pack + pcm_group1_size / 2, pcm_group1_size / 2);
-			buf_out += pcm_group1_size / 2;
-			memcpy(buf_out, pcm_group2_pack + pcm_group2_size / 2, pcm_group2_size / 2);
-			buf_out += pcm_group2_size / 2;
-		}
-		*data_size = buf_out - data;
-		int bytes_decoded = buf_inp - buf;
+		int bytes_decoded = pcm_unpacker.unpack(buf, buf_size, data, data_size);
 		int buf_bits_read = 8 * bytes_decoded;
 		int buf_samples_decoded = (*data_size) / pcm_sample_size / (group1_channels + group2_channels);
 		int buf_bits_decoded = buf_samples_decoded * (group1_channels * group1_bits + group2_channels * group2_bits * group2_samplerate / group1_samplerate);
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include "audio_stream_info.h"
+#include "pcm_unpacker.h"
 
 extern "C" {
 #include "avcodec.h"
@@ -29,6 +30,27 @@ extern "C" {
 #include "MlpDecoder.h"
 }
 
+class integrity_report_t {
+public:
+	int64_t access_units;
+	int64_t parity_errors;
+	int64_t checksums;
+	int64_t checksum_errors;
+	int64_t lossless_checks;
+	int64_t lossless_errors;
+	integrity_report_t() {
+		reset();
+	}
+	void reset() {
+		access_units = parity_errors = 0;
+		checksums = checksum_errors = 0;
+		lossless_checks = lossless_errors = 0;
+	}
+	bool has_errors() const {
+		return parity_errors > 0 || checksum_errors > 0 || lossless_errors > 0;
+	}
+};
+
 class audio_stream_t : public audio_stream_info_t {
 	static constexpr int AVG_BITRATE_SIZE = 256;
 	int instant_bits_read[AVG_BITRATE_SIZE];
@@ -94,6 +116,8 @@ public:
 	virtual int get_stream_id() = 0;
 	virtual void set_check(bool check_on) {
 	}
+	virtual void take_integrity(integrity_report_t& report) {
+	}
 };
 
 typedef struct {
@@ -117,6 +141,7 @@ class mlp_audio_stream_t : public audio_stream_t {
 	bool                 do_check;
 public:
 	static int truehd_channels(int chanmap);
+	static int find_major_sync(uint8_t* buf, int buf_size);
 	virtual audio_stream_info_t* get_info(uint8_t* buf, int buf_size);
 	virtual int init(uint8_t* buf, int buf_size, bool downmix, bool reset_statistics = true);
 	virtual int decode(uint8_t* data, int* data_size, uint8_t* buf, int buf_size);
@@ -127,18 +152,12 @@ public:
 	virtual void set_check(bool check) {
 		do_check = check;
 	}
+	virtual void take_integrity(integrity_report_t& report);
 };
 
 class pcm_audio_stream_t : public audio_stream_t {
-	int raw_group2_index;
-	int raw_group2_factor;
-	int raw_group1_size;
-	int raw_group2_size;
 	int pcm_sample_size;
-	int pcm_group1_size;
-	int pcm_group2_size;
-	uint8_t pcm_group1_pack[2 * 4 * sizeof(int32_t)];
-	uint8_t pcm_group2_pack[2 * 4 * sizeof(int32_t)];
+	pcm_unpacker_t pcm_unpacker;
 public:
 	virtual audio_stream_info_t* get_info(uint8_t* buf, int buf_size);
 	virtual int init(uint8_t* buf, int buf_size, bool downmix, bool reset_statistics = true);
@@ -17,9 +17,57 @@
 * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
+#include <emmintrin.h>
 #include <memory.h>
 #include "dvda_block.h"
 
+constexpr uint32_t PACK_START_CODE = 0xba010000; // 00 00 01 BA as read by a little-endian load
+constexpr int      DEMUX_BATCH_BLOCKS = 32;
+constexpr int      DEMUX_BATCH_SEGMENTS = 4 * DEMUX_BATCH_BLOCKS;
+
+static inline uint32_t load_u32(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+// Bit i is set for every pack of the batch that starts with a pack header, four packs are tested per compare
+static uint32_t get_pack_mask(uint8_t* p_block, int blocks) {
+	const __m128i start_code = _mm_set1_epi32((int)PACK_START_CODE);
+	uint32_t mask = 0;
+	int i = 0;
+	for (; i + 4 <= blocks; i += 4) {
+		uint8_t* p = p_block + i * DVD_BLOCK_SIZE;
+		__m128i codes = _mm_set_epi32((int)load_u32(p + 3 * DVD_BLOCK_SIZE), (int)load_u32(p + 2 * DVD_BLOCK_SIZE), (int)load_u32(p + DVD_BLOCK_SIZE), (int)load_u32(p));
+		mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(codes, start_code))) << i;
+	}
+	for (; i < blocks; i++) {
+		if (load_u32(p_block + i * DVD_BLOCK_SIZE) == PACK_START_CODE) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
+// Calls f(ps1, ps1_length) for every private stream 1 packet of a pack, ps1 points at the sub header
+template <class F> static void for_each_ps1(uint8_t* p_block, F f) {
+	uint8_t* p_curr = p_block + 14 + (p_block[13] & 0x07);
+	while (p_curr < p_block + DVD_BLOCK_SIZE - 6) {
+		if ((load_u32(p_curr) & 0x00ffffff) != 0x00010000) {
+			break;
+		}
+		int pes_length = (p_curr[4] << 8) + p_curr[5];
+		if (p_curr[3] == 0xbd && p_curr < p_block + DVD_BLOCK_SIZE - 9) {
+			uint8_t* p_ps1_header = p_curr + 9 + p_curr[8];
+			uint8_t* p_ps1_end = p_curr + 6 + pes_length;
+			if (p_ps1_header < p_ps1_end && p_ps1_end <= p_block + DVD_BLOCK_SIZE) {
+				f(p_ps1_header, (int)(p_ps1_end - p_ps1_header));
+			}
+		}
+		p_curr += 6 + pes_length;
+	}
+}
+
 int dvda_block_t::get_ps1_info_length(uint8_t* p_substream_buffer, int substream_length) {
 	int header_length = 0;
 	sub_header_t* sub_header = (sub_header_t*)p_substream_buffer;
@@ -36,47 +84,129 @@ int dvda_block_t::get_ps1_info_length(uint8_t* p_substream_buffer, int substream
 	return header_length;
 }
 
-void dvda_block_t::get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info) {
-	uint8_t* p_ps1_header;
-	uint8_t* p_ps1_body;
-	uint8_t* p_ps1_end;
-	uint8_t* p_curr = p_block;
-	int pes_length;
-	int ps1_offset = 0;
-	if (*(uint32_t*)p_curr == 0xba010000) {
-		p_curr += 14 + (p_curr[13] & 0x07);
-		while (p_curr < p_block + DVD_BLOCK_SIZE - 6) {
-			pes_length = (p_curr[4] << 8) + p_curr[5];
-			if ((*(uint32_t*)p_curr & 0x00ffffff) == 0x00010000) {
-				if (p_curr[3] == 0xbd) { // check for private stream 1
-					if (p_curr < p_block + DVD_BLOCK_SIZE - 9) {
-						p_ps1_header = p_curr + 9 + p_curr[8];
-						p_ps1_end = p_curr + 6 + pes_length;
-						if (p_ps1_header < p_ps1_end && p_ps1_end <= p_block + DVD_BLOCK_SIZE) {
-							int ps1_header_length = get_ps1_info_length(p_ps1_header, p_ps1_end - p_ps1_header);
-							if (p_ps1_info && p_ps1_info->header.stream_id == UNK_STREAM_ID && ps1_header_length > 0)
-								memcpy(p_ps1_info, p_ps1_header, ps1_header_length < sizeof(sub_header_t) ? ps1_header_length : sizeof(sub_header_t));
-							p_ps1_body = p_ps1_header + ps1_header_length;
-							int ps1_body_length = p_ps1_end - p_ps1_body;
-							if (ps1_body_length > 0) {
-								memcpy(p_ps1_buffer + *p_ps1_offset + ps1_offset, p_ps1_body, ps1_body_length);
-								ps1_offset += ps1_body_length;
-							}
-						}
+bool dvda_block_t::is_same_stream(const sub_header_t& p_ps1_info, const sub_header_t& p_ps1_next) {
+	if (p_ps1_info.header.stream_id != p_ps1_next.header.stream_id) {
+		return false;
+	}
+	if (p_ps1_info.header.stream_id == PCM_STREAM_ID) {
+		return
+			p_ps1_info.extra_header.pcm.channel_assignment == p_ps1_next.extra_header.pcm.channel_assignment &&
+			p_ps1_info.extra_header.pcm.group1_bits == p_ps1_next.extra_header.pcm.group1_bits &&
+			p_ps1_info.extra_header.pcm.group1_samplerate == p_ps1_next.extra_header.pcm.group1_samplerate &&
+			p_ps1_info.extra_header.pcm.group2_bits == p_ps1_next.extra_header.pcm.group2_bits &&
+			p_ps1_info.extra_header.pcm.group2_samplerate == p_ps1_next.extra_header.pcm.group2_samplerate;
+	}
+	return true;
+}
+
+// Scans the packs batch by batch into a gather list of PS1 payloads, adjacent payloads merge into one segment.
+// The listed payloads are moved behind each other when the list is full, in front of a stream change and at the
+// end. Demuxing in place is fine: payloads only ever move towards the buffer start and each one lands before the
+// source of the next. With p_split the packs without an audio sub header are dropped and the scan stops in front
+// of the first pack whose sub header does not match *p_ps1_info, the number of packs consumed is returned.
+int dvda_block_t::demux_ps1(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info, bool p_split) {
+	ps1_segment_t segments[DEMUX_BATCH_SEGMENTS];
+	int segment_count = 0;
+	uint8_t* p_out = p_ps1_buffer + *p_ps1_offset;
+	auto add_segment = [&](uint8_t* data, int length) {
+		if (segment_count > 0 && segments[segment_count - 1].data + segments[segment_count - 1].length == data) {
+			segments[segment_count - 1].length += length;
+			return;
+		}
+		if (segment_count == DEMUX_BATCH_SEGMENTS) {
+			flush_segments(segments, segment_count, p_out);
+			segment_count = 0;
+		}
+		segments[segment_count].data = data;
+		segments[segment_count].length = length;
+		segment_count++;
+	};
+	for (int batch_first = 0; batch_first < blocks; batch_first += DEMUX_BATCH_BLOCKS) {
+		int batch_blocks = blocks - batch_first < DEMUX_BATCH_BLOCKS ? blocks - batch_first : DEMUX_BATCH_BLOCKS;
+		uint8_t* p_batch = p_block + batch_first * DVD_BLOCK_SIZE;
+		uint32_t pack_mask = get_pack_mask(p_batch, batch_blocks);
+		for (int i = 0; i < batch_blocks; i++) {
+			if (!(pack_mask & (1u << i))) {
+				continue;
+			}
+			uint8_t* p_pack = p_batch + i * DVD_BLOCK_SIZE;
+			if (p_split) {
+				uint8_t* p_pack_info = nullptr;
+				int pack_info_length = 0;
+				for_each_ps1(p_pack, [&](uint8_t* ps1, int ps1_length) {
+					if (!p_pack_info && (pack_info_length = get_ps1_info_length(ps1, ps1_length)) > 0) {
+						p_pack_info = ps1;
 					}
+				});
+				if (!p_pack_info) {
+					continue;
+				}
+				sub_header_t pack_info;
+				memcpy(&pack_info, p_pack_info, pack_info_length < sizeof(sub_header_t) ? pack_info_length : sizeof(sub_header_t));
+				if (p_ps1_info->header.stream_id == UNK_STREAM_ID) {
+					*p_ps1_info = pack_info;
+				}
+				else if (!is_same_stream(*p_ps1_info, pack_info)) {
+					flush_segments(segments, segment_count, p_out);
+					*p_ps1_offset = (int)(p_out - p_ps1_buffer);
+					return batch_first + i;
 				}
-				p_curr += 6 + pes_length;
 			}
-			else
-				break;
+			for_each_ps1(p_pack, [&](uint8_t* ps1, int ps1_length) {
+				int ps1_header_length = get_ps1_info_length(ps1, ps1_length);
+				if (!p_split && p_ps1_info && p_ps1_info->header.stream_id == UNK_STREAM_ID && ps1_header_length > 0) {
+					memcpy(p_ps1_info, ps1, ps1_header_length < sizeof(sub_header_t) ? ps1_header_length : sizeof(sub_header_t));
+				}
+				if (ps1_length - ps1_header_length > 0) {
+					add_segment(ps1 + ps1_header_length, ps1_length - ps1_header_length);
+				}
+			});
 		}
 	}
-	*p_ps1_offset += ps1_offset;
+	flush_segments(segments, segment_count, p_out);
+	*p_ps1_offset = (int)(p_out - p_ps1_buffer);
+	return blocks;
+}
+
+void dvda_block_t::flush_segments(ps1_segment_t* p_segments, int segment_count, uint8_t*& p_out) {
+	for (int i = 0; i < segment_count; i++) {
+		if (p_out != p_segments[i].data) {
+			memmove(p_out, p_segments[i].data, p_segments[i].length);
+		}
+		p_out += p_segments[i].length;
+	}
+}
+
+void dvda_block_t::get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info) {
+	demux_ps1(p_block, 1, p_ps1_buffer, p_ps1_offset, p_ps1_info, false);
 }
 
 void dvda_block_t::get_ps1(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info) {
 	if (p_ps1_info)
 		p_ps1_info->header.stream_id = UNK_STREAM_ID;
-	for (int i = 0; i < blocks; i++)
-		get_ps1(p_block + i * DVD_BLOCK_SIZE, p_ps1_buffer, p_ps1_offset, p_ps1_info);
+	demux_ps1(p_block, blocks, p_ps1_buffer, p_ps1_offset, p_ps1_info, false);
+}
+
+int dvda_block_t::get_ps1_stream(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info) {
+	return demux_ps1(p_block, blocks, p_ps1_buffer, p_ps1_offset, p_ps1_info, true);
+}
+
+bool dvda_block_t::get_pts(uint8_t* p_block, uint32_t* p_pts) {
+	uint8_t* p_curr = p_block;
+	if (load_u32(p_curr) == PACK_START_CODE) {
+		p_curr += 14 + (p_curr[13] & 0x07);
+		while (p_curr < p_block + DVD_BLOCK_SIZE - 14) {
+			if ((load_u32(p_curr) & 0x00ffffff) != 0x00010000)
+				break;
+			if (p_curr[3] == 0xbd) { // PTS of the first access unit starting in private stream 1
+				if (p_curr[7] & 0x80) {
+					*p_pts = ((uint32_t)(p_curr[9] & 0x0e) << 29) | (p_curr[10] << 22) | ((p_curr[11] & 0xfe) << 14) | (p_curr[12] << 7) | (p_curr[13] >> 1);
+					return true;
+				}
+				return false;
+			}
+			p_curr += 6 + (p_curr[4] << 8) + p_curr[5];
+		}
+	}
+	return false;
 }
@@ -59,11 +59,21 @@ typedef struct {
 	uint8_t padding[256];
 } sub_header_t;
 
+typedef struct {
+	uint8_t* data;
+	int      length;
+} ps1_segment_t;
+
 class dvda_block_t {
 	static int get_ps1_info_length(uint8_t* p_substream_buffer, int substream_length);
+	static int demux_ps1(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info, bool p_split);
+	static void flush_segments(ps1_segment_t* p_segments, int segment_count, uint8_t*& p_out);
 public:
+	static bool is_same_stream(const sub_header_t& p_ps1_info, const sub_header_t& p_ps1_next);
 	static void get_ps1(uint8_t* p_block, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info);
 	static void get_ps1(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info);
+	static int get_ps1_stream(uint8_t* p_block, int blocks, uint8_t* p_ps1_buffer, int* p_ps1_offset, sub_header_t* p_ps1_info);
+	static bool get_pts(uint8_t* p_block, uint32_t* p_pts);
 };
 
 #endif
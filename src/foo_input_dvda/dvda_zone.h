@@ -36,6 +36,10 @@ auto PTS_TO_SEC = [](auto pts) {
 	return (double)pts / 90000.0;
 };
 
+auto SEC_TO_PTS = [](double sec) {
+	return sec * 90000.0;
+};
+
 class dvda_sector_pointer_t;
 class dvda_track_t;
 class dvda_title_t;
@@ -17,6 +17,11 @@
 * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <foobar2000.h>
 #include "resource.h"
 
@@ -36,6 +41,11 @@ enum class media_type_e { UNK_TYPE = 0, IFO_TYPE = 1, ISO_TYPE = 2, MLP_TYPE = 3
 static constexpr uint32_t START_OF_MASTER_TOC = 510;
 static constexpr uint32_t UPDATE_STATS_MS = 500;
 static constexpr double   SHORT_TRACK_SEC = 3.0;
+static constexpr int      SEEK_PTS_SCAN_BLOCKS = 16;
+static constexpr int      SEEK_SYNC_SCAN_BLOCKS = 128;
+static constexpr double   SEEK_SYNC_INTERVAL_SEC = 128 * 40 / 44100.0; // MLP restarts at least every 128 access units
+static constexpr int      READER_WRITE_BLOCKS = 16;
+static constexpr int      READER_POLL_MS = 100;
 
 static dvda_disc_cache_t g_dvda_disc_cache;
 static bool              g_no_untagged_tracks;
@@ -58,20 +68,29 @@ class input_dvda_t : public input_stubs {
 	dvda_zone_t*                  dvda_zone;
 	track_list_t*                 track_list;
 	dvda_metabase_t*              dvda_metabase;
-	stream_buffer_t<uint8_t, int> track_stream;
-	t_filesize                    track_stream_bytes_aob;
-	t_filesize                    track_stream_bytes_ps1;
+	stream_buffer_t<uint8_t, int, true> track_stream;
+	std::atomic<t_filesize>       track_stream_bytes_aob;
+	std::atomic<t_filesize>       track_stream_bytes_ps1;
+	std::thread                   reader_thread;
+	std::mutex                    reader_mutex;
+	std::condition_variable       reader_cv;
+	abort_callback_impl           reader_abort;
+	bool                          reader_stop;
+	std::atomic<bool>             reader_eof;
 	media_file_t                  media_file;
 	media_type_e                  media_type;
 	CPxMContext                   aob_cpxm_context;
 	audio_stream_t*               audio_stream;
 	audio_track_t                 audio_track;
+	integrity_report_t            track_integrity;
 	t_filesize                    stream_size;
 	double                        stream_duration;
 	int                           stream_titleset;
 	sub_header_t                  stream_ps1_info;
 	uint32_t                      stream_block_current;
-	bool                          stream_needs_reinit;
+	std::map<uint32_t, uint32_t>  stream_pts_index;
+	int64_t                       stream_skip_samples;
+	std::atomic<bool>             stream_needs_reinit;
 	bool                          major_sync_0;
 	byte_array_t                  pcm_out_buffer;
 	t_size                        pcm_out_buffer_size;
@@ -85,12 +104,17 @@ public:
 	input_dvda_t() {
 		audio_stream = nullptr;
 		track_stream_bytes_aob = track_stream_bytes_ps1 = 0;
+		reader_stop = false;
+		reader_eof = false;
+		stream_needs_reinit = false;
 		info_update_time_ms = 0;
 		my_av_log_set_callback(foo_av_log_callback);
 		g_dvda_disc_cache.add_ref();
 	}
 
 	virtual ~input_dvda_t() {
+		stop_reader();
+		report_integrity();
 		if (audio_stream) {
 			delete audio_stream;
 		}
@@ -374,8 +398,10 @@ public:
 			console_printf("Track list error: entry %d does not exist", p_subsong);
 			throw exception_io();
 		}
+		stop_reader();
+		report_integrity();
 		audio_track = (*track_list)[i];
-		track_stream.init(512 * DVD_BLOCK_SIZE, 4 * DVD_BLOCK_SIZE, 1 * DVD_BLOCK_SIZE);
+		track_stream.init(512 * DVD_BLOCK_SIZE, 4 * DVD_BLOCK_SIZE, READER_WRITE_BLOCKS * DVD_BLOCK_SIZE);
 		switch (media_type) {
 		case media_type_e::IFO_TYPE:
 		case media_type_e::ISO_TYPE:
@@ -397,16 +423,17 @@ public:
 			break;
 		}
 		stream_duration = audio_track.duration;
+		stream_pts_index.clear();
+		stream_skip_samples = 0;
 		stream_needs_reinit = false;
 		major_sync_0 = false;
 		g_watermarked = false;
+		start_reader();
 	}
 
 	bool decode_run(audio_chunk_t& p_chunk, abort_callback& p_abort) {
 		decode_run_read_stream_start:
-		if (track_stream.is_ready_to_write() && !stream_needs_reinit) {
-			stream_buffer_read(p_abort);
-		}
+		wait_reader(p_abort);
 		int data_size, bytes_decoded = 0;
 		data_size = pcm_out_buffer.get_size();
 		bytes_decoded = (audio_stream ? audio_stream->decode(pcm_out_buffer.get_ptr(), &data_size, track_stream.get_read_ptr(), track_stream.get_read_size()) : 0);
@@ -419,24 +446,28 @@ public:
 			bool decoder_needs_reinit = (bytes_decoded == audio_stream_t::RETCODE_REINIT);
 			if (decoder_needs_reinit) {
 				if (audio_stream) {
+					audio_stream->take_integrity(track_integrity);
 					delete audio_stream;
 					audio_stream = nullptr;
 				}
 				console_printf("Reinitializing DVD-Audio Decoder: MLP/TrueHD");
 				goto decode_run_read_stream_start;
 			}
+			bool needs_reinit = stream_needs_reinit;
 			if (track_stream.get_read_size() == 0) {
-				if (stream_needs_reinit) {
-					stream_needs_reinit = false;
+				if (needs_reinit) {
 					if (audio_stream) {
+						audio_stream->take_integrity(track_integrity);
 						delete audio_stream;
 						audio_stream = nullptr;
 					}
-					stream_ps1_info.header.stream_id = UNK_STREAM_ID;
+					set_stream_id(UNK_STREAM_ID);
+					stream_needs_reinit = false;
 					console_printf("Reinitializing DVD-Audio Decoder: PCM");
 					goto decode_run_read_stream_start;
 				}
 				else {
+					report_integrity();
 					return false;
 				}
 			}
@@ -453,7 +484,7 @@ public:
 					}
 				}
 				if (major_sync < 0) {
-					if (stream_needs_reinit) {
+					if (needs_reinit) {
 						major_sync = track_stream.get_read_size();
 					}
 					else {
@@ -470,7 +501,12 @@ public:
 				goto decode_run_read_stream_start;
 			}
 			else {
-				audio_stream = create_audio_stream(stream_ps1_info, track_stream.get_read_ptr(), track_stream.get_read_size(), audio_track.track_downmix);
+				sub_header_t ps1_info;
+				{
+					std::lock_guard<std::mutex> lock(reader_mutex);
+					ps1_info = stream_ps1_info;
+				}
+				audio_stream = create_audio_stream(ps1_info, track_stream.get_read_ptr(), track_stream.get_read_size(), audio_track.track_downmix);
 				if (audio_stream) {
 					if ((media_type == media_type_e::IFO_TYPE || media_type == media_type_e::ISO_TYPE) && audio_stream->get_downmix()) {
 						audio_stream->set_downmix_coef(audio_track.LR_dmx_coef);
@@ -480,7 +516,7 @@ public:
 				}
 				else {
 					track_stream.move_read_ptr(DVD_BLOCK_SIZE);
-					stream_ps1_info.header.stream_id = UNK_STREAM_ID;
+					set_stream_id(UNK_STREAM_ID);
 					console_printf("Error: DVD-Audio Decoder initialization failed");
 				}
 				goto decode_run_read_stream_start;
@@ -489,27 +525,40 @@ public:
 		}
 		major_sync_0 = false;
 		track_stream.move_read_ptr(bytes_decoded);
-		p_chunk.set_data_fixedpoint(pcm_out_buffer.get_ptr(), data_size, pcm_out_samplerate, pcm_out_channels, pcm_out_bits, pcm_out_channel_map);
+		int data_offset = 0;
+		if (stream_skip_samples > 0) {
+			int sample_size = pcm_out_channels * pcm_out_bits / 8;
+			if (stream_skip_samples >= data_size / sample_size) {
+				stream_skip_samples -= data_size / sample_size;
+				goto decode_run_read_stream_start;
+			}
+			data_offset = (int)stream_skip_samples * sample_size;
+			stream_skip_samples = 0;
+		}
+		p_chunk.set_data_fixedpoint(pcm_out_buffer.get_ptr() + data_offset, data_size - data_offset, pcm_out_samplerate, pcm_out_channels, pcm_out_bits, pcm_out_channel_map);
 		return true;
 	}
 
 	void decode_seek(double p_seconds, abort_callback& p_abort) {
+		stop_reader();
 		track_stream.reinit();
 		if (audio_stream) {
+			audio_stream->take_integrity(track_integrity);
 			delete audio_stream;
 			audio_stream = nullptr;
 		}
+		stream_skip_samples = 0;
 		switch (media_type) {
 		case media_type_e::IFO_TYPE:
 		case media_type_e::ISO_TYPE:
-			{
+			if (!seek_pts(p_seconds)) {
 				uint32_t offset = (uint32_t)((p_seconds / (audio_track.duration + 1.0)) * (double)(audio_track.block_last + 1 - audio_track.block_first));
 				if (offset > audio_track.block_last - audio_track.block_first - 1) {
 					offset = audio_track.block_last - audio_track.block_first - 1;
 				}
 				stream_block_current = audio_track.block_first + offset;
-				stream_ps1_info.header.stream_id = UNK_STREAM_ID;
 			}
+			stream_ps1_info.header.stream_id = UNK_STREAM_ID;
 			break;
 		case media_type_e::MLP_TYPE:
 			{
@@ -531,7 +580,9 @@ public:
 			}
 			break;
 		}
+		stream_needs_reinit = false;
 		g_watermarked = false;
+		start_reader();
 	}
 
 	bool decode_can_seek() {
@@ -649,6 +700,27 @@ public:
 	}
 
 private:
+	// Parity, checksum and lossless check results of the track just decoded, summed over every decoder it went through
+	void report_integrity() {
+		if (audio_stream) {
+			audio_stream->take_integrity(track_integrity);
+		}
+		if (track_integrity.access_units > 0) {
+			console_printf(
+				"DVD-Audio Decoder integrity %s, track %d: %lld access units, %lld checksums (%lld failed), %lld lossless checks (%lld failed), %lld parity errors",
+				track_integrity.has_errors() ? "FAILED" : "OK",
+				audio_track.track_number,
+				(long long)track_integrity.access_units,
+				(long long)track_integrity.checksums,
+				(long long)track_integrity.checksum_errors,
+				(long long)track_integrity.lossless_checks,
+				(long long)track_integrity.lossless_errors,
+				(long long)track_integrity.parity_errors
+			);
+		}
+		track_integrity.reset();
+	}
+
 	audio_stream_t* create_audio_stream(sub_header_t& p_ps1_info, uint8_t* p_buf, int p_buf_size, bool p_downmix) {
 		audio_stream_t* audio_stream;
 		int init_code = -1;
@@ -690,9 +762,224 @@ private:
 		return audio_stream;
 	}
 
-	void stream_buffer_read(abort_callback& p_abort) {
+	bool seek_pts(double p_seconds) {
+		uint32_t block_lo, pts_lo, block_hi = audio_track.block_last + 1;
+		if (!seek_probe_pts(audio_track.block_first, block_lo, pts_lo)) {
+			return false;
+		}
+		uint32_t target_pts = pts_lo + (uint32_t)SEC_TO_PTS(p_seconds < audio_track.duration ? p_seconds : audio_track.duration);
+		// MLP decoding restarts on the first major sync after the block, look one sync interval earlier so it comes before the target
+		uint32_t probe_pts = target_pts;
+		if (audio_track.audio_stream_info.stream_id == MLP_STREAM_ID) {
+			uint32_t sync_interval_pts = (uint32_t)SEC_TO_PTS(SEEK_SYNC_INTERVAL_SEC);
+			probe_pts = target_pts - pts_lo > sync_interval_pts ? target_pts - sync_interval_pts : pts_lo;
+		}
+		for (auto it = stream_pts_index.upper_bound(block_lo); it != stream_pts_index.end() && it->first < block_hi; it++) {
+			if (it->second > probe_pts) {
+				block_hi = it->first;
+				break;
+			}
+			block_lo = it->first;
+		}
+		while (block_hi - block_lo > 1) {
+			uint32_t block_probe = block_lo + (block_hi - block_lo) / 2, block_pts, pts;
+			if (seek_probe_pts(block_probe, block_pts, pts) && block_pts < block_hi && pts <= probe_pts) {
+				block_lo = block_pts;
+			}
+			else {
+				block_hi = block_probe;
+			}
+		}
+		stream_block_current = block_lo;
+		stream_skip_samples = seek_get_skip_samples(block_lo, target_pts);
+		return true;
+	}
+
+	bool seek_probe_pts(uint32_t p_block, uint32_t& p_block_pts, uint32_t& p_pts) {
+		auto it = stream_pts_index.find(p_block);
+		if (it != stream_pts_index.end()) {
+			p_block_pts = it->first;
+			p_pts = it->second;
+			return true;
+		}
+		if (p_block > audio_track.block_last) {
+			return false;
+		}
+		int blocks_to_read = audio_track.block_last + 1 - p_block < SEEK_PTS_SCAN_BLOCKS ? audio_track.block_last + 1 - p_block : SEEK_PTS_SCAN_BLOCKS;
+		byte_array_t blocks;
+		blocks.set_size(blocks_to_read * DVD_BLOCK_SIZE);
+		int blocks_read = dvda_zone->get_blocks(stream_titleset, p_block, blocks_to_read, blocks.get_ptr());
+		bool pts_found = false;
+		for (int block = 0; block < blocks_read; block++) {
+			uint32_t pts;
+			if (dvda_block_t::get_pts(blocks.get_ptr() + block * DVD_BLOCK_SIZE, &pts)) {
+				stream_pts_index[p_block + block] = pts;
+				if (!pts_found) {
+					p_block_pts = p_block + block;
+					p_pts = pts;
+					pts_found = true;
+				}
+			}
+		}
+		return pts_found;
+	}
+
+	int64_t seek_get_skip_samples(uint32_t p_block, uint32_t p_target_pts) {
+		int samplerate = audio_track.audio_stream_info.group1_samplerate;
+		if (samplerate <= 0) {
+			return 0;
+		}
+		double sync_pts = stream_pts_index[p_block];
+		if (audio_track.audio_stream_info.stream_id == MLP_STREAM_ID) {
+			int blocks_to_read = audio_track.block_last + 1 - p_block < SEEK_SYNC_SCAN_BLOCKS ? audio_track.block_last + 1 - p_block : SEEK_SYNC_SCAN_BLOCKS;
+			byte_array_t blocks, ps1_buffer;
+			blocks.set_size(blocks_to_read * DVD_BLOCK_SIZE);
+			ps1_buffer.set_size(blocks_to_read * DVD_BLOCK_SIZE);
+			int blocks_read = dvda_zone->get_blocks(stream_titleset, p_block, blocks_to_read, blocks.get_ptr());
+			std::vector<int> ps1_offsets(blocks_read + 1);
+			int ps1_size = 0;
+			for (int block = 0; block < blocks_read; block++) {
+				ps1_offsets[block] = ps1_size;
+				dvda_block_t::get_ps1(blocks.get_ptr() + block * DVD_BLOCK_SIZE, ps1_buffer.get_ptr(), &ps1_size, nullptr);
+			}
+			ps1_offsets[blocks_read] = ps1_size;
+			// the decoder starts on the first major sync
+			uint8_t* ps1 = ps1_buffer.get_ptr();
+			int au_offset = mlp_audio_stream_t::find_major_sync(ps1, ps1_size);
+			if (au_offset < 0) {
+				return 0;
+			}
+			// a PES PTS belongs to the first access unit starting in its packet, walk the access unit chain from
+			// the major sync up to a packet whose first access unit is known and count back from its PTS
+			int sync_offset = au_offset;
+			int au_count = 0;
+			int au_samples = 40 * (samplerate % 48000 == 0 ? samplerate / 48000 : samplerate / 44100);
+			bool pts_found = false;
+			for (int block = 0; block < blocks_read && !pts_found; block++) {
+				if (ps1_offsets[block] < sync_offset) {
+					continue;
+				}
+				while (au_offset < ps1_offsets[block]) {
+					if (au_offset + 2 > ps1_size) {
+						return 0;
+					}
+					int au_length = 2 * (((ps1[au_offset] & 0x0f) << 8) | ps1[au_offset + 1]);
+					if (au_length <= 0) {
+						return 0;
+					}
+					au_offset += au_length;
+					au_count++;
+				}
+				uint32_t pts;
+				if (au_offset < ps1_offsets[block + 1] && dvda_block_t::get_pts(blocks.get_ptr() + block * DVD_BLOCK_SIZE, &pts)) {
+					sync_pts = (double)pts - SEC_TO_PTS((double)au_count * au_samples / samplerate);
+					pts_found = true;
+				}
+			}
+			if (!pts_found) {
+				return 0;
+			}
+		}
+		else {
+			// the PES PTS belongs to the frame at first_audio_frame, counted from the last byte of the pointer field,
+			// but decoding starts at the payload start
+			byte_array_t block, ps1_buffer;
+			block.set_size(DVD_BLOCK_SIZE);
+			ps1_buffer.set_size(DVD_BLOCK_SIZE);
+			if (dvda_zone->get_blocks(stream_titleset, p_block, 1, block.get_ptr()) == 1) {
+				sub_header_t ps1_info;
+				ps1_info.header.stream_id = UNK_STREAM_ID;
+				int ps1_size = 0;
+				dvda_block_t::get_ps1(block.get_ptr(), ps1_buffer.get_ptr(), &ps1_size, &ps1_info);
+				int bitrate = audio_track.audio_stream_info.bitrate;
+				if (ps1_info.header.stream_id == PCM_STREAM_ID && bitrate > 0) {
+					auto pointer = (const uint8_t*)&ps1_info.extra_header.pcm.first_audio_frame;
+					int frame_offset = ((pointer[0] << 8) | pointer[1]) + 5 - (int)sizeof(ps1_info.header) - ps1_info.header.extra_header_length;
+					if (frame_offset > 0 && frame_offset < ps1_size) {
+						sync_pts -= SEC_TO_PTS(8.0 * frame_offset / bitrate);
+					}
+				}
+			}
+		}
+		double skip_samples = PTS_TO_SEC((double)p_target_pts - sync_pts) * samplerate;
+		return skip_samples > 0.0 ? (int64_t)(skip_samples + 0.5) : 0;
+	}
+
+	void start_reader() {
+		reader_stop = false;
+		reader_eof = false;
+		reader_abort.reset();
+		reader_thread = std::thread(&input_dvda_t::run_reader, this);
+	}
+
+	void stop_reader() {
+		if (reader_thread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(reader_mutex);
+				reader_stop = true;
+			}
+			reader_abort.abort();
+			reader_cv.notify_all();
+			reader_thread.join();
+		}
+	}
+
+	// Reads, decrypts and demuxes ahead of the decoder until the ring is full, a stream change has to be drained
+	// by decode_run first, or the track is over
+	void run_reader() {
+		try {
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(reader_mutex);
+					reader_cv.wait(lock, [this]() {
+						return reader_stop || (track_stream.is_ready_to_write() && !stream_needs_reinit);
+					});
+					if (reader_stop) {
+						break;
+					}
+				}
+				bool has_more = stream_buffer_read(reader_abort);
+				{
+					std::lock_guard<std::mutex> lock(reader_mutex);
+					reader_eof = !has_more;
+				}
+				reader_cv.notify_all();
+				if (!has_more) {
+					break;
+				}
+			}
+		}
+		catch (exception_aborted&) {
+		}
+		catch (std::exception& e) {
+			console_printf("Error: DVD-Audio Decoder cannot read track data: %s", e.what());
+			{
+				std::lock_guard<std::mutex> lock(reader_mutex);
+				reader_eof = true;
+			}
+			reader_cv.notify_all();
+		}
+	}
+
+	// Blocks until the decoder has a whole access unit ahead, the stream is drained or the ring is full
+	void wait_reader(abort_callback& p_abort) {
+		std::unique_lock<std::mutex> lock(reader_mutex);
+		reader_cv.notify_all();
+		while (!(track_stream.get_read_size() >= audio_stream_t::MAX_CHUNK_SIZE || reader_eof || stream_needs_reinit || !track_stream.is_ready_to_write())) {
+			reader_cv.wait_for(lock, std::chrono::milliseconds(READER_POLL_MS));
+			p_abort.check();
+		}
+	}
+
+	void set_stream_id(int p_stream_id) {
+		std::lock_guard<std::mutex> lock(reader_mutex);
+		stream_ps1_info.header.stream_id = p_stream_id;
+	}
+
+	bool stream_buffer_read(abort_callback& p_abort) {
 		sub_header_t ps1_info;
 		int blocks_to_read, bytes_written = 0;
+		bool ps1_changed = false;
 		switch (media_type) {
 		case media_type_e::IFO_TYPE:
 		case media_type_e::ISO_TYPE:
@@ -703,42 +990,46 @@ private:
 				}
 				int blocks_read = dvda_zone->get_blocks(stream_titleset, stream_block_current, blocks_to_read, track_stream.get_write_ptr());
 				dvda_block_t::get_ps1(track_stream.get_write_ptr(), blocks_read, track_stream.get_write_ptr(), &bytes_written, &ps1_info);
-				if (stream_ps1_info.header.stream_id == UNK_STREAM_ID) {
-					stream_ps1_info = ps1_info;
+				{
+					std::lock_guard<std::mutex> lock(reader_mutex);
+					if (stream_ps1_info.header.stream_id == UNK_STREAM_ID) {
+						stream_ps1_info = ps1_info;
+					}
 				}
 				track_stream.move_write_ptr(bytes_written);
 				if (blocks_read < blocks_to_read) {
 					console_printf("Error: DVD-Audio Decoder cannot read track data: titleset = %d, block_number = %d, blocks_to_read = %d", stream_titleset, stream_block_current + blocks_read, blocks_to_read - blocks_read);
 				}
 				stream_block_current += blocks_to_read;
-				if (stream_block_current > audio_track.block_last) {
-					int blocks_after_last = dvda_zone->get_titleset(stream_titleset)->get_last() - audio_track.block_last;
-					int blocks_to_sync = blocks_after_last < 8 ? blocks_after_last : 8;
-					if (stream_block_current <= audio_track.block_last + blocks_to_sync) {
-						if (stream_block_current + blocks_to_read > audio_track.block_last + 1 + blocks_to_sync) {
-							blocks_to_read = audio_track.block_last + 1 + blocks_to_sync - stream_block_current;
-						}
-						int blocks_read = dvda_zone->get_blocks(stream_titleset, stream_block_current, blocks_to_read, track_stream.get_write_ptr());
-						bytes_written = 0;
-						dvda_block_t::get_ps1(track_stream.get_write_ptr(), blocks_read, track_stream.get_write_ptr(), &bytes_written, NULL);
-						if (audio_stream) {
-							int major_sync = audio_stream->resync(track_stream.get_write_ptr(), bytes_written);
-							if (major_sync > 0) {
-								track_stream.move_write_ptr(major_sync);
-							}
-						}
-						if (blocks_read < blocks_to_read) {
-							console_printf("Error: DVD-Audio Decoder cannot read track tail: titleset = %d, block_number = %d, blocks_to_read = %d", stream_titleset, stream_block_current + blocks_read, blocks_to_read - blocks_read);
+				return true;
+			}
+			else {
+				// append the head of the next track up to its first major sync, the last access unit may end there
+				int blocks_after_last = dvda_zone->get_titleset(stream_titleset)->get_last() - audio_track.block_last;
+				int blocks_to_sync = blocks_after_last < 8 ? blocks_after_last : 8;
+				if (stream_block_current <= audio_track.block_last + blocks_to_sync) {
+					if (stream_block_current + blocks_to_read > audio_track.block_last + 1 + blocks_to_sync) {
+						blocks_to_read = audio_track.block_last + 1 + blocks_to_sync - stream_block_current;
+					}
+					int blocks_read = dvda_zone->get_blocks(stream_titleset, stream_block_current, blocks_to_read, track_stream.get_write_ptr());
+					dvda_block_t::get_ps1(track_stream.get_write_ptr(), blocks_read, track_stream.get_write_ptr(), &bytes_written, NULL);
+					if (audio_track.audio_stream_info.stream_id == MLP_STREAM_ID) {
+						int major_sync = mlp_audio_stream_t::find_major_sync(track_stream.get_write_ptr(), bytes_written);
+						if (major_sync > 0) {
+							track_stream.move_write_ptr(major_sync);
 						}
-						stream_block_current += blocks_to_read;
 					}
+					if (blocks_read < blocks_to_read) {
+						console_printf("Error: DVD-Audio Decoder cannot read track tail: titleset = %d, block_number = %d, blocks_to_read = %d", stream_titleset, stream_block_current + blocks_read, blocks_to_read - blocks_read);
+					}
+					stream_block_current += blocks_to_read;
 				}
 			}
 			break;
 		case media_type_e::MLP_TYPE:
 			bytes_written = media_file->read(track_stream.get_write_ptr(), track_stream.get_write_size(), p_abort);
 			track_stream.move_write_ptr(bytes_written);
-			break;
+			return bytes_written > 0;
 		case media_type_e::AOB_TYPE:
 			blocks_to_read = track_stream.get_write_size() / DVD_BLOCK_SIZE;
 			if (stream_block_current <= audio_track.block_last) {
@@ -750,42 +1041,36 @@ private:
 				if (aob_cpxm_context.media_type > 0) {
 					dvdcpxm_decrypt(&aob_cpxm_context, track_stream.get_write_ptr(), blocks_read, DVDCPXM_RESET_CCI);
 				}
-				for (int block = 0; block < blocks_read; block++) {
-					int block_bytes_written = 0;
-					ps1_info.header.stream_id = UNK_STREAM_ID;
-					dvda_block_t::get_ps1(track_stream.get_write_ptr() + block * DVD_BLOCK_SIZE, track_stream.get_write_ptr() + bytes_written, &block_bytes_written, &ps1_info);
-					if (ps1_info.header.stream_id != UNK_STREAM_ID) {
-						if (stream_ps1_info.header.stream_id == UNK_STREAM_ID) {
-							stream_ps1_info = ps1_info;
-						}
-						if (
-							ps1_info.header.stream_id != stream_ps1_info.header.stream_id || (
-								ps1_info.header.stream_id == PCM_STREAM_ID && stream_ps1_info.header.stream_id == PCM_STREAM_ID && (
-									stream_ps1_info.extra_header.pcm.channel_assignment != ps1_info.extra_header.pcm.channel_assignment ||
-									stream_ps1_info.extra_header.pcm.group1_bits != ps1_info.extra_header.pcm.group1_bits ||
-									stream_ps1_info.extra_header.pcm.group1_samplerate != ps1_info.extra_header.pcm.group1_samplerate ||
-									stream_ps1_info.extra_header.pcm.group2_bits != ps1_info.extra_header.pcm.group2_bits ||
-									stream_ps1_info.extra_header.pcm.group2_samplerate != ps1_info.extra_header.pcm.group2_samplerate
-								)
-							)
-						) {
-							blocks_read = block;
-							if (media_file->can_seek()) {
-								media_file->seek((stream_block_current + blocks_read) * DVD_BLOCK_SIZE, p_abort);
-							}
-							stream_needs_reinit = true;
-							break;
-						}
-						bytes_written += block_bytes_written;
+				{
+					std::lock_guard<std::mutex> lock(reader_mutex);
+					ps1_info = stream_ps1_info;
+				}
+				int blocks_demuxed = dvda_block_t::get_ps1_stream(track_stream.get_write_ptr(), blocks_read, track_stream.get_write_ptr(), &bytes_written, &ps1_info);
+				{
+					std::lock_guard<std::mutex> lock(reader_mutex);
+					if (stream_ps1_info.header.stream_id == UNK_STREAM_ID) {
+						stream_ps1_info = ps1_info;
+					}
+				}
+				if (blocks_demuxed < blocks_read) {
+					blocks_read = blocks_demuxed;
+					if (media_file->can_seek()) {
+						media_file->seek((stream_block_current + blocks_read) * DVD_BLOCK_SIZE, p_abort);
 					}
+					ps1_changed = true;
 				}
 				track_stream_bytes_aob += aob_bytes_written;
 				track_stream_bytes_ps1 += bytes_written;
 				track_stream.move_write_ptr(bytes_written);
 				stream_block_current += blocks_read;
+				if (ps1_changed) {
+					stream_needs_reinit = true;
+				}
+				return aob_bytes_written > 0;
 			}
 			break;
 		}
+		return false;
 	}
 };
 
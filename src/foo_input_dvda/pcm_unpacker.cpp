@@ -0,0 +1,256 @@
+/*
+* DVD-Audio Decoder plugin
+* Copyright (c) 2009-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <algorithm>
+#include <tmmintrin.h>
+#include "../foo_input_sacd/cpu_features.h"
+#include "pcm_unpacker.h"
+
+pcm_unpacker_t::pcm_unpacker_t() {
+	unit_inp_size = unit_out_size = 0;
+	step_units = 1;
+	step_load_size = 0;
+	use_ssse3 = false;
+}
+
+// Lays out one unit the same way the per-sample unpacker did: the group packs hold both samples of a group pair,
+// the output takes sample 0 of group1 and group2, then sample 1 of both, and group2 is held for group2_factor pairs
+void pcm_unpacker_t::init(int group1_channels, int group1_bits, int group2_channels, int group2_bits, int group2_factor) {
+	int sample_size = group1_bits > 16 ? 4 : 2;
+	int raw_group1_size = group1_channels * group1_bits / 4;
+	int raw_group2_size = group2_channels * group2_bits / 4;
+	int pack1_size = 2 * group1_channels * sample_size;
+	int pack2_size = 2 * group2_channels * sample_size;
+	std::vector<map_entry_t> pack1(2 * group1_channels * 4);
+	std::vector<map_entry_t> pack2(2 * group2_channels * 4);
+	auto unpack_group = [](std::vector<map_entry_t>& pack, int channels, int bits, int base, bool is_group2, bool wide) {
+		int n = 0;
+		for (int i = 0; i < 2 * channels; i++) {
+			int lsb = base + 4 * channels + (bits == 20 ? i / 2 : i);
+			switch (bits) {
+			case 16:
+				if (is_group2 && wide) {
+					pack[n++] = { -1, op_e::ZERO };
+					pack[n++] = { -1, op_e::ZERO };
+				}
+				pack[n++] = { (int16_t)(base + 2 * i + 1), op_e::COPY };
+				pack[n++] = { (int16_t)(base + 2 * i), op_e::COPY };
+				break;
+			case 20:
+				pack[n++] = { -1, op_e::ZERO };
+				if (is_group2) {
+					pack[n++] = { (int16_t)lsb, (i % 2) ? op_e::LO_NIBBLE : op_e::SHR4 };
+				}
+				else {
+					pack[n++] = { (int16_t)lsb, (i % 2) ? op_e::SHL4 : op_e::HI_NIBBLE };
+				}
+				pack[n++] = { (int16_t)(base + 2 * i + 1), op_e::COPY };
+				pack[n++] = { (int16_t)(base + 2 * i), op_e::COPY };
+				break;
+			case 24:
+				pack[n++] = { -1, op_e::ZERO };
+				pack[n++] = { (int16_t)lsb, op_e::COPY };
+				pack[n++] = { (int16_t)(base + 2 * i + 1), op_e::COPY };
+				pack[n++] = { (int16_t)(base + 2 * i), op_e::COPY };
+				break;
+			default:
+				break;
+			}
+		}
+	};
+	if (group2_factor < 1) {
+		group2_factor = 1;
+	}
+	std::fill(pack2.begin(), pack2.end(), map_entry_t{ -1, op_e::ZERO });
+	unit_map.clear();
+	int inp_pos = 0;
+	for (int pair = 0; pair < group2_factor; pair++) {
+		if (pair == 0) {
+			unpack_group(pack2, group2_channels, group2_bits, inp_pos, true, group1_bits > 16);
+			inp_pos += raw_group2_size;
+		}
+		std::fill(pack1.begin(), pack1.end(), map_entry_t{ -1, op_e::ZERO });
+		unpack_group(pack1, group1_channels, group1_bits, inp_pos, false, group1_bits > 16);
+		inp_pos += raw_group1_size;
+		unit_map.insert(unit_map.end(), pack1.begin(), pack1.begin() + pack1_size / 2);
+		unit_map.insert(unit_map.end(), pack2.begin(), pack2.begin() + pack2_size / 2);
+		unit_map.insert(unit_map.end(), pack1.begin() + pack1_size / 2, pack1.begin() + pack1_size);
+		unit_map.insert(unit_map.end(), pack2.begin() + pack2_size / 2, pack2.begin() + pack2_size);
+	}
+	unit_inp_size = inp_pos;
+	unit_out_size = (int)unit_map.size();
+	use_ssse3 = false;
+	if (unit_inp_size > 0 && unit_out_size > 0 && cpu_features_t::has_ssse3()) {
+		build_ssse3();
+	}
+}
+
+// A step is the least number of units filling whole 16-byte vectors. Every output vector gathers its bytes from
+// up to MAX_WINDOWS 16-byte input windows, each with its own copy, shift left and shift right shuffles.
+void pcm_unpacker_t::build_ssse3() {
+	step_units = 1;
+	while ((step_units * unit_out_size) % 16 != 0) {
+		step_units++;
+	}
+	step_windows.clear();
+	step_vector_windows.clear();
+	step_load_size = 0;
+	for (int v = 0; v < step_units * unit_out_size / 16; v++) {
+		std::vector<int> srcs;
+		for (int k = 0; k < 16; k++) {
+			int j = 16 * v + k;
+			const map_entry_t& e = unit_map[j % unit_out_size];
+			if (e.op != op_e::ZERO) {
+				srcs.push_back((j / unit_out_size) * unit_inp_size + e.src);
+			}
+		}
+		std::sort(srcs.begin(), srcs.end());
+		int windows = 0;
+		for (size_t s = 0; s < srcs.size(); ) {
+			if (++windows > MAX_WINDOWS) {
+				return;
+			}
+			window_t w;
+			w.offset = srcs[s];
+			w.has_shl = w.has_shr = false;
+			for (int k = 0; k < 16; k++) {
+				w.copy_idx[k] = w.shl_idx[k] = w.shr_idx[k] = 0x80;
+				w.copy_mask[k] = 0x00;
+				int j = 16 * v + k;
+				const map_entry_t& e = unit_map[j % unit_out_size];
+				int src = (j / unit_out_size) * unit_inp_size + e.src;
+				if (e.op == op_e::ZERO || src < w.offset || src >= w.offset + 16) {
+					continue;
+				}
+				uint8_t idx = (uint8_t)(src - w.offset);
+				switch (e.op) {
+				case op_e::COPY:
+					w.copy_idx[k] = idx;
+					w.copy_mask[k] = 0xff;
+					break;
+				case op_e::HI_NIBBLE:
+					w.copy_idx[k] = idx;
+					w.copy_mask[k] = 0xf0;
+					break;
+				case op_e::LO_NIBBLE:
+					w.copy_idx[k] = idx;
+					w.copy_mask[k] = 0x0f;
+					break;
+				case op_e::SHL4:
+					w.shl_idx[k] = idx;
+					w.has_shl = true;
+					break;
+				case op_e::SHR4:
+					w.shr_idx[k] = idx;
+					w.has_shr = true;
+					break;
+				default:
+					break;
+				}
+			}
+			step_windows.push_back(w);
+			step_load_size = std::max(step_load_size, w.offset + 16);
+			while (s < srcs.size() && srcs[s] < w.offset + 16) {
+				s++;
+			}
+		}
+		step_vector_windows.push_back(windows);
+	}
+	step_load_size = std::max(step_load_size, step_units * unit_inp_size);
+	use_ssse3 = true;
+}
+
+// Returns the bytes consumed, only whole units are unpacked and *out_size goes in as capacity and out as bytes written
+int pcm_unpacker_t::unpack(const uint8_t* inp, int inp_size, uint8_t* out, int* out_size) {
+	if (unit_inp_size <= 0 || unit_out_size <= 0) {
+		*out_size = 0;
+		return 0;
+	}
+	int units = std::min(inp_size / unit_inp_size, *out_size / unit_out_size);
+	int units_done = 0;
+	if (use_ssse3) {
+		// the windows of the last steps may load past the input, those are left to the scalar loop
+		int steps = 0;
+		if (inp_size >= step_load_size) {
+			steps = std::min((inp_size - step_load_size) / (step_units * unit_inp_size) + 1, units / step_units);
+		}
+		units_done = unpack_ssse3(inp, steps, out);
+	}
+	unpack_scalar(inp + units_done * unit_inp_size, units - units_done, out + units_done * unit_out_size);
+	*out_size = units * unit_out_size;
+	return units * unit_inp_size;
+}
+
+int pcm_unpacker_t::unpack_ssse3(const uint8_t* inp, int steps, uint8_t* out) {
+	const __m128i nibble_hi = _mm_set1_epi8((char)0xf0);
+	const __m128i nibble_lo = _mm_set1_epi8(0x0f);
+	int step_inp_size = step_units * unit_inp_size;
+	int step_vectors = (int)step_vector_windows.size();
+	for (int step = 0; step < steps; step++) {
+		const window_t* w = step_windows.data();
+		for (int v = 0; v < step_vectors; v++) {
+			__m128i acc = _mm_setzero_si128();
+			for (int i = 0; i < step_vector_windows[v]; i++, w++) {
+				__m128i x = _mm_loadu_si128((const __m128i*)(inp + w->offset));
+				acc = _mm_or_si128(acc, _mm_and_si128(_mm_shuffle_epi8(x, _mm_loadu_si128((const __m128i*)w->copy_idx)), _mm_loadu_si128((const __m128i*)w->copy_mask)));
+				if (w->has_shl) {
+					acc = _mm_or_si128(acc, _mm_and_si128(_mm_slli_epi16(_mm_shuffle_epi8(x, _mm_loadu_si128((const __m128i*)w->shl_idx)), 4), nibble_hi));
+				}
+				if (w->has_shr) {
+					acc = _mm_or_si128(acc, _mm_and_si128(_mm_srli_epi16(_mm_shuffle_epi8(x, _mm_loadu_si128((const __m128i*)w->shr_idx)), 4), nibble_lo));
+				}
+			}
+			_mm_storeu_si128((__m128i*)(out + 16 * v), acc);
+		}
+		inp += step_inp_size;
+		out += 16 * step_vectors;
+	}
+	return steps * step_units;
+}
+
+void pcm_unpacker_t::unpack_scalar(const uint8_t* inp, int units, uint8_t* out) {
+	for (int unit = 0; unit < units; unit++) {
+		for (int j = 0; j < unit_out_size; j++) {
+			const map_entry_t& e = unit_map[j];
+			uint8_t b = e.src >= 0 ? inp[e.src] : 0;
+			switch (e.op) {
+			case op_e::COPY:
+				out[j] = b;
+				break;
+			case op_e::HI_NIBBLE:
+				out[j] = b & 0xf0;
+				break;
+			case op_e::LO_NIBBLE:
+				out[j] = b & 0x0f;
+				break;
+			case op_e::SHL4:
+				out[j] = (uint8_t)(b << 4);
+				break;
+			case op_e::SHR4:
+				out[j] = b >> 4;
+				break;
+			default:
+				out[j] = 0;
+				break;
+			}
+		}
+		inp += unit_inp_size;
+		out += unit_out_size;
+	}
+}
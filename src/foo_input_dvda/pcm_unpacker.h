@@ -0,0 +1,71 @@
+/*
+* DVD-Audio Decoder plugin
+* Copyright (c) 2009-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* DVD-Audio Decoder is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* DVD-Audio Decoder is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PCM_UNPACKER_H_INCLUDED
+#define _PCM_UNPACKER_H_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+// Unpacks DVD-Audio LPCM into little-endian 16-bit (group1 of 16 bits) or left-justified 32-bit samples. A unit is
+// group2 followed by group1 for every group1 pair sharing it, so units never depend on each other. The byte
+// layout of a unit is compiled once into a map of (source byte, operation) per output byte, the SSSE3 kernel
+// turns the map into pshufb windows and runs a whole buffer of units per call.
+class pcm_unpacker_t {
+	enum class op_e : uint8_t {
+		ZERO = 0,
+		COPY = 1,
+		HI_NIBBLE = 2, // b & 0xf0
+		LO_NIBBLE = 3, // b & 0x0f
+		SHL4 = 4,      // b << 4
+		SHR4 = 5       // b >> 4
+	};
+	typedef struct {
+		int16_t src;
+		op_e    op;
+	} map_entry_t;
+	typedef struct {
+		int     offset;
+		bool    has_shl;
+		bool    has_shr;
+		uint8_t copy_idx[16];
+		uint8_t copy_mask[16];
+		uint8_t shl_idx[16];
+		uint8_t shr_idx[16];
+	} window_t;
+	static constexpr int MAX_WINDOWS = 4;
+	std::vector<map_entry_t> unit_map;
+	int                      unit_inp_size;
+	int                      unit_out_size;
+	std::vector<window_t>    step_windows;
+	std::vector<int>         step_vector_windows;
+	int                      step_units;
+	int                      step_load_size;
+	bool                     use_ssse3;
+public:
+	pcm_unpacker_t();
+	void init(int group1_channels, int group1_bits, int group2_channels, int group2_bits, int group2_factor);
+	int unpack(const uint8_t* inp, int inp_size, uint8_t* out, int* out_size);
+private:
+	void build_ssse3();
+	int unpack_ssse3(const uint8_t* inp, int units, uint8_t* out);
+	void unpack_scalar(const uint8_t* inp, int units, uint8_t* out);
+};
+
+#endif
@@ -21,136 +21,151 @@
 #define _STREAM_BUFFER_H_INCLUDED
 
 #include <stdint.h>
+#include <atomic>
 
-template <class T, class I> class stream_buffer_t {
-	T*  bank[2];
-	int bank_id;
-	I bank_base;
-	I bank_size;
-	I min_read_size;
-	I avg_write_size;
-	T* read_ptr[2];
-	T* read_end[2];
-	bool banks_switched;
-	CRITICAL_SECTION bank_cs;
+// Ring buffer whose pages are mapped twice back to back, so any unread span is contiguous at get_read_ptr() and
+// any free span is contiguous at get_write_ptr() without copying tails around. Positions run modulo twice the
+// capacity to tell a full ring from an empty one. With spsc = false reader and writer are the same thread, with
+// spsc = true one thread may write while another reads, reinit() is then only safe with the writer stopped.
+// If the system refuses the mirrored mapping the ring falls back to a heap copy of twice the capacity and
+// duplicates every write into the other half.
+template <class T, class I, bool spsc = false> class stream_buffer_t {
+	static constexpr int MAP_ATTEMPTS = 8;
+	static constexpr std::memory_order load_order = spsc ? std::memory_order_acquire : std::memory_order_relaxed;
+	static constexpr std::memory_order store_order = spsc ? std::memory_order_release : std::memory_order_relaxed;
+	T*                  buffer;
+	HANDLE              mapping;
+	bool                mirrored;
+	size_t              capacity;
+	I                   avg_write_size;
+	std::atomic<size_t> read_pos;
+	std::atomic<size_t> write_pos;
 public:
 	stream_buffer_t(void) {
-		bank[0] = bank[1] = (T*)0;
-		bank_size = 0;
-		InitializeCriticalSection(&bank_cs);
+		buffer = (T*)0;
+		mapping = NULL;
+		mirrored = false;
+		capacity = 0;
+		read_pos = write_pos = 0;
 	}
 	~stream_buffer_t(void) {
-		DeleteCriticalSection(&bank_cs);
 		free();
 	}
 	bool init(I _bank_size, I _min_read_size, I _avg_write_size) {
 		free();
-		bank[0] = (T*)malloc((size_t)(_bank_size + _min_read_size) * sizeof(T));
-		bank[1] = (T*)malloc((size_t)(_bank_size + _min_read_size) * sizeof(T));
-		if (bank[0] == (T*)0 || bank[1] == (T*)0) {
-			free();
-			return false;
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		size_t granularity = si.dwAllocationGranularity;
+		size_t bytes = ((size_t)(_bank_size + _min_read_size) * sizeof(T) + granularity - 1) / granularity * granularity;
+		if (!map_mirrored(bytes)) {
+			buffer = (T*)malloc(2 * bytes);
+			if (buffer == (T*)0) {
+				return false;
+			}
 		}
-		bank_id = 0;
-		bank_base = _min_read_size;
-		bank_size = _bank_size;
-		min_read_size  = _min_read_size;
+		capacity = bytes / sizeof(T);
 		avg_write_size = _avg_write_size;
-		read_ptr[0] = read_end[0] = bank[0] + bank_base;
-		read_ptr[1] = read_end[1] = bank[1] + bank_base;
-		banks_switched = false;
- 		return true;
+		reinit();
+		return true;
 	}
 	void reinit() {
-		bank_id = 0;
-		read_ptr[0] = read_end[0] = bank[0] + bank_base;
-		read_ptr[1] = read_end[1] = bank[1] + bank_base;
+		read_pos.store(0, std::memory_order_relaxed);
+		write_pos.store(0, std::memory_order_relaxed);
 	}
 	void free(void) {
-		if (bank[0] != (T*)0) {
-			::free(bank[0]);
-			bank[0] = (T*)0;
+		if (buffer != (T*)0) {
+			if (mirrored) {
+				UnmapViewOfFile(buffer + capacity);
+				UnmapViewOfFile(buffer);
+			}
+			else {
+				::free(buffer);
+			}
+			buffer = (T*)0;
 		}
-		if (bank[1] != (T*)0) {
-			::free(bank[1]);
-			bank[1] = (T*)0;
+		if (mapping != NULL) {
+			CloseHandle(mapping);
+			mapping = NULL;
 		}
-		bank_size = 0;
-	}
-	int get_next_bank(int bank_id) {
-		return ~bank_id & 1;
+		mirrored = false;
+		capacity = 0;
 	}
 	I get_bank_size(void) {
-		return bank_size;
+		return (I)capacity;
+	}
+	bool is_mirrored() {
+		return mirrored;
 	}
 	T* get_read_ptr(void) {
-		return read_ptr[bank_id];
+		return buffer + read_pos.load(std::memory_order_relaxed) % capacity;
 	}
 	T* move_read_ptr(I size) {
-		T* new_ptr = (T*)0;
-		if (read_ptr[bank_id] + min_read_size + size <= read_end[bank_id])
-			read_ptr[bank_id] += size;
-		else {
-			int next_bank_id = get_next_bank(bank_id);
-			T* read_ptr_rest = read_ptr[bank_id] + size;
-			I read_size_rest = read_end[bank_id] - read_ptr_rest;
-			if (read_ptr[bank_id] + size < read_end[bank_id])
-				memcpy(bank[next_bank_id] + bank_base - read_size_rest, read_ptr[bank_id] + size, read_size_rest);
-			read_ptr[next_bank_id] = bank[next_bank_id] + bank_base - read_size_rest;
-			read_ptr[bank_id] = read_end[bank_id] = bank[bank_id] + bank_base;
-			switch_banks();
+		I read_size = get_read_size();
+		if (size > read_size) {
+			size = read_size;
 		}
-		new_ptr = read_ptr[bank_id];
-		return new_ptr;
+		read_pos.store((read_pos.load(std::memory_order_relaxed) + size) % (2 * capacity), store_order);
+		return get_read_ptr();
 	}
 	I get_read_size(void) {
-		I read_size;
-		read_size = read_end[bank_id] - read_ptr[bank_id];
-		return read_size;
-	}
-	I set_read_size(I size) {
-		I read_size = 0;
-		if (read_ptr[bank_id] + size <= bank[bank_id] + bank_base + bank_size) {
-			read_end[bank] = read_ptr[bank_id] + read_size; 
-			read_size = size;
-		}
-		return read_size;
+		return (I)((write_pos.load(load_order) + 2 * capacity - read_pos.load(std::memory_order_relaxed)) % (2 * capacity));
 	}
 	T* get_write_ptr(void) {
-		int bank_wr = get_next_bank(bank_id);
-		return read_end[bank_wr];
+		return buffer + write_pos.load(std::memory_order_relaxed) % capacity;
 	}
 	T* move_write_ptr(I size) {
-		T* new_ptr = (T*)0;
-		int bank_wr = get_next_bank(bank_id);
-		if (read_end[bank_wr] + size <= bank[bank_wr] + bank_base + bank_size) {
-			read_end[bank_wr] += size;
-			new_ptr = read_end[bank_wr];
+		size_t pos = write_pos.load(std::memory_order_relaxed);
+		if ((size_t)size > get_free_size()) {
+			return (T*)0;
+		}
+		if (!mirrored) {
+			size_t offset = pos % capacity;
+			size_t size_lo = offset + size <= capacity ? size : capacity - offset;
+			memcpy(buffer + capacity + offset, buffer + offset, size_lo * sizeof(T));
+			memcpy(buffer, buffer + capacity, (size - size_lo) * sizeof(T));
 		}
-		return new_ptr;
+		write_pos.store((pos + size) % (2 * capacity), store_order);
+		return get_write_ptr();
 	}
 	I get_write_size(void) {
-		I write_size;
-		int bank_wr = get_next_bank(bank_id);
-		write_size = bank[bank_wr] + bank_base + bank_size - read_end[bank_wr];
-		write_size = write_size < avg_write_size ? write_size : avg_write_size;
-		return write_size;
+		size_t write_size = get_free_size();
+		return (I)(write_size < (size_t)avg_write_size ? write_size : (size_t)avg_write_size);
 	}
 	bool is_ready_to_write() {
 		return avg_write_size <= get_write_size();
 	}
-	bool needs_data() {
-		if (banks_switched) {
-			banks_switched = false;
-			return true;
+private:
+	size_t get_free_size() {
+		size_t used_size = (write_pos.load(std::memory_order_relaxed) + 2 * capacity - read_pos.load(load_order)) % (2 * capacity);
+		return capacity - used_size;
+	}
+	bool map_mirrored(size_t bytes) {
+		mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, NULL);
+		if (mapping == NULL) {
+			return false;
+		}
+		for (int attempt = 0; attempt < MAP_ATTEMPTS; attempt++) {
+			// look up a hole for both views, another thread may take it before the views are in place
+			uint8_t* base = (uint8_t*)VirtualAlloc(NULL, 2 * bytes, MEM_RESERVE, PAGE_NOACCESS);
+			if (base == NULL) {
+				break;
+			}
+			VirtualFree(base, 0, MEM_RELEASE);
+			void* view_lo = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, base);
+			void* view_hi = view_lo ? MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, base + bytes) : NULL;
+			if (view_lo && view_hi) {
+				buffer = (T*)base;
+				mirrored = true;
+				return true;
+			}
+			if (view_lo) {
+				UnmapViewOfFile(view_lo);
+			}
 		}
+		CloseHandle(mapping);
+		mapping = NULL;
 		return false;
 	}
-private:
-	void switch_banks() {
-		bank_id = ~bank_id & 1;
-		banks_switched = true;
-	}
 };
 
 #endif
@@ -0,0 +1,59 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _CPU_FEATURES_H_INCLUDED
+#define _CPU_FEATURES_H_INCLUDED
+
+#include <intrin.h>
+
+class cpu_features_t {
+	bool m_ssse3;
+	bool m_sse41;
+	bool m_avx2;
+public:
+	cpu_features_t() {
+		int info[4];
+		__cpuid(info, 0);
+		auto max_leaf = info[0];
+		__cpuid(info, 1);
+		m_ssse3 = (info[2] & (1 << 9)) != 0;
+		m_sse41 = (info[2] & (1 << 19)) != 0;
+		auto os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+		m_avx2 = false;
+		if (os_avx && max_leaf >= 7) {
+			__cpuidex(info, 7, 0);
+			m_avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	}
+	static const cpu_features_t& get() {
+		static const cpu_features_t cpu_features;
+		return cpu_features;
+	}
+	static bool has_ssse3() {
+		return get().m_ssse3;
+	}
+	static bool has_sse41() {
+		return get().m_sse41;
+	}
+	static bool has_avx2() {
+		return get().m_avx2;
+	}
+};
+
+#endif
@@ -18,15 +18,98 @@
 */
 
 #include "dop_converter.h"
+#include "cpu_features.h"
+#include <tmmintrin.h>
 
 constexpr t_uint8 DoP_MARKER[2] = { 0x05, 0xFA };
 
+// pshufb masks placing LSB/MSB into bits 8..23 of an int32, a block always holds an even number of DoP samples
+// so the marker pattern of every block depends only on the starting phase
+class dop_pack_masks_t {
+public:
+	static constexpr int MAX_VECTORS = 3;
+	int block_samples[7];
+	int vectors[7];
+	int offset[7][MAX_VECTORS];
+	alignas(16) uint8_t mask[7][MAX_VECTORS][16];
+	alignas(16) uint32_t marker[7][2][MAX_VECTORS][4];
+	dop_pack_masks_t() {
+		memset(block_samples, 0, sizeof(block_samples));
+		memset(vectors, 0, sizeof(vectors));
+		memset(offset, 0, sizeof(offset));
+		memset(mask, 0x80, sizeof(mask));
+		memset(marker, 0, sizeof(marker));
+		init(2, 4);
+		init(6, 2);
+	}
+private:
+	void init(int channels, int samples) {
+		auto block_bytes = 2 * samples * channels;
+		block_samples[channels] = samples;
+		vectors[channels] = samples * channels / 4;
+		for (auto v = 0; v < vectors[channels]; v++) {
+			auto first_word = 4 * v;
+			auto first_byte = (2 * (first_word / channels)) * channels + first_word % channels;
+			offset[channels][v] = max(0, min(first_byte, block_bytes - 16));
+			for (auto i = 0; i < 4; i++) {
+				auto w = first_word + i;
+				auto sample = w / channels;
+				auto ch = w % channels;
+				mask[channels][v][4 * i + 1] = (uint8_t)((2 * sample + 1) * channels + ch - offset[channels][v]);
+				mask[channels][v][4 * i + 2] = (uint8_t)((2 * sample + 0) * channels + ch - offset[channels][v]);
+				for (auto phase = 0; phase < 2; phase++) {
+					marker[channels][phase][v][i] = (uint32_t)DoP_MARKER[(phase + sample) & 1] << 24;
+				}
+			}
+		}
+	}
+};
+
+static const dop_pack_masks_t g_dop_pack_masks;
+
+// Returns the number of DoP samples written, always a multiple of the block size
+static t_size dop_pack_ssse3(const t_uint8* p_inp_data, t_size p_out_samples, int p_channels, t_size p_phase, float* p_out_data) {
+	auto& m = g_dop_pack_masks;
+	auto block_samples = m.block_samples[p_channels];
+	auto vectors = m.vectors[p_channels];
+	if (block_samples == 0) {
+		return 0;
+	}
+	__m128i mask[dop_pack_masks_t::MAX_VECTORS];
+	__m128i marker[dop_pack_masks_t::MAX_VECTORS];
+	for (auto v = 0; v < vectors; v++) {
+		mask[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(m.mask[p_channels][v]));
+		marker[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(m.marker[p_channels][p_phase][v]));
+	}
+	const auto scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	t_size sample = 0;
+	for (; sample + block_samples <= p_out_samples; sample += block_samples) {
+		auto inp = p_inp_data + 2 * sample * p_channels;
+		auto out = p_out_data + sample * p_channels;
+		for (auto v = 0; v < vectors; v++) {
+			auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inp + m.offset[p_channels][v]));
+			auto word = _mm_or_si128(_mm_shuffle_epi8(data, mask[v]), marker[v]);
+			_mm_storeu_ps(out + 4 * v, _mm_mul_ps(_mm_cvtepi32_ps(word), scale));
+		}
+	}
+	return sample;
+}
+
 dop_converter_t::dop_converter_t() {
-	m_dop_marker_n.set_size(0);
-	m_dop_data.set_size(0);
+	m_dop_channels = 0;
+	m_dop_marker_n = 0;
+	m_carry = false;
+}
+
+// Drops the DSD byte held back for the next chunk, the stream does not continue
+void dop_converter_t::reset() {
+	m_carry = false;
 }
 
 void dop_converter_t::set_inp_spec(const t_samplespec& p_spec) {
+	if (p_spec != m_inp_spec) {
+		m_carry = false;
+	}
 	m_inp_spec = p_spec;
 }
 
@@ -34,32 +117,73 @@ void dop_converter_t::set_out_spec(const t_samplespec& p_spec) {
 	m_out_spec = p_spec;
 }
 
+t_samplespec dop_converter_t::get_dop_spec() const {
+	t_samplespec dop_spec;
+	dop_spec.m_sample_rate = m_inp_spec.m_sample_rate / 16;
+	dop_spec.m_channels = m_out_spec.m_channels;
+	dop_spec.m_channel_config = m_out_spec.m_channel_config;
+	return dop_spec;
+}
+
 void dop_converter_t::dsd_to_dop(const t_uint8* p_inp_data, t_size p_inp_samples, audio_chunk& p_out_chunk) {
-	unsigned out_samplerate = m_inp_spec.m_sample_rate / 16;
+	p_out_chunk.set_sample_count(0);
+	dsd_to_dop_append(p_inp_data, p_inp_samples, p_out_chunk);
+}
+
+// Encodes DoP words straight into the tail of p_out_chunk, which must be empty or already have get_dop_spec().
+// A DoP word takes two DSD bytes, an odd byte left at the chunk end is carried into the next chunk.
+void dop_converter_t::dsd_to_dop_append(const t_uint8* p_inp_data, t_size p_inp_samples, audio_chunk& p_out_chunk) {
+	auto dop_spec = get_dop_spec();
+	t_size inp_channels = m_inp_spec.m_channels;
+	t_size out_channels = dop_spec.m_channels;
+	t_size out_offset = p_out_chunk.get_sample_count();
+	t_size out_samples = ((m_carry ? 1 : 0) + p_inp_samples) / 2;
+	p_out_chunk.set_data_size((out_offset + out_samples) * out_channels);
+	auto out_data = p_out_chunk.get_data() + out_offset * out_channels;
+	if (m_carry && p_inp_samples > 0) {
+		memcpy(m_carry_data.data() + inp_channels, p_inp_data, inp_channels);
+		encode(m_carry_data.data(), 1, out_data);
+		out_data += out_channels;
+		p_inp_data += inp_channels;
+		p_inp_samples--;
+		m_carry = false;
+	}
+	encode(p_inp_data, p_inp_samples / 2, out_data);
+	if (p_inp_samples % 2) {
+		m_carry_data.resize(2 * inp_channels);
+		memcpy(m_carry_data.data(), p_inp_data + (p_inp_samples - 1) * inp_channels, inp_channels);
+		m_carry = true;
+	}
+	p_out_chunk.set_sample_rate(dop_spec.m_sample_rate);
+	p_out_chunk.set_channels(out_channels, dop_spec.m_channel_config);
+	p_out_chunk.set_sample_count(out_offset + out_samples);
+}
+
+void dop_converter_t::encode(const t_uint8* p_inp_data, t_size p_out_samples, audio_sample* p_out_data) {
+	constexpr audio_sample DoP_SCALE = (audio_sample)(1.0 / 0x800000);
 	t_size inp_channels = m_inp_spec.m_channels;
 	t_size out_channels = m_out_spec.m_channels;
-	t_size out_samples = p_inp_samples / 2;
-	t_size out_bytes = 3 * out_samples * out_channels;
-	m_dop_data.set_size(out_bytes);
-	t_uint8* dop_data = m_dop_data.get_ptr();
-	t_size o = 0;
-	if (m_dop_marker_n.get_size() != out_channels) {
-		m_dop_marker_n.set_size(out_channels);
-		for (t_size ch = 0; ch < m_dop_marker_n.get_size(); ch++) {
-			m_dop_marker_n[ch] = 0;
+	t_size sample = 0;
+	if (m_dop_channels != out_channels) {
+		m_dop_channels = out_channels;
+		m_dop_marker_n = 0;
+	}
+	if constexpr (sizeof(audio_sample) == sizeof(float)) {
+		if (inp_channels == out_channels && cpu_features_t::has_ssse3()) {
+			sample = dop_pack_ssse3(p_inp_data, p_out_samples, (int)out_channels, m_dop_marker_n, reinterpret_cast<float*>(p_out_data));
 		}
 	}
-	for (t_size sample = 0; sample < out_samples; sample++) {
+	t_size o = sample * out_channels;
+	for (; sample < p_out_samples; sample++) {
+		int32_t dop_marker = DoP_MARKER[(m_dop_marker_n + sample) & 1] << 16;
 		for (t_size ch = 0; ch < out_channels; ch++) {
 			t_uint8 b_msb, b_lsb;
 			b_msb = p_inp_data[(2 * sample + 0) * inp_channels + ch % inp_channels];
 			b_lsb = p_inp_data[(2 * sample + 1) * inp_channels + ch % inp_channels];
-			dop_data[o + 0] = b_lsb;
-			dop_data[o + 1] = b_msb;
-			dop_data[o + 2] = DoP_MARKER[m_dop_marker_n[ch]];
-			o += 3;
-			m_dop_marker_n[ch] = ++m_dop_marker_n[ch] & 1;
+			int32_t dop_word = dop_marker | (b_msb << 8) | b_lsb;
+			p_out_data[o] = (audio_sample)((dop_word ^ 0x800000) - 0x800000) * DoP_SCALE;
+			o++;
 		}
 	}
-	p_out_chunk.set_data_fixedpoint(dop_data, out_bytes, out_samplerate, out_channels, 24, m_out_spec.m_channel_config);
+	m_dop_marker_n = (m_dop_marker_n + p_out_samples) & 1;
 }
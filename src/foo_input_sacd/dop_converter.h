@@ -25,13 +25,20 @@
 class dop_converter_t {
 	t_samplespec     m_inp_spec;
 	t_samplespec     m_out_spec;
-	array_t<t_size>  m_dop_marker_n;
-	array_t<t_uint8> m_dop_data;
+	t_size           m_dop_channels;
+	t_size           m_dop_marker_n;
+	vector<t_uint8>  m_carry_data;
+	bool             m_carry;
 public:
 	dop_converter_t();
+	void reset();
 	void set_inp_spec(const t_samplespec& p_spec);
 	void set_out_spec(const t_samplespec& p_spec);
+	t_samplespec get_dop_spec() const;
 	void dsd_to_dop(const t_uint8* p_inp_data, t_size p_inp_samples, audio_chunk& p_out_chunk);
+	void dsd_to_dop_append(const t_uint8* p_inp_data, t_size p_inp_samples, audio_chunk& p_out_chunk);
+private:
+	void encode(const t_uint8* p_inp_data, t_size p_out_samples, audio_sample* p_out_data);
 };
 
 #endif
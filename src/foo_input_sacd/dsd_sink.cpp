@@ -0,0 +1,161 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "dsd_sink.h"
+
+dsd_framer_t::dsd_framer_t() {
+	for (int i = 0; i < 256; i++) {
+		m_swap_bits[i] = 0;
+		for (int j = 0; j < 8; j++) {
+			m_swap_bits[i] |= ((i >> j) & 1) << (7 - j);
+		}
+	}
+	m_pending_samples = 0;
+}
+
+void dsd_framer_t::set_format(const dsd_sink_format_t& p_format) {
+	m_format = p_format;
+	m_pending.set_size(m_format.channels * m_format.get_word_size());
+	m_pending_samples = 0;
+}
+
+const dsd_sink_format_t& dsd_framer_t::get_format() const {
+	return m_format;
+}
+
+// Returns words per channel, samples not filling a whole word are kept for the next call
+const t_uint8* dsd_framer_t::frame(const t_uint8* p_inp_data, t_size p_inp_samples, t_size* p_out_words) {
+	auto channels = m_format.channels;
+	auto word_size = m_format.get_word_size();
+	*p_out_words = 0;
+	if (channels == 0 || word_size == 0) {
+		return nullptr;
+	}
+	auto words = (m_pending_samples + p_inp_samples) / word_size;
+	m_frame_data.set_size(words * word_size * channels);
+	auto out_data = m_frame_data.get_ptr();
+	if (m_pending_samples > 0) {
+		auto fill_samples = min(word_size - m_pending_samples, p_inp_samples);
+		memcpy(m_pending.get_ptr() + m_pending_samples * channels, p_inp_data, fill_samples * channels);
+		m_pending_samples += fill_samples;
+		p_inp_data += fill_samples * channels;
+		p_inp_samples -= fill_samples;
+		if (m_pending_samples < word_size) {
+			return out_data;
+		}
+		pack_words(m_pending.get_ptr(), 1, out_data);
+		out_data += word_size * channels;
+		m_pending_samples = 0;
+	}
+	auto inp_words = p_inp_samples / word_size;
+	pack_words(p_inp_data, inp_words, out_data);
+	m_pending_samples = p_inp_samples - inp_words * word_size;
+	memcpy(m_pending.get_ptr(), p_inp_data + inp_words * word_size * channels, m_pending_samples * channels);
+	*p_out_words = words;
+	return m_frame_data.get_ptr();
+}
+
+void dsd_framer_t::reset() {
+	m_pending_samples = 0;
+}
+
+void dsd_framer_t::pack_words(const t_uint8* p_inp_data, t_size p_words, t_uint8* p_out_data) {
+	auto channels = m_format.channels;
+	auto word_size = m_format.get_word_size();
+	auto lsb_first = m_format.lsb_first;
+	auto reverse_bytes = (word_size > 1) && (m_format.lsb_first == m_format.big_endian);
+	if (word_size == 1 && !lsb_first) {
+		memcpy(p_out_data, p_inp_data, p_words * channels);
+		return;
+	}
+	for (t_size word = 0; word < p_words; word++) {
+		auto inp = p_inp_data + word * word_size * channels;
+		auto out = p_out_data + word * word_size * channels;
+		for (t_size ch = 0; ch < channels; ch++) {
+			for (t_size b = 0; b < word_size; b++) {
+				auto value = inp[b * channels + ch];
+				out[ch * word_size + (reverse_bytes ? word_size - 1 - b : b)] = lsb_first ? m_swap_bits[value] : value;
+			}
+		}
+	}
+}
+
+dsd_sink_file_t::dsd_sink_file_t(const char* p_path, unsigned p_word_bits, bool p_lsb_first, bool p_big_endian) {
+	m_path = p_path;
+	m_native_format.word_bits = (p_word_bits == 16 || p_word_bits == 32) ? p_word_bits : 8;
+	m_native_format.lsb_first = p_lsb_first;
+	m_native_format.big_endian = p_big_endian;
+}
+
+dsd_sink_file_t::~dsd_sink_file_t() {
+	close();
+}
+
+const char* dsd_sink_file_t::get_name() {
+	return "DSD File Sink";
+}
+
+void dsd_sink_file_t::get_native_format(dsd_sink_format_t& p_format) {
+	p_format.word_bits = m_native_format.word_bits;
+	p_format.lsb_first = m_native_format.lsb_first;
+	p_format.big_endian = m_native_format.big_endian;
+}
+
+bool dsd_sink_file_t::open(const dsd_sink_format_t& p_format) {
+	close();
+	try {
+		filesystem::g_open_write_new(m_file, m_path, m_abort);
+	}
+	catch (std::exception& e) {
+		console::printf("dsd_sink_file::open() => Cannot open \"%s\": %s", m_path.c_str(), e.what());
+		m_file.release();
+		return false;
+	}
+	m_format = p_format;
+	console::printf("dsd_sink_file::open() => \"%s\" [channels = %d, samplerate = %d, word_bits = %d, bit_order = %s, byte_order = %s]",
+		m_path.c_str(), m_format.channels, m_format.samplerate, m_format.word_bits, m_format.lsb_first ? "LSB first" : "MSB first", m_format.big_endian ? "BE" : "LE"
+	);
+	return true;
+}
+
+void dsd_sink_file_t::close() {
+	if (m_file.is_valid()) {
+		console::printf("dsd_sink_file::close() => \"%s\"", m_path.c_str());
+		m_file.release();
+	}
+}
+
+bool dsd_sink_file_t::is_open() {
+	return m_file.is_valid();
+}
+
+void dsd_sink_file_t::write(const t_uint8* p_data, t_size p_words) {
+	if (m_file.is_valid() && p_words > 0) {
+		try {
+			m_file->write_object(p_data, p_words * m_format.get_word_size() * m_format.channels, m_abort);
+		}
+		catch (std::exception& e) {
+			console::printf("dsd_sink_file::write() => %s", e.what());
+			m_file.release();
+		}
+	}
+}
+
+void dsd_sink_file_t::flush() {
+}
@@ -0,0 +1,94 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _DSD_SINK_H_INCLUDED
+#define _DSD_SINK_H_INCLUDED
+
+#include "sacd_config.h"
+
+// Native DSD framing: every channel word carries word_bits consecutive 1-bit samples
+class dsd_sink_format_t {
+public:
+	t_size   channels = 0;
+	unsigned samplerate = 0;
+	unsigned channel_config = 0;
+	unsigned word_bits = 8;
+	bool     lsb_first = false;
+	bool     big_endian = false;
+	t_size get_word_size() const {
+		return word_bits / 8;
+	}
+	bool operator==(const dsd_sink_format_t& p_format) const {
+		return channels == p_format.channels && samplerate == p_format.samplerate && channel_config == p_format.channel_config && word_bits == p_format.word_bits && lsb_first == p_format.lsb_first && big_endian == p_format.big_endian;
+	}
+	bool operator!=(const dsd_sink_format_t& p_format) const {
+		return !(*this == p_format);
+	}
+};
+
+// Device receiving raw 1-bit DSD instead of DoP encoded PCM
+class dsd_sink_t {
+public:
+	virtual ~dsd_sink_t() {}
+	virtual const char* get_name() = 0;
+	virtual void get_native_format(dsd_sink_format_t& p_format) = 0;
+	virtual bool open(const dsd_sink_format_t& p_format) = 0;
+	virtual void close() = 0;
+	virtual bool is_open() = 0;
+	virtual void write(const t_uint8* p_data, t_size p_words) = 0;
+	virtual void flush() = 0;
+};
+
+// Packs the byte interleaved MSB first DSD of dsd_stream_service into sink words
+class dsd_framer_t {
+	dsd_sink_format_t m_format;
+	t_uint8           m_swap_bits[256];
+	array_t<t_uint8>  m_pending;
+	t_size            m_pending_samples;
+	array_t<t_uint8>  m_frame_data;
+public:
+	dsd_framer_t();
+	void set_format(const dsd_sink_format_t& p_format);
+	const dsd_sink_format_t& get_format() const;
+	const t_uint8* frame(const t_uint8* p_inp_data, t_size p_inp_samples, t_size* p_out_words);
+	void reset();
+private:
+	void pack_words(const t_uint8* p_inp_data, t_size p_words, t_uint8* p_out_data);
+};
+
+// Stand-in device writing the framed stream into a raw file
+class dsd_sink_file_t : public dsd_sink_t {
+	string8             m_path;
+	dsd_sink_format_t   m_native_format;
+	dsd_sink_format_t   m_format;
+	file_ptr            m_file;
+	abort_callback_impl m_abort;
+public:
+	dsd_sink_file_t(const char* p_path, unsigned p_word_bits, bool p_lsb_first, bool p_big_endian);
+	virtual ~dsd_sink_file_t();
+	virtual const char* get_name();
+	virtual void get_native_format(dsd_sink_format_t& p_format);
+	virtual bool open(const dsd_sink_format_t& p_format);
+	virtual void close();
+	virtual bool is_open();
+	virtual void write(const t_uint8* p_data, t_size p_words);
+	virtual void flush();
+};
+
+#endif
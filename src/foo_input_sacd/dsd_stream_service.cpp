@@ -52,6 +52,14 @@ const t_uint8* dsd_chunk_t::get_data() const {
 	return m_buffer.get_ptr();
 }
 
+void dsd_chunk_t::set_data(const t_uint8* p_buffer, t_size p_samples, const t_samplespec& p_spec) {
+	m_spec = p_spec;
+	m_buffer.set_size(p_samples * m_spec.m_channels);
+	if (m_buffer.get_count() > 0) {
+		memcpy(m_buffer.get_ptr(), p_buffer, m_buffer.get_count());
+	}
+}
+
 void dsd_chunk_t::append_data(const t_uint8* p_buffer, t_size p_samples, const t_samplespec& p_spec) {
 	m_spec = p_spec;
 	m_buffer.append_fromptr(p_buffer, p_samples * m_spec.m_channels);
@@ -34,9 +34,29 @@ public:
 	t_size get_size() const;
 	const array_t<t_uint8>& get_buffer() const;
 	const t_uint8* get_data() const;
+	void set_data(const t_uint8* p_buffer, t_size p_samples, const t_samplespec& p_spec);
 	void append_data(const t_uint8* p_buffer, t_size p_samples, const t_samplespec& p_spec);
 };
 
+// Borrowed view of the first stream chunk, valid until the chunk is removed or the stream is flushed
+class dsd_chunk_view_t {
+public:
+	t_samplespec   spec;
+	const t_uint8* data = nullptr;
+	t_size         samples = 0;
+};
+
+class dsd_stream_stats_t {
+public:
+	t_size capacity = 0;   // ring size in bytes, grows with the DSD rate and channel count
+	t_size fill = 0;       // bytes queued at the moment of the query
+	t_size peak_fill = 0;  // highest fill level since the last flush
+	t_size underruns = 0;  // consumer asked for DSD while the stream was empty
+	t_size overruns = 0;   // frames dropped because the stream was full
+	t_size copied = 0;     // bytes copied out by get_first_chunk() and read()
+	t_size borrowed = 0;   // bytes handed out in place by peek_first_chunk()
+};
+
 class dsd_stream_service : public service_base {
 public:
 	virtual bool is_streaming() const = 0;
@@ -49,10 +69,12 @@ public:
 	virtual bool is_spec_change() const = 0;
 	virtual void reset_spec_change() = 0;
 	virtual const dsd_chunk_t& get_first_chunk() const = 0;
+	virtual bool peek_first_chunk(dsd_chunk_view_t& p_view) const = 0;
 	virtual void remove_first_chunk() = 0;
 	virtual t_size read(t_uint8* p_buffer, t_size p_samples) = 0;
 	virtual void write(const t_uint8* p_buffer, t_size p_samples, t_size p_channels, unsigned p_samplerate, unsigned p_channel_config) = 0;
 	virtual void flush() = 0;
+	virtual void get_stats(dsd_stream_stats_t& p_stats) const = 0;
 	FB2K_MAKE_SERVICE_INTERFACE_ENTRYPOINT(dsd_stream_service);
 };
 
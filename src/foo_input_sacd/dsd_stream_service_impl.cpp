@@ -19,9 +19,23 @@
 
 #include "dsd_stream_service_impl.h"
 
+static inline t_size get_record_size(t_size p_size) {
+	return (sizeof(dsd_record_t) + p_size + DSD_STREAM_RECORD_ALIGN - 1) & ~(DSD_STREAM_RECORD_ALIGN - 1);
+}
+
 dsd_stream_service_impl::dsd_stream_service_impl() {
-	m_chunk_read_samples = 0;
+	m_ring_data = nullptr;
+	m_ring_size = 0;
+	m_write_pos = 0;
+	m_read_pos = 0;
+	m_chunks = 0;
 	m_samples = 0;
+	m_peak_fill = 0;
+	m_underruns = 0;
+	m_overruns = 0;
+	m_copied = 0;
+	m_borrowed = 0;
+	m_chunk_read_samples = 0;
 	m_streaming = 0;
 	m_accept_data = false;
 }
@@ -39,27 +53,25 @@ void dsd_stream_service_impl::set_streaming(bool p_streaming) {
 }
 
 bool dsd_stream_service_impl::is_accept_data() const {
-	return m_accept_data;
+	return m_accept_data.load(memory_order_acquire);
 }
 
 void dsd_stream_service_impl::set_accept_data(bool p_accept) {
-	m_accept_data = p_accept;
+	m_accept_data.store(p_accept, memory_order_release);
 }
 
 t_size dsd_stream_service_impl::get_chunk_count() const {
-	return m_chunks.get_count();
+	return m_chunks.load(memory_order_acquire);
 }
 
 t_size dsd_stream_service_impl::get_sample_count() const {
-	return m_samples;
+	return m_samples.load(memory_order_acquire);
 }
 
 t_samplespec dsd_stream_service_impl::get_spec() const {
-	lock_guard<mutex> lock(m_chunks_mutex);
 	t_samplespec spec;
-	auto chunk_iter = m_chunks.first();
-	if (chunk_iter.is_valid()) {
-		spec = chunk_iter->get_spec();
+	if (peek_record()) {
+		spec = m_read_spec;
 	}
 	return spec;
 }
@@ -73,72 +85,195 @@ void dsd_stream_service_impl::reset_spec_change() {
 }
 
 const dsd_chunk_t& dsd_stream_service_impl::get_first_chunk() const {
-	lock_guard<mutex> lock(m_chunks_mutex);
-	auto chunk_iter = m_chunks.first();
-	return chunk_iter.is_valid() ? *chunk_iter : m_null_chunk;
+	auto record = peek_record();
+	if (record) {
+		auto record_channels = m_read_spec.m_channels;
+		auto record_samples = record->size / record_channels;
+		m_first_chunk.set_data(reinterpret_cast<const t_uint8*>(record + 1) + m_chunk_read_samples * record_channels, record_samples - m_chunk_read_samples, m_read_spec);
+		m_copied += m_first_chunk.get_size();
+	}
+	else {
+		m_first_chunk.set_data(nullptr, 0, m_read_spec);
+		m_underruns++;
+	}
+	return m_first_chunk;
+}
+
+bool dsd_stream_service_impl::peek_first_chunk(dsd_chunk_view_t& p_view) const {
+	auto record = peek_record();
+	if (!record) {
+		p_view = dsd_chunk_view_t();
+		m_underruns++;
+		return false;
+	}
+	auto record_channels = m_read_spec.m_channels;
+	p_view.spec = m_read_spec;
+	p_view.data = reinterpret_cast<const t_uint8*>(record + 1) + m_chunk_read_samples * record_channels;
+	p_view.samples = record->size / record_channels - m_chunk_read_samples;
+	m_borrowed += p_view.samples * record_channels;
+	return true;
 }
 
 void dsd_stream_service_impl::remove_first_chunk() {
-	lock_guard<mutex> lock(m_chunks_mutex);
-	auto chunk_iter = m_chunks.first();
-	if (chunk_iter.is_valid()) {
-		m_samples -= chunk_iter->get_sample_count();
-		m_chunks.remove(chunk_iter);
+	auto record = peek_record();
+	if (record) {
+		m_samples -= record->size / m_read_spec.m_channels - m_chunk_read_samples;
+		m_chunk_read_samples = 0;
+		skip_record();
+		m_chunks--;
 	}
 }
 
 t_size dsd_stream_service_impl::read(t_uint8* p_buffer, t_size p_samples) {
-	lock_guard<mutex> lock(m_chunks_mutex);
 	t_size read_samples = 0;
-	while (m_chunks.get_count() > 0) {
-		auto chunk_iter = m_chunks.first();
-		t_samplespec chunk_spec = chunk_iter->get_spec();
-		if (chunk_spec != m_last_read_spec) {
+	while (read_samples < p_samples) {
+		auto record = peek_record();
+		if (!record) {
+			m_underruns++;
 			break;
 		}
-		auto chunk_data = chunk_iter->get_data();
-		t_size chunk_samples = chunk_iter->get_sample_count();
-		unsigned chunk_channels = chunk_iter->get_channels();
-		t_size samples_to_read = p_samples - read_samples;
-		if (chunk_samples - m_chunk_read_samples > samples_to_read) {
-			memcpy(p_buffer + read_samples * chunk_channels, chunk_data + m_chunk_read_samples * chunk_channels, samples_to_read * chunk_channels);
-			m_chunk_read_samples += samples_to_read;
-			read_samples += samples_to_read;
-			m_samples -= samples_to_read;
+		if (m_read_spec != m_last_read_spec) {
+			break;
 		}
-		else {
-			memcpy(p_buffer + read_samples * chunk_channels, chunk_data + m_chunk_read_samples * chunk_channels, (chunk_samples - m_chunk_read_samples) * chunk_channels);
-			m_chunks.remove(chunk_iter);
-			read_samples += chunk_samples - m_chunk_read_samples;
-			m_samples -= chunk_samples - m_chunk_read_samples;
+		auto chunk_data = reinterpret_cast<const t_uint8*>(record + 1);
+		auto chunk_channels = m_read_spec.m_channels;
+		t_size chunk_samples = record->size / chunk_channels;
+		t_size samples_to_read = min(p_samples - read_samples, chunk_samples - m_chunk_read_samples);
+		memcpy(p_buffer + read_samples * chunk_channels, chunk_data + m_chunk_read_samples * chunk_channels, samples_to_read * chunk_channels);
+		m_chunk_read_samples += samples_to_read;
+		m_copied += samples_to_read * chunk_channels;
+		read_samples += samples_to_read;
+		m_samples -= samples_to_read;
+		if (m_chunk_read_samples == chunk_samples) {
 			m_chunk_read_samples = 0;
-		}
-		if (p_samples <= read_samples) {
-			break;
+			skip_record();
+			m_chunks--;
 		}
 	}
 	return read_samples;
 }
 
 void dsd_stream_service_impl::write(const t_uint8* p_buffer, t_size p_samples, t_size p_channels, unsigned p_samplerate, unsigned p_channel_config) {
-	lock_guard<mutex> lock(m_chunks_mutex);
-	if (m_accept_data) {
-		bool appended = false;
-		t_samplespec write_spec;
-		write_spec.m_channels = p_channels;
-		write_spec.m_sample_rate = p_samplerate;
-		write_spec.m_channel_config = p_channel_config;
-		m_chunks.add_item(dsd_chunk_t());
-		m_chunks.last()->append_data(p_buffer, p_samples, write_spec);
-		m_samples += p_samples;
+	if (!m_accept_data.load(memory_order_acquire) || p_samples == 0 || p_channels == 0) {
+		return;
+	}
+	t_samplespec write_spec;
+	write_spec.m_channels = p_channels;
+	write_spec.m_sample_rate = p_samplerate;
+	write_spec.m_channel_config = p_channel_config;
+	auto read_pos = m_read_pos.load(memory_order_acquire);
+	auto write_pos = m_write_pos.load(memory_order_relaxed);
+	fit_ring(write_spec, write_pos, read_pos);
+	if (write_spec != m_write_spec) {
+		auto marker = reserve_record(write_pos, read_pos, dsd_record_type_e::SPEC, 0);
+		if (!marker) {
+			m_overruns++;
+			return;
+		}
+		marker->channels = p_channels;
+		marker->channel_config = p_channel_config;
+		marker->sample_rate = p_samplerate;
+	}
+	auto record = reserve_record(write_pos, read_pos, dsd_record_type_e::DATA, p_samples * p_channels);
+	if (!record) {
+		m_overruns++;
+		return;
+	}
+	memcpy(record + 1, p_buffer, p_samples * p_channels);
+	m_write_spec = write_spec;
+	m_samples += p_samples;
+	m_chunks++;
+	m_write_pos.store(write_pos, memory_order_release);
+	auto fill = (t_size)(write_pos - read_pos);
+	if (fill > m_peak_fill.load(memory_order_relaxed)) {
+		m_peak_fill.store(fill, memory_order_relaxed);
 	}
 }
 
 void dsd_stream_service_impl::flush() {
-	lock_guard<mutex> lock(m_chunks_mutex);
-	m_chunks.remove_all();
-	m_chunk_read_samples = 0;
-	m_samples = 0;
+	while (peek_record()) {
+		remove_first_chunk();
+	}
+	m_peak_fill = 0;
+}
+
+void dsd_stream_service_impl::get_stats(dsd_stream_stats_t& p_stats) const {
+	p_stats.capacity = m_ring_size.load(memory_order_acquire);
+	p_stats.fill = (t_size)(m_write_pos.load(memory_order_acquire) - m_read_pos.load(memory_order_acquire));
+	p_stats.peak_fill = m_peak_fill;
+	p_stats.underruns = m_underruns;
+	p_stats.overruns = m_overruns;
+	p_stats.copied = m_copied;
+	p_stats.borrowed = m_borrowed;
+}
+
+// Allocates and grows the ring on the producer thread only, and only while it is empty: the consumer then
+// holds no record and only looks at the ring again after the write position that follows the new buffer
+void dsd_stream_service_impl::fit_ring(const t_samplespec& p_spec, uint64_t p_write_pos, uint64_t p_read_pos) {
+	auto stream_size = (t_size)(p_spec.m_sample_rate / 8) * p_spec.m_channels * DSD_STREAM_RING_SECONDS;
+	auto ring_size = DSD_STREAM_RING_SIZE;
+	while (ring_size < stream_size) {
+		ring_size *= 2;
+	}
+	if (ring_size <= m_ring.size() || p_write_pos != p_read_pos) {
+		return;
+	}
+	vector<uint8_t> ring(ring_size);
+	m_ring.swap(ring);
+	m_ring_data.store(m_ring.data(), memory_order_release);
+	m_ring_size.store(m_ring.size(), memory_order_release);
+}
+
+dsd_record_t* dsd_stream_service_impl::reserve_record(uint64_t& p_write_pos, uint64_t p_read_pos, dsd_record_type_e p_type, t_size p_size) {
+	auto record_size = get_record_size(p_size);
+	auto offset = (t_size)(p_write_pos & (m_ring.size() - 1));
+	auto pad_size = (offset + record_size > m_ring.size()) ? m_ring.size() - offset : 0;
+	if (p_write_pos + pad_size + record_size - p_read_pos > m_ring.size()) {
+		return nullptr;
+	}
+	if (pad_size > 0) {
+		auto pad = reinterpret_cast<dsd_record_t*>(m_ring.data() + offset);
+		pad->type = dsd_record_type_e::PAD;
+		pad->size = (uint32_t)(pad_size - sizeof(dsd_record_t));
+		p_write_pos += pad_size;
+		offset = 0;
+	}
+	auto record = reinterpret_cast<dsd_record_t*>(m_ring.data() + offset);
+	record->type = p_type;
+	record->size = (uint32_t)p_size;
+	p_write_pos += record_size;
+	return record;
+}
+
+// Returns the first data record, spec markers on the way update the read spec
+const dsd_record_t* dsd_stream_service_impl::peek_record() const {
+	auto write_pos = m_write_pos.load(memory_order_acquire);
+	while (m_read_pos.load(memory_order_relaxed) != write_pos) {
+		auto ring_data = m_ring_data.load(memory_order_acquire);
+		auto ring_size = m_ring_size.load(memory_order_acquire);
+		auto record = reinterpret_cast<const dsd_record_t*>(ring_data + (m_read_pos.load(memory_order_relaxed) & (ring_size - 1)));
+		switch (record->type) {
+		case dsd_record_type_e::DATA:
+			return record;
+		case dsd_record_type_e::SPEC:
+			m_read_spec.m_channels = record->channels;
+			m_read_spec.m_channel_config = record->channel_config;
+			m_read_spec.m_sample_rate = record->sample_rate;
+			break;
+		default:
+			break;
+		}
+		skip_record();
+	}
+	return nullptr;
+}
+
+void dsd_stream_service_impl::skip_record() const {
+	auto read_pos = m_read_pos.load(memory_order_relaxed);
+	auto ring_data = m_ring_data.load(memory_order_acquire);
+	auto ring_size = m_ring_size.load(memory_order_acquire);
+	auto record = reinterpret_cast<const dsd_record_t*>(ring_data + (read_pos & (ring_size - 1)));
+	m_read_pos.store(read_pos + get_record_size(record->size), memory_order_release);
 }
 
 static service_factory_single_t<dsd_stream_service_impl> g_dsd_stream_service_factory;
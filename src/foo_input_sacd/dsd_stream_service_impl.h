@@ -20,21 +20,54 @@
 #ifndef _DSD_STREAM_SERVICE_IMPL_H_INCLUDED
 #define _DSD_STREAM_SERVICE_IMPL_H_INCLUDED
 
-#include <mutex>
+#include <atomic>
 #include "dsd_stream_service.h"
 
-using std::mutex;
-using std::lock_guard;
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
 
+constexpr t_size DSD_STREAM_RING_SIZE = 16 * 1024 * 1024; // power of two, the smallest ring
+constexpr t_size DSD_STREAM_RING_SECONDS = 2; // ring grows to hold this much of the incoming DSD stream
+enum class dsd_record_type_e : uint32_t { DATA, SPEC, PAD };
+
+// Every record starts on a DSD_STREAM_RECORD_ALIGN boundary and never wraps around the ring end
+class dsd_record_t {
+public:
+	dsd_record_type_e type;
+	uint32_t size;
+	uint32_t channels;
+	uint32_t channel_config;
+	uint32_t sample_rate;
+	uint32_t reserved[3];
+};
+
+// Records are whole headers long, so the tail left at the ring end always has room for a PAD header
+constexpr t_size DSD_STREAM_RECORD_ALIGN = sizeof(dsd_record_t);
+
+// Single producer (decoder thread), single consumer (output thread) DSD stream.
+// The producer cannot block on a full ring, both ends may run on the playback thread, so the ring is sized from the stream instead
 class dsd_stream_service_impl : public dsd_stream_service {
-	mutable mutex m_chunks_mutex;
-	dsd_chunk_t m_null_chunk;
-	chain_list_v2_t<dsd_chunk_t> m_chunks;
+	vector<uint8_t> m_ring;
+	atomic<uint8_t*> m_ring_data;
+	atomic<t_size> m_ring_size;
+	atomic<uint64_t> m_write_pos;
+	mutable atomic<uint64_t> m_read_pos;
+	atomic<t_size> m_chunks;
+	atomic<t_size> m_samples;
+	atomic<t_size> m_peak_fill;
+	mutable atomic<t_size> m_underruns;
+	atomic<t_size> m_overruns;
+	mutable atomic<t_size> m_copied;
+	mutable atomic<t_size> m_borrowed;
+	t_samplespec m_write_spec;
+	mutable t_samplespec m_read_spec;
+	mutable dsd_chunk_t m_first_chunk;
 	t_size m_chunk_read_samples;
-	t_size m_samples;
 	t_samplespec m_last_read_spec;
 	int m_streaming;
-	bool m_accept_data;
+	atomic<bool> m_accept_data;
 public:
 	dsd_stream_service_impl();
 	virtual ~dsd_stream_service_impl();
@@ -48,10 +81,17 @@ public:
 	virtual bool is_spec_change() const;
 	virtual void reset_spec_change();
 	virtual const dsd_chunk_t& get_first_chunk() const;
+	virtual bool peek_first_chunk(dsd_chunk_view_t& p_view) const;
 	virtual void remove_first_chunk();
 	virtual t_size read(t_uint8* p_buffer, t_size p_samples);
 	virtual void write(const t_uint8* p_buffer, t_size p_samples, t_size p_channels, unsigned p_samplerate, unsigned p_channel_config);
 	virtual void flush();
+	virtual void get_stats(dsd_stream_stats_t& p_stats) const;
+private:
+	void fit_ring(const t_samplespec& p_spec, uint64_t p_write_pos, uint64_t p_read_pos);
+	dsd_record_t* reserve_record(uint64_t& p_write_pos, uint64_t p_read_pos, dsd_record_type_e p_type, t_size p_size);
+	const dsd_record_t* peek_record() const;
+	void skip_record() const;
 };
 
 #endif
@@ -21,13 +21,17 @@
 #include "dop_converter.h"
 #include "dsd_stream_service.h"
 #include "dst_decoder_mt.h"
+#include "pcm_post_processor.h"
+#include "pcm_loudness_meter.h"
+#include "sacd_pipeline.h"
+#include "sacd_toc_cache.h"
 #include "DSDPCMConverterEngine.h"
 #include "std_wavpack.h"
 #include <psapi.h>
 
 constexpr int UPDATE_STATS_MS = 500;
 constexpr int BITRATE_AVGS = 16;
-constexpr audio_sample PCM_OVERLOAD_THRESHOLD = 1.0f;
+constexpr int PIPELINE_POLL_MS = 100;
 
 enum {
 	input_flag_dsd_extract = 1 << 16,
@@ -152,23 +156,6 @@ void adjust_replaygain(file_info& info, float dB_volume_adjust) {
 	info.set_replaygain(rg_info);
 }
 
-void fix_pcm_stream(bool is_end, audio_sample* m_pcm_data, int pcm_samples, int pcm_channels) {
-	if (!is_end) {
-		if (pcm_samples > 1) {
-			for (int ch = 0; ch < pcm_channels; ch++) {
-				m_pcm_data[0 * pcm_channels + ch] = m_pcm_data[1 * pcm_channels + ch];
-			}
-		}
-	}
-	else {
-		if (pcm_samples > 1) {
-			for (int ch = 0; ch < pcm_channels; ch++) {
-				m_pcm_data[(pcm_samples - 1) * pcm_channels + ch] = m_pcm_data[(pcm_samples - 2) * pcm_channels + ch];
-			}
-		}
-	}
-}
-
 int get_cpu_cores() {
 	SYSTEM_INFO sysinfo;
 	GetSystemInfo(&sysinfo);
@@ -213,6 +200,13 @@ class input_sacd_t : public sacd_core_t, public input_stubs {
 	float                  dB_volume_adjust;
 	float                  lfe_adjust_coef;
 	bool                   log_overloads;
+	pcm_post_processor_t   pcm_post;
+	loudness_meter_thread_t loudness_meter;
+	t_uint32               decode_subsong;
+	double                 auto_gain_dB;
+	sacd_pipeline_t        decode_pipeline;
+	bool                   use_pipeline;
+	bool                   pipeline_eof;
 	string8                log_track_name;
 	uint32_t               info_update_time_ms;
 	int                    pcm_out_channels;
@@ -244,6 +238,9 @@ public:
 		access_mode = ACCESS_MODE_NULL;
 		dB_volume_adjust = 0;
 		lfe_adjust_coef = 1.0f;
+		auto_gain_dB = 0;
+		use_pipeline = false;
+		pipeline_eof = false;
 		info_update_time_ms = 0;
 		use_dsd_path = false;
 		use_pcm_path = true;
@@ -351,6 +348,10 @@ public:
 
 	void decode_initialize(t_uint32 p_subsong, unsigned p_flags, abort_callback& p_abort) {
 		initialize_flags = p_flags;
+		decode_subsong = p_subsong;
+		if (media_type == media_type_e::WAVPACK && !(initialize_flags & input_flag_playback)) {
+			static_cast<sacd_wavpack_t*>(sacd_reader.get())->set_decoder_threads(media_path, get_cpu_cores());
+		}
 		if (!sacd_reader->select_track(p_subsong)) {
 			throw exception_io();
 		}
@@ -401,7 +402,8 @@ public:
 		}
 		if (use_pcm_path) {
 			if (!use_dop_for_pcm) {
-				dsdpcm_decoder->set_gain(dB_volume_adjust);
+				auto_gain_dB = get_auto_gain();
+				dsdpcm_decoder->set_gain(dB_volume_adjust + (float)auto_gain_dB);
 				int rv = dsdpcm_decoder->init(pcm_out_channels, framerate, dsd_samplerate, pcm_out_samplerate, get_converter_type(), get_converter_fp64(), fir_data, fir_size);
 				if (rv < 0) {
 					if (rv == -2) {
@@ -433,10 +435,96 @@ public:
 		}
 		pcm_out_append_samples = pcm_out_delay_in_samples;
 		pcm_out_remove_samples = pcm_out_delay_in_samples;
+		pcm_post.init(pcm_out_channels, pcm_out_samplerate, log_overloads);
+		if ((pcm_out_channels >= 4) && (pcm_out_channel_map & audio_chunk::channel_lfe)) {
+			pcm_post.set_channel_gain(3, lfe_adjust_coef);
+		}
+		if (!(initialize_flags & input_flag_playback) && use_pcm_path && !use_dop_for_pcm && CSACDPreferences::get_loudness_meter()) {
+			loudness_meter.start(pcm_out_channels, pcm_out_channel_map, pcm_out_samplerate);
+		}
 		read_frame = true;
+		use_pipeline = !(initialize_flags & input_flag_playback) && use_pcm_path && !use_dop_for_pcm;
+		if (use_pipeline) {
+			decode_pipeline.init(sacd_reader.get(), dsdpcm_decoder, dst_threads, pcm_out_channels, dsd_samplerate, framerate, pcm_out_max_samples);
+			decode_pipeline.start(pcm_out_append_samples > 0);
+			pipeline_eof = false;
+		}
+	}
+
+	// Conversion path: read, DST decode and DSD2PCM run ahead on the pipeline threads, only post-processing is left here
+	bool decode_run_pipeline(audio_chunk& p_chunk, mem_block_container* p_raw, abort_callback& p_abort) {
+		if (pipeline_eof) {
+			p_chunk.set_sample_count(0);
+			store_loudness();
+			return false;
+		}
+		sacd_frame_t* frame;
+		while (!decode_pipeline.pop(frame, PIPELINE_POLL_MS)) {
+			p_abort.check();
+		}
+		if (frame->is_error) {
+			pipeline_eof = true;
+			decode_pipeline.release(frame);
+			decode_pipeline.stop();
+			throw exception_io_data();
+		}
+		if (frame->is_last) {
+			pipeline_eof = true;
+			auto has_samples = output_pcm_tail(p_chunk, frame->pcm_data.data());
+			decode_pipeline.release(frame);
+			decode_pipeline.stop();
+			return has_samples;
+		}
+		update_bitrate(frame->dst_size);
+		if (p_raw) {
+			p_raw->set_size(frame->dsd_size);
+			memcpy(p_raw->get_ptr(), frame->dsd_data.data(), frame->dsd_size);
+		}
+		output_pcm(p_chunk, frame->pcm_data.data(), (int)frame->pcm_samples);
+		sacd_read_bytes += frame->dsd_size;
+		decode_pipeline.release(frame);
+		return p_chunk.get_sample_count() > 0;
+	}
+
+	void update_bitrate(size_t frame_size) {
+		sacd_bitrate_idx = (++sacd_bitrate_idx) % BITRATE_AVGS;
+		sacd_bitrate_sum -= sacd_bitrate[sacd_bitrate_idx];
+		sacd_bitrate[sacd_bitrate_idx] = (int64_t)8 * frame_size * framerate;
+		sacd_bitrate_sum += sacd_bitrate[sacd_bitrate_idx];
+	}
+
+	// Drops the converter delay from the head of the stream, post-processes and hands the samples to the chunk
+	void output_pcm(audio_chunk& p_chunk, audio_sample* pcm_data, int pcm_out_samples) {
+		pcm_data += pcm_out_channels * pcm_out_remove_samples;
+		auto samples = pcm_out_samples - pcm_out_remove_samples;
+		pcm_post.process(pcm_data, samples, pcm_out_offset, pcm_out_remove_samples > 0, false);
+		p_chunk.set_data(pcm_data, samples, pcm_out_channels, pcm_out_samplerate, pcm_out_channel_map);
+		loudness_meter.push(pcm_data, samples);
+		log_overloads_in_chunk();
+		pcm_out_offset -= pcm_out_remove_samples;
+		pcm_out_offset += pcm_out_samples;
+		pcm_out_remove_samples = 0;
+	}
+
+	// pcm_data holds the flushed converter delay, returns false once the stream is over
+	bool output_pcm_tail(audio_chunk& p_chunk, audio_sample* pcm_data) {
+		if (pcm_out_append_samples > 0) {
+			pcm_post.process(pcm_data, pcm_out_append_samples, pcm_out_offset, false, true);
+			p_chunk.set_data(pcm_data, pcm_out_append_samples, pcm_out_channels, pcm_out_samplerate, pcm_out_channel_map);
+			log_overloads_in_chunk();
+			loudness_meter.push(pcm_data, pcm_out_append_samples);
+			pcm_out_append_samples = 0;
+			return true;
+		}
+		p_chunk.set_sample_count(0);
+		store_loudness();
+		return false;
 	}
 
 	bool decode_run_internal(audio_chunk& p_chunk, mem_block_container* p_raw, abort_callback& p_abort) {
+		if (use_pipeline) {
+			return decode_run_pipeline(p_chunk, p_raw, p_abort);
+		}
 		uint8_t* dsd_data = nullptr;
 		size_t dsd_size = 0;
 		while (read_frame) {
@@ -463,10 +551,7 @@ public:
 					dst_decoder->decode(frame_data, frame_size, &dsd_data, &dsd_size);
 					break;
 				}
-				sacd_bitrate_idx = (++sacd_bitrate_idx) % BITRATE_AVGS;
-				sacd_bitrate_sum -= sacd_bitrate[sacd_bitrate_idx];
-				sacd_bitrate[sacd_bitrate_idx] = (int64_t)8 * frame_size * framerate;
-				sacd_bitrate_sum += sacd_bitrate[sacd_bitrate_idx];
+				update_bitrate(frame_size);
 			}
 			if (dsd_size) {
 				break;
@@ -491,15 +576,7 @@ public:
 				}
 				else {
 					auto pcm_out_samples = dsdpcm_decoder->convert(dsd_data, dsd_size, pcm_buf.get_ptr()) / pcm_out_channels;
-					if (pcm_out_remove_samples > 0) {
-						fix_pcm_stream(false, pcm_buf.get_ptr() + pcm_out_channels * pcm_out_remove_samples, pcm_out_samples - pcm_out_remove_samples, pcm_out_channels);
-					}
-					adjust_lfe(pcm_buf.get_ptr() + pcm_out_channels * pcm_out_remove_samples, pcm_out_samples - pcm_out_remove_samples, pcm_out_channels, pcm_out_channel_map);
-					p_chunk.set_data(pcm_buf.get_ptr() + pcm_out_channels * pcm_out_remove_samples, pcm_out_samples - pcm_out_remove_samples, pcm_out_channels, pcm_out_samplerate, pcm_out_channel_map);
-					check_overloads(pcm_buf.get_ptr() + pcm_out_channels * pcm_out_remove_samples, pcm_out_samples - pcm_out_remove_samples);
-					pcm_out_offset -= pcm_out_remove_samples;
-					pcm_out_offset += pcm_out_samples;
-					pcm_out_remove_samples = 0;
+					output_pcm(p_chunk, pcm_buf.get_ptr(), pcm_out_samples);
 				}
 			}
 			else {
@@ -511,15 +588,8 @@ public:
 		else {
 			if (pcm_out_append_samples > 0) {
 				dsdpcm_decoder->convert(nullptr, 0, pcm_buf.get_ptr());
-				fix_pcm_stream(true, pcm_buf.get_ptr(), pcm_out_append_samples, pcm_out_channels);
-				adjust_lfe(pcm_buf.get_ptr(), pcm_out_append_samples, pcm_out_channels, pcm_out_channel_map);
-				p_chunk.set_data(pcm_buf.get_ptr(), pcm_out_append_samples, pcm_out_channels, pcm_out_samplerate, pcm_out_channel_map);
-				check_overloads(pcm_buf.get_ptr(), pcm_out_append_samples);
-				pcm_out_append_samples = 0;
-			}
-			else {
-				p_chunk.set_sample_count(0);
 			}
+			output_pcm_tail(p_chunk, pcm_buf.get_ptr());
 		}
 		sacd_read_bytes += dsd_size;
 		return p_chunk.get_sample_count() > 0;
@@ -547,29 +617,49 @@ public:
 		return ts;
 	}
 
-	void adjust_lfe(audio_sample* pcm_data, t_size pcm_samples, unsigned channels, unsigned channel_config) {
-		if ((channels >= 4) && (channel_config & audio_chunk::channel_lfe) && (lfe_adjust_coef != 1.0f)) {
-			for (t_size sample = 0; sample < pcm_samples; sample++) {
-				pcm_data[sample * channels + 3] *= lfe_adjust_coef;
+	// One console line per chunk, overloaded samples are grouped into ranges by pcm_post_processor_t
+	void log_overloads_in_chunk() {
+		auto& overloads = pcm_post.get_overloads();
+		if (!log_overloads || overloads.empty()) {
+			return;
+		}
+		string_formatter(message);
+		message << "Overload at '" << log_track_name << "'";
+		for (auto& range : overloads) {
+			message << " ch:" << range.channel << " [" << get_time_stamp((double)range.first / (double)pcm_out_samplerate);
+			if (range.last > range.first) {
+				message << " - " << get_time_stamp((double)range.last / (double)pcm_out_samplerate);
 			}
+			message << ", " << range.count << " samples, peak +" << format_float(audio_math::scale_to_gain(range.peak), 0, 2) << " dB]";
 		}
+		console::print(message);
 	}
 
-	void check_overloads(const audio_sample* pcm_data, t_size pcm_samples) {
-		if (log_overloads) {
-			for (t_size sample = 0; sample < pcm_samples; sample++) {
-				for (int ch = 0; ch < pcm_out_channels; ch++) {
-					audio_sample v = pcm_data[sample * pcm_out_channels + ch];
-					if ((v > +PCM_OVERLOAD_THRESHOLD) || (v < -PCM_OVERLOAD_THRESHOLD)) {
-						double overload_time = (double)(pcm_out_offset + sample) / (double)pcm_out_samplerate;
-						const char* track_name = log_track_name;
-						const char* time_stamp = get_time_stamp(overload_time);
-						console_printf("Overload at '%s' ch:%d [%s]", track_name, ch, time_stamp);
-						break;
-					}
-				}
-			}
+	// Gain on top of the volume adjustment that brings a previously metered track to the target loudness,
+	// limited so the true-peak stays below LOUDNESS_TRUE_PEAK_CEILING
+	double get_auto_gain() {
+		auto target = CSACDPreferences::get_loudness_target();
+		loudness_result_t result;
+		if (target == 0 || (initialize_flags & input_flag_playback) || !g_loudness_store.lookup(media_path, decode_subsong, result)) {
+			return 0;
+		}
+		if (result.integrated_lufs <= LOUDNESS_ABSOLUTE_GATE) {
+			return 0;
 		}
+		auto gain = result.gain_dB + (target - result.integrated_lufs);
+		gain = min(gain, result.gain_dB + (LOUDNESS_TRUE_PEAK_CEILING - result.true_peak_dBTP));
+		console::printf("SACD auto gain '%s' #%u: %s dB", media_path.c_str(), decode_subsong, format_float(gain - dB_volume_adjust, 0, 2).toString());
+		return gain - dB_volume_adjust;
+	}
+
+	void store_loudness() {
+		if (!loudness_meter.is_running()) {
+			return;
+		}
+		auto result = loudness_meter.finish();
+		result.gain_dB = dB_volume_adjust + auto_gain_dB;
+		g_loudness_store.store(media_path, decode_subsong, result);
+		console::printf("SACD loudness '%s' #%u: I = %s LUFS, TP = %s dBTP", media_path.c_str(), decode_subsong, format_float(result.integrated_lufs, 0, 1).toString(), format_float(result.true_peak_dBTP, 0, 2).toString());
 	}
 
 	bool decode_run(audio_chunk& p_chunk, abort_callback& p_abort) {
@@ -581,9 +671,15 @@ public:
 	}
 
 	void decode_seek(double p_seconds, abort_callback& p_abort) {
+		loudness_meter.finish(); // A partial track is not worth keeping
+		decode_pipeline.stop();
 		if (!sacd_reader->seek(p_seconds)) {
 			throw exception_io();
 		}
+		if (use_pipeline) {
+			decode_pipeline.start(pcm_out_append_samples > 0);
+			pipeline_eof = false;
+		}
 	}
 
 	bool decode_can_seek() {
@@ -682,6 +778,7 @@ public:
 	
 	virtual void on_quit() {
 		g_dsdpcm_playback->free();
+		g_sacd_toc_cache.flush();
 	}
 };
 
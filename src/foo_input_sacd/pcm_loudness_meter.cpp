@@ -0,0 +1,286 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "pcm_loudness_meter.h"
+#include <emmintrin.h>
+
+loudness_store_t g_loudness_store;
+
+static double energy_to_lufs(double p_energy) {
+	return (p_energy > 0) ? -0.691 + 10.0 * log10(p_energy) : -HUGE_VAL;
+}
+
+loudness_meter_t::loudness_meter_t() {
+	m_channels = 0;
+	m_samplerate = 0;
+	m_subblock_samples = 0;
+	m_subblock_pos = 0;
+	m_subblock_count = 0;
+	memset(m_subblocks, 0, sizeof(m_subblocks));
+	memset(m_tp_phases, 0, sizeof(m_tp_phases));
+}
+
+void loudness_meter_t::init(unsigned p_channels, unsigned p_channel_config, unsigned p_samplerate) {
+	const double PI = 3.14159265358979323846;
+	m_channels = p_channels;
+	m_samplerate = p_samplerate;
+	// K-weighting: high shelf followed by the RLB high-pass, both re-derived for the actual sample rate
+	auto K = tan(PI * 1681.974450955533 / p_samplerate);
+	auto Q = 0.7071752369554196;
+	auto Vh = pow(10.0, 3.999843853973347 / 20.0);
+	auto Vb = pow(Vh, 0.4996667741545416);
+	auto a0 = 1.0 + K / Q + K * K;
+	m_shelf = { { (Vh + Vb * K / Q + K * K) / a0, 2.0 * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0 }, { 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 } };
+	K = tan(PI * 38.13547087602444 / p_samplerate);
+	Q = 0.5003270373238773;
+	a0 = 1.0 + K / Q + K * K;
+	m_highpass = { { 1.0, -2.0, 1.0 }, { 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 } };
+	m_channel.resize(m_channels);
+	for (unsigned ch = 0; ch < m_channels; ch++) {
+		auto& channel = m_channel[ch];
+		auto flag = audio_chunk::g_extract_channel_flag(p_channel_config, ch);
+		switch (flag) {
+		case audio_chunk::channel_lfe:
+			channel.weight = 0.0;
+			break;
+		case audio_chunk::channel_back_left:
+		case audio_chunk::channel_back_right:
+		case audio_chunk::channel_side_left:
+		case audio_chunk::channel_side_right:
+			channel.weight = 1.41;
+			break;
+		default:
+			channel.weight = 1.0;
+			break;
+		}
+		memset(channel.z, 0, sizeof(channel.z));
+		channel.energy = 0;
+		memset(channel.history, 0, sizeof(channel.history));
+		channel.history_pos = 0;
+		channel.peak = 0;
+	}
+	m_subblock_samples = max(m_samplerate / 10, 1u);
+	m_subblock_pos = 0;
+	m_subblock_count = 0;
+	memset(m_subblocks, 0, sizeof(m_subblocks));
+	m_blocks.clear();
+	// 4x interpolator: Blackman windowed sinc, taps of every phase stored oldest sample first
+	auto length = LOUDNESS_TP_RATIO * LOUDNESS_TP_TAPS;
+	for (int n = 0; n < length; n++) {
+		auto t = n - 0.5 * (length - 1);
+		auto sinc = sin(PI * t / LOUDNESS_TP_RATIO) / (PI * t / LOUDNESS_TP_RATIO);
+		auto window = 0.42 - 0.5 * cos(2 * PI * n / (length - 1)) + 0.08 * cos(4 * PI * n / (length - 1));
+		m_tp_phases[n % LOUDNESS_TP_RATIO][LOUDNESS_TP_TAPS - 1 - n / LOUDNESS_TP_RATIO] = (float)(sinc * window);
+	}
+}
+
+void loudness_meter_t::process(const audio_sample* p_data, t_size p_samples) {
+	for (t_size sample = 0; sample < p_samples; sample++) {
+		for (unsigned ch = 0; ch < m_channels; ch++) {
+			auto& channel = m_channel[ch];
+			auto x = p_data[sample * m_channels + ch];
+			channel.peak = max(channel.peak, true_peak(channel, x));
+			if (channel.weight == 0.0) {
+				continue;
+			}
+			// Transposed direct form II, shelf then high-pass
+			double y = x;
+			for (int stage = 0; stage < 2; stage++) {
+				auto& f = stage ? m_highpass : m_shelf;
+				auto z = channel.z[stage];
+				auto v = f.b[0] * y + z[0];
+				z[0] = f.b[1] * y - f.a[1] * v + z[1];
+				z[1] = f.b[2] * y - f.a[2] * v;
+				y = v;
+			}
+			channel.energy += y * y;
+		}
+		if (++m_subblock_pos == m_subblock_samples) {
+			double energy = 0;
+			for (auto& channel : m_channel) {
+				energy += channel.weight * channel.energy;
+				channel.energy = 0;
+			}
+			m_subblocks[m_subblock_count++ % 4] = energy / m_subblock_samples;
+			m_subblock_pos = 0;
+			if (m_subblock_count >= 4) {
+				m_blocks.push_back(0.25 * (m_subblocks[0] + m_subblocks[1] + m_subblocks[2] + m_subblocks[3]));
+			}
+		}
+	}
+}
+
+loudness_result_t loudness_meter_t::get_result() const {
+	loudness_result_t result;
+	double sum = 0;
+	size_t count = 0;
+	for (auto block : m_blocks) {
+		if (energy_to_lufs(block) > LOUDNESS_ABSOLUTE_GATE) {
+			sum += block;
+			count++;
+		}
+	}
+	if (count > 0) {
+		auto relative_gate = energy_to_lufs(sum / count) + LOUDNESS_RELATIVE_GATE;
+		sum = 0;
+		count = 0;
+		for (auto block : m_blocks) {
+			auto lufs = energy_to_lufs(block);
+			if (lufs > LOUDNESS_ABSOLUTE_GATE && lufs > relative_gate) {
+				sum += block;
+				count++;
+			}
+		}
+		if (count > 0) {
+			result.integrated_lufs = energy_to_lufs(sum / count);
+		}
+	}
+	float peak = 0;
+	for (auto& channel : m_channel) {
+		peak = max(peak, channel.peak);
+	}
+	result.true_peak_dBTP = (peak > 0) ? 20.0 * log10(peak) : -HUGE_VAL;
+	return result;
+}
+
+// The history is kept twice so the LOUDNESS_TP_TAPS window is always contiguous, every phase is an SSE dot product
+float loudness_meter_t::true_peak(channel_t& p_channel, float p_sample) {
+	auto pos = p_channel.history_pos;
+	p_channel.history[pos] = p_sample;
+	p_channel.history[pos + LOUDNESS_TP_TAPS] = p_sample;
+	p_channel.history_pos = (pos + 1) % LOUDNESS_TP_TAPS;
+	auto window = p_channel.history + pos + 1;
+	const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	auto peak = _mm_setzero_ps();
+	for (int phase = 0; phase < LOUDNESS_TP_RATIO; phase++) {
+		auto sum = _mm_setzero_ps();
+		for (int j = 0; j < LOUDNESS_TP_TAPS; j += 4) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(m_tp_phases[phase] + j), _mm_loadu_ps(window + j)));
+		}
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		peak = _mm_max_ss(peak, _mm_and_ps(sum, abs_mask));
+	}
+	return max(_mm_cvtss_f32(peak), fabs(p_sample));
+}
+
+loudness_meter_thread_t::loudness_meter_thread_t() {
+	m_write_pos = 0;
+	m_read_pos = 0;
+	m_channels = 0;
+	m_run = false;
+}
+
+loudness_meter_thread_t::~loudness_meter_thread_t() {
+	finish();
+}
+
+void loudness_meter_thread_t::start(unsigned p_channels, unsigned p_channel_config, unsigned p_samplerate) {
+	finish();
+	m_meter.init(p_channels, p_channel_config, p_samplerate);
+	m_channels = p_channels;
+	m_ring.resize(LOUDNESS_RING_SIZE - LOUDNESS_RING_SIZE % p_channels); // whole frames only, wrap-around keeps frames intact
+	m_write_pos = 0;
+	m_read_pos = 0;
+	m_run = true;
+	m_thread = thread([this]() { run(); });
+}
+
+// Waits only if the meter falls a whole ring behind the decoder
+void loudness_meter_thread_t::push(const audio_sample* p_data, t_size p_samples) {
+	if (!m_run) {
+		return;
+	}
+	auto size = m_ring.size();
+	auto count = p_samples * m_channels;
+	while (count > 0) {
+		auto write_pos = m_write_pos.load(std::memory_order_relaxed);
+		auto space = size - (size_t)(write_pos - m_read_pos.load(std::memory_order_acquire));
+		if (space == 0) {
+			m_semaphore.notify();
+			std::this_thread::yield();
+			continue;
+		}
+		auto offset = (size_t)(write_pos % size);
+		auto part = min(min(count, space), size - offset);
+		memcpy(m_ring.data() + offset, p_data, part * sizeof(audio_sample));
+		m_write_pos.store(write_pos + part, std::memory_order_release);
+		p_data += part;
+		count -= part;
+	}
+	m_semaphore.notify();
+}
+
+loudness_result_t loudness_meter_thread_t::finish() {
+	if (m_thread.joinable()) {
+		m_run = false;
+		m_semaphore.notify();
+		m_thread.join();
+	}
+	return m_meter.get_result();
+}
+
+bool loudness_meter_thread_t::is_running() const {
+	return m_run;
+}
+
+void loudness_meter_thread_t::run() {
+	while (m_run) {
+		m_semaphore.wait();
+		drain();
+	}
+	drain();
+}
+
+void loudness_meter_thread_t::drain() {
+	auto size = m_ring.size();
+	for (;;) {
+		auto read_pos = m_read_pos.load(std::memory_order_relaxed);
+		auto used = (size_t)(m_write_pos.load(std::memory_order_acquire) - read_pos);
+		if (used == 0) {
+			break;
+		}
+		auto offset = (size_t)(read_pos % size);
+		auto part = min(used, size - offset);
+		m_meter.process(m_ring.data() + offset, part / m_channels);
+		m_read_pos.store(read_pos + part, std::memory_order_release);
+	}
+}
+
+void loudness_store_t::store(const char* p_path, t_uint32 p_subsong, const loudness_result_t& p_result) {
+	lock_guard<mutex> lock(m_mutex);
+	m_results[get_key(p_path, p_subsong)] = p_result;
+}
+
+bool loudness_store_t::lookup(const char* p_path, t_uint32 p_subsong, loudness_result_t& p_result) {
+	lock_guard<mutex> lock(m_mutex);
+	auto result = m_results.find(get_key(p_path, p_subsong));
+	if (result == m_results.end()) {
+		return false;
+	}
+	p_result = result->second;
+	return true;
+}
+
+string loudness_store_t::get_key(const char* p_path, t_uint32 p_subsong) {
+	string key = p_path;
+	key += '|';
+	key += std::to_string(p_subsong);
+	return key;
+}
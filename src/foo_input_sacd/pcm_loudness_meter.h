@@ -0,0 +1,124 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PCM_LOUDNESS_METER_H_INCLUDED
+#define _PCM_LOUDNESS_METER_H_INCLUDED
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "semaphore.h"
+#include "sacd_config.h"
+
+using std::atomic;
+using std::map;
+using std::mutex;
+using std::lock_guard;
+using std::thread;
+using std::string;
+
+constexpr int    LOUDNESS_TP_RATIO          = 4;
+constexpr int    LOUDNESS_TP_TAPS           = 12; // per phase
+constexpr double LOUDNESS_ABSOLUTE_GATE     = -70.0;
+constexpr double LOUDNESS_RELATIVE_GATE     = -10.0;
+constexpr double LOUDNESS_TRUE_PEAK_CEILING = -1.0;
+constexpr size_t LOUDNESS_RING_SIZE         = 1 << 21; // audio_sample units
+
+class loudness_result_t {
+public:
+	double integrated_lufs = LOUDNESS_ABSOLUTE_GATE;
+	double true_peak_dBTP = -HUGE_VAL;
+	double gain_dB = 0; // conversion gain the result was measured with
+};
+
+// ITU-R BS.1770 integrated loudness (K-weighting, 400 ms blocks with 75% overlap, absolute and relative gates)
+// and 4x oversampled true-peak of interleaved PCM
+class loudness_meter_t {
+	class biquad_t {
+	public:
+		double b[3];
+		double a[3];
+	};
+	class channel_t {
+	public:
+		double       weight;
+		double       z[2][2];
+		double       energy;
+		float        history[2 * LOUDNESS_TP_TAPS];
+		int          history_pos;
+		float        peak;
+	};
+	unsigned          m_channels;
+	unsigned          m_samplerate;
+	biquad_t          m_shelf;
+	biquad_t          m_highpass;
+	vector<channel_t> m_channel;
+	size_t            m_subblock_samples;
+	size_t            m_subblock_pos;
+	double            m_subblocks[4];
+	size_t            m_subblock_count;
+	vector<double>    m_blocks; // mean square of every 400 ms block
+	alignas(16) float m_tp_phases[LOUDNESS_TP_RATIO][LOUDNESS_TP_TAPS];
+public:
+	loudness_meter_t();
+	void init(unsigned p_channels, unsigned p_channel_config, unsigned p_samplerate);
+	void process(const audio_sample* p_data, t_size p_samples);
+	loudness_result_t get_result() const;
+private:
+	float true_peak(channel_t& p_channel, float p_sample);
+};
+
+// Runs loudness_meter_t on its own thread, the decoder only copies samples into a lock-free SPSC ring
+class loudness_meter_thread_t {
+	loudness_meter_t     m_meter;
+	vector<audio_sample> m_ring;
+	atomic<uint64_t>     m_write_pos;
+	atomic<uint64_t>     m_read_pos;
+	unsigned             m_channels;
+	semaphore            m_semaphore;
+	atomic<bool>         m_run;
+	thread               m_thread;
+public:
+	loudness_meter_thread_t();
+	~loudness_meter_thread_t();
+	void start(unsigned p_channels, unsigned p_channel_config, unsigned p_samplerate);
+	void push(const audio_sample* p_data, t_size p_samples);
+	loudness_result_t finish();
+	bool is_running() const;
+private:
+	void run();
+	void drain();
+};
+
+// Per-track results of the last metered conversion, used to pick the gain of the next pass
+class loudness_store_t {
+	mutex                           m_mutex;
+	map<string, loudness_result_t> m_results;
+public:
+	void store(const char* p_path, t_uint32 p_subsong, const loudness_result_t& p_result);
+	bool lookup(const char* p_path, t_uint32 p_subsong, loudness_result_t& p_result);
+private:
+	static string get_key(const char* p_path, t_uint32 p_subsong);
+};
+
+extern loudness_store_t g_loudness_store;
+
+#endif
@@ -0,0 +1,162 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "pcm_post_processor.h"
+#include <emmintrin.h>
+
+pcm_post_processor_t::pcm_post_processor_t() {
+	m_channels = 0;
+	m_samplerate = 0;
+	m_apply_gain = false;
+	m_check_overloads = false;
+}
+
+void pcm_post_processor_t::init(unsigned p_channels, unsigned p_samplerate, bool p_check_overloads) {
+	m_channels = p_channels;
+	m_samplerate = p_samplerate;
+	m_check_overloads = p_check_overloads;
+	m_gain.assign(m_channels, 1.0f);
+	m_gain_pattern.assign(4 * m_channels, 1.0f);
+	m_apply_gain = false;
+	m_peak.assign(m_channels, 0.0f);
+	m_overloads.clear();
+	m_open_range.assign(m_channels, -1);
+}
+
+void pcm_post_processor_t::set_channel_gain(unsigned p_channel, audio_sample p_gain) {
+	if (p_channel >= m_channels) {
+		return;
+	}
+	m_gain[p_channel] = p_gain;
+	m_apply_gain = false;
+	for (size_t i = 0; i < m_gain_pattern.size(); i++) {
+		m_gain_pattern[i] = m_gain[i % m_channels];
+		m_apply_gain |= m_gain_pattern[i] != 1.0f;
+	}
+}
+
+// p_offset is the stream position of the first sample, overload ranges are reported in stream samples
+void pcm_post_processor_t::process(audio_sample* p_data, t_size p_samples, t_uint64 p_offset, bool p_trim_head, bool p_trim_tail) {
+	m_overloads.clear();
+	for (auto& open_range : m_open_range) {
+		open_range = -1;
+	}
+	if (p_samples > 1) {
+		if (p_trim_head) {
+			memcpy(p_data, p_data + m_channels, m_channels * sizeof(audio_sample));
+		}
+		if (p_trim_tail) {
+			memcpy(p_data + (p_samples - 1) * m_channels, p_data + (p_samples - 2) * m_channels, m_channels * sizeof(audio_sample));
+		}
+	}
+	if (!m_apply_gain && !m_check_overloads) {
+		return;
+	}
+	t_size sample = 0;
+#if audio_sample_size == 32
+	// A block of 4 samples spans exactly m_channels vectors, so lane j of vector v always maps to channel (4 * v + j) % m_channels
+	auto vectors = m_channels;
+	auto blocks = p_samples / 4;
+	if (vectors <= 8 && blocks > 0) {
+		const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const auto threshold = _mm_set1_ps(PCM_OVERLOAD_THRESHOLD);
+		__m128 gain[8];
+		__m128 peak[8];
+		for (unsigned v = 0; v < vectors; v++) {
+			gain[v] = _mm_loadu_ps(m_gain_pattern.data() + 4 * v);
+			peak[v] = _mm_setzero_ps();
+		}
+		for (t_size block = 0; block < blocks; block++) {
+			auto data = p_data + 4 * block * m_channels;
+			auto over = 0;
+			for (unsigned v = 0; v < vectors; v++) {
+				auto x = _mm_loadu_ps(data + 4 * v);
+				if (m_apply_gain) {
+					x = _mm_mul_ps(x, gain[v]);
+					_mm_storeu_ps(data + 4 * v, x);
+				}
+				auto a = _mm_and_ps(x, abs_mask);
+				peak[v] = _mm_max_ps(peak[v], a);
+				over |= _mm_movemask_ps(_mm_cmpgt_ps(a, threshold));
+			}
+			if (over && m_check_overloads) {
+				for (unsigned i = 0; i < 4 * m_channels; i++) {
+					auto value = data[i];
+					if (value > +PCM_OVERLOAD_THRESHOLD || value < -PCM_OVERLOAD_THRESHOLD) {
+						add_overload(i % m_channels, p_offset + 4 * block + i / m_channels, value);
+					}
+				}
+			}
+		}
+		for (unsigned v = 0; v < vectors; v++) {
+			alignas(16) float lanes[4];
+			_mm_store_ps(lanes, peak[v]);
+			for (unsigned j = 0; j < 4; j++) {
+				auto ch = (4 * v + j) % m_channels;
+				m_peak[ch] = max(m_peak[ch], lanes[j]);
+			}
+		}
+		sample = 4 * blocks;
+	}
+#endif
+	process_scalar(p_data, sample, p_samples, p_offset);
+}
+
+audio_sample pcm_post_processor_t::get_peak(unsigned p_channel) const {
+	return (p_channel < m_channels) ? m_peak[p_channel] : 0.0f;
+}
+
+const vector<pcm_overload_range_t>& pcm_post_processor_t::get_overloads() const {
+	return m_overloads;
+}
+
+void pcm_post_processor_t::process_scalar(audio_sample* p_data, t_size p_first, t_size p_samples, t_uint64 p_offset) {
+	for (t_size sample = p_first; sample < p_samples; sample++) {
+		for (unsigned ch = 0; ch < m_channels; ch++) {
+			auto& value = p_data[sample * m_channels + ch];
+			value *= m_gain[ch];
+			auto magnitude = fabs(value);
+			m_peak[ch] = max(m_peak[ch], magnitude);
+			if (m_check_overloads && magnitude > PCM_OVERLOAD_THRESHOLD) {
+				add_overload(ch, p_offset + sample, value);
+			}
+		}
+	}
+}
+
+void pcm_post_processor_t::add_overload(unsigned p_channel, t_uint64 p_sample, audio_sample p_value) {
+	auto magnitude = fabs(p_value);
+	auto gap = (t_uint64)m_samplerate * PCM_OVERLOAD_GAP_MS / 1000;
+	auto open_range = m_open_range[p_channel];
+	if (open_range >= 0 && p_sample <= m_overloads[open_range].last + gap) {
+		auto& range = m_overloads[open_range];
+		range.last = p_sample;
+		range.count++;
+		range.peak = max(range.peak, magnitude);
+		return;
+	}
+	pcm_overload_range_t range;
+	range.channel = p_channel;
+	range.first = p_sample;
+	range.last = p_sample;
+	range.count = 1;
+	range.peak = magnitude;
+	m_open_range[p_channel] = (int)m_overloads.size();
+	m_overloads.push_back(range);
+}
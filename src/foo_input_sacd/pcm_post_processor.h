@@ -0,0 +1,61 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _PCM_POST_PROCESSOR_H_INCLUDED
+#define _PCM_POST_PROCESSOR_H_INCLUDED
+
+#include "sacd_config.h"
+
+constexpr audio_sample PCM_OVERLOAD_THRESHOLD = 1.0f;
+constexpr int          PCM_OVERLOAD_GAP_MS    = 10;
+
+class pcm_overload_range_t {
+public:
+	unsigned     channel;
+	t_uint64     first;
+	t_uint64     last;
+	t_uint64     count;
+	audio_sample peak;
+};
+
+// Single pass over interleaved PCM: edge trim, per-channel gain (LFE), peak and overload tracking.
+// Overloaded samples of a channel closer than PCM_OVERLOAD_GAP_MS are merged into one range.
+class pcm_post_processor_t {
+	unsigned                     m_channels;
+	unsigned                     m_samplerate;
+	vector<audio_sample>         m_gain;
+	vector<audio_sample>         m_gain_pattern; // m_gain repeated 4 times, one entry per lane of a 4 * channels block
+	bool                         m_apply_gain;
+	bool                         m_check_overloads;
+	vector<audio_sample>         m_peak;
+	vector<pcm_overload_range_t> m_overloads;
+	vector<int>                  m_open_range;
+public:
+	pcm_post_processor_t();
+	void init(unsigned p_channels, unsigned p_samplerate, bool p_check_overloads);
+	void set_channel_gain(unsigned p_channel, audio_sample p_gain);
+	void process(audio_sample* p_data, t_size p_samples, t_uint64 p_offset, bool p_trim_head, bool p_trim_tail);
+	audio_sample get_peak(unsigned p_channel) const;
+	const vector<pcm_overload_range_t>& get_overloads() const;
+private:
+	void process_scalar(audio_sample* p_data, t_size p_first, t_size p_samples, t_uint64 p_offset);
+	void add_overload(unsigned p_channel, t_uint64 p_sample, audio_sample p_value);
+};
+
+#endif
@@ -181,6 +181,13 @@ proxy_output_t::proxy_output_t(const GUID& p_device, double p_buffer_length, boo
 			break;
 		}
 	}
+	auto dsd_sink_file = CSACDPreferences::get_dsd_sink_file();
+	if (!dsd_sink_file.is_empty()) {
+		m_dsd_sink = make_unique<dsd_sink_file_t>(dsd_sink_file, CSACDPreferences::get_dsd_sink_word_bits(), CSACDPreferences::get_dsd_sink_lsb_first(), false);
+		if (m_trace) {
+			console::printf("proxy_output::proxy_output() => Use native DSD sink [name = \"%s\"]", m_dsd_sink->get_name());
+		}
+	}
 	m_dsd_stream->set_accept_data(true);
 }
 
@@ -224,40 +231,37 @@ void proxy_output_t::process_samples(const audio_chunk& p_chunk) {
 	if (m_trace) {
 		check_dsd_stream(false);
 	}
-	if (m_dsd_playback) {
-		// DSD playback
-		while (m_dsd_stream->get_chunk_count() > 0) {
-			auto dsd_chunk = m_dsd_stream->get_first_chunk();
-			audio_chunk_impl out_chunk;
-			if (pick_dsd_processor(dsd_chunk.get_spec(), pcm_spec)) {
-				t_size inp_samples = dsd_chunk.get_sample_count();
-				t_size out_samples;
-				auto out_data = m_dsddsp->run(dsd_chunk.get_data(), inp_samples, &out_samples);
-				m_dop_converter.set_inp_spec(m_dsddsp_out_spec);
-				m_dop_converter.dsd_to_dop(out_data, out_samples, out_chunk);
+	if (m_dsd_playback && m_dsd_sink && write_dsd_sink()) {
+		// Native DSD playback, the PCM placeholder keeps the output clock running
+		m_output->process_samples(p_chunk);
+	}
+	else if (m_dsd_playback) {
+		// DSD playback, DoP words are encoded from the stream storage straight into m_dop_chunk
+		dsd_chunk_view_t dsd_chunk;
+		m_dop_chunk.set_sample_count(0);
+		while (m_dsd_stream->peek_first_chunk(dsd_chunk)) {
+			auto dsd_data = dsd_chunk.data;
+			auto dsd_samples = dsd_chunk.samples;
+			auto use_dsddsp = pick_dsd_processor(dsd_chunk.spec, pcm_spec);
+			m_dop_converter.set_inp_spec(use_dsddsp ? m_dsddsp_out_spec : dsd_chunk.spec);
+			auto is_first_chunk = m_dop_chunk.is_empty();
+			if (!is_first_chunk && t_samplespec(m_dop_chunk) != m_dop_converter.get_dop_spec()) {
+				break;
 			}
-			else {
-				m_dop_converter.set_inp_spec(dsd_chunk.get_spec());
-				m_dop_converter.dsd_to_dop(dsd_chunk.get_data(), dsd_chunk.get_sample_count(), out_chunk);
+			if (use_dsddsp) {
+				dsd_data = m_dsddsp->run(dsd_chunk.data, dsd_chunk.samples, &dsd_samples);
 			}
+			m_dop_converter.dsd_to_dop_append(dsd_data, dsd_samples, m_dop_chunk);
 			m_dsd_stream->remove_first_chunk();
-			if (dop_chunk.is_empty()) {
-				dop_chunk = out_chunk;
-				if (m_dsd_stream->get_chunk_count() <= DSD_CHUNKS_TRESHOLD) {
-					break;
-				}
+			if (is_first_chunk && m_dsd_stream->get_chunk_count() <= DSD_CHUNKS_TRESHOLD) {
+				break;
+			}
+			if (m_dsd_stream->get_chunk_count() == 0) {
+				break;
 			}
-			else {
-				if (dop_chunk.get_spec() != out_chunk.get_spec()) {
-					break;
-				}
-				dop_chunk.set_data_size(dop_chunk.get_data_size() + out_chunk.get_data_size());
-				memcpy(dop_chunk.get_data() + dop_chunk.get_channel_count() * dop_chunk.get_sample_count(), out_chunk.get_data(), out_chunk.get_channel_count() * out_chunk.get_sample_count() * sizeof(audio_sample));
-				dop_chunk.set_sample_count(dop_chunk.get_sample_count() + out_chunk.get_sample_count());
-		 	}
 		}
-		if (dop_chunk.get_sample_count() > 0) {
-			m_output->process_samples(dop_chunk);
+		if (m_dop_chunk.get_sample_count() > 0) {
+			m_output->process_samples(m_dop_chunk);
 		}
 	}
 	else {
@@ -304,6 +308,11 @@ void proxy_output_t::pause(bool p_state) {
 
 void proxy_output_t::flush() {
 	m_dsd_stream->flush();
+	m_dsd_framer.reset();
+	m_dop_converter.reset();
+	if (m_dsd_sink) {
+		m_dsd_sink->flush();
+	}
 	m_output->flush();
 	if (m_trace) {
 		check_dsd_stream(true);
@@ -313,6 +322,11 @@ void proxy_output_t::flush() {
 
 void proxy_output_t::flush_changing_track() {
 	m_dsd_stream->flush();
+	m_dsd_framer.reset();
+	m_dop_converter.reset();
+	if (m_dsd_sink) {
+		m_dsd_sink->flush();
+	}
 	if (m_is_output_v2) {
 		m_output_v2->flush_changing_track();
 	}
@@ -483,8 +497,38 @@ void proxy_output_t::check_dsd_stream(bool p_update) {
 	auto chunks = m_dsd_stream->get_chunk_count();
 	if (p_update || (chunks > max_chunks)) {
 		max_chunks = chunks;
-		console::printf("proxy_output::check_dsd_stream(%s) => DSD stream contains %d chunks and %d samples", p_update ? "true" : "false", chunks, m_dsd_stream->get_sample_count());
+		dsd_stream_stats_t stats;
+		m_dsd_stream->get_stats(stats);
+		console::printf(
+			"proxy_output::check_dsd_stream(%s) => DSD stream contains %d chunks and %d samples [fill = %d/%d, peak_fill = %d, underruns = %d, overruns = %d, copied = %d, borrowed = %d]",
+			p_update ? "true" : "false", chunks, m_dsd_stream->get_sample_count(), stats.fill, stats.capacity, stats.peak_fill, stats.underruns, stats.overruns, stats.copied, stats.borrowed
+		);
+	}
+}
+
+// Moves raw DSD frames to the native sink, returns false (DoP fallback) if the sink cannot be opened
+bool proxy_output_t::write_dsd_sink() {
+	dsd_chunk_view_t dsd_chunk;
+	while (m_dsd_stream->peek_first_chunk(dsd_chunk)) {
+		dsd_sink_format_t format;
+		format.channels = dsd_chunk.spec.m_channels;
+		format.samplerate = dsd_chunk.spec.m_sample_rate;
+		format.channel_config = dsd_chunk.spec.m_channel_config;
+		m_dsd_sink->get_native_format(format);
+		if (format != m_dsd_framer.get_format() || !m_dsd_sink->is_open()) {
+			if (!m_dsd_sink->open(format)) {
+				console::printf("proxy_output::write_dsd_sink() => Cannot open native DSD sink, fall back to DoP");
+				m_dsd_sink.reset();
+				return false;
+			}
+			m_dsd_framer.set_format(format);
+		}
+		t_size words;
+		auto frame_data = m_dsd_framer.frame(dsd_chunk.data, dsd_chunk.samples, &words);
+		m_dsd_sink->write(frame_data, words);
+		m_dsd_stream->remove_first_chunk();
 	}
+	return true;
 }
 
 static output_factory_t<proxy_output_t> g_proxy_output_factory;
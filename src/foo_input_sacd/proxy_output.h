@@ -22,6 +22,7 @@
 
 #include "dop_converter.h"
 #include "dsd_processor_service.h"
+#include "dsd_sink.h"
 #include "dsd_stream_service.h"
 
 using pfc::eventHandle_t;
@@ -29,6 +30,7 @@ using pfc::eventHandle_t;
 class proxy_output_t : public output_v4 {
 	static constexpr t_size DSD_CHUNKS_TRESHOLD = 8;
 	dop_converter_t m_dop_converter;
+	audio_chunk_impl m_dop_chunk;
 	static_api_ptr_t<dsd_stream_service> m_dsd_stream;
 	bool m_dsd_playback;
 	double m_volume_dB;
@@ -46,6 +48,8 @@ class proxy_output_t : public output_v4 {
 	bool m_track_marks;
 	service_ptr_t<dsd_processor_service> m_dsddsp;
 	t_samplespec m_dsddsp_out_spec;
+	unique_ptr<dsd_sink_t> m_dsd_sink;
+	dsd_framer_t m_dsd_framer;
 public:
 	static bool g_advanced_settings_query();
 	static bool g_needs_bitdepth_config();
@@ -81,6 +85,7 @@ private:
 	bool pick_dsd_processor(t_samplespec& p_dsd_spec, t_samplespec& p_pcm_spec);
 	void volume_adjust();
 	void check_dsd_stream(bool p_update);
+	bool write_dsd_sink();
 };
 
 #endif
@@ -42,6 +42,7 @@ void sacd_core_t::open(file_ptr p_filehint, const char* p_path, t_input_open_rea
 	string_filename_ext filename_ext(p_path);
 	string_extension ext(p_path);
 	auto is_sacd_disc = false;
+	media_path = p_path;
 	media_type = media_type_e::INVALID;
 	if (stricmp_utf8(ext, "ISO") == 0) {
 		media_type = media_type_e::ISO;
@@ -83,6 +84,9 @@ void sacd_core_t::open(file_ptr p_filehint, const char* p_path, t_input_open_rea
 		if (!sacd_reader) {
 			throw exception_overflow();
 		}
+		if (!is_sacd_disc) {
+			static_cast<sacd_disc_t*>(sacd_reader.get())->set_toc_cache_path(p_path);
+		}
 		break;
 	case media_type_e::DSDIFF:
 		sacd_reader = make_unique<sacd_dsdiff_t>();
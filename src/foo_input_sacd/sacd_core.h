@@ -34,6 +34,7 @@ class sacd_core_t {
 protected:
 	media_type_e                media_type;
 	uint32_t                    access_mode;
+	string8                     media_path;
 	unique_ptr<sacd_media_t>    sacd_media;
 	unique_ptr<sacd_reader_t>   sacd_reader;
 	unique_ptr<sacd_metabase_t> sacd_metabase;
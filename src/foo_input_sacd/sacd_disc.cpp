@@ -165,6 +165,14 @@ sacd_disc_t::~sacd_disc_t() {
 	close();
 }
 
+void sacd_disc_t::set_toc_cache_path(const char* p_path) {
+	m_toc_cache_path = p_path;
+}
+
+const char* sacd_disc_t::get_toc_md5() {
+	return m_toc.md5;
+}
+
 tuple<scarletbook_area_t*, uint32_t> sacd_disc_t::get_area_and_index_from_track(uint32_t track_number) {
 	uint32_t twoch_count = 0;
 	uint32_t mulch_count = 0;
@@ -299,48 +307,76 @@ bool sacd_disc_t::open(sacd_media_t* p_file) {
 	char sacdmtoc[8];
 	m_sector_size = 0;
 	m_sector_bad_reads = 0;
-	m_file->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_LSN_SIZE);
-	if (m_file->read(sacdmtoc, 8) == 8) {
-		if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
-			m_sector_size = SACD_LSN_SIZE;
-			m_buffer = m_sector_buffer;
-		}
+	m_toc.clear();
+	t_filestats toc_stats = filestats_invalid;
+	auto toc_cached = false;
+	if (!m_toc_cache_path.is_empty()) {
+		toc_stats = m_file->get_stats();
+		toc_cached = g_sacd_toc_cache.lookup(m_toc_cache_path, toc_stats, m_toc);
 	}
-	if (!m_file->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_PSN_SIZE + 12)) {
-		close();
-		return false;
+	if (toc_cached) {
+		m_sector_size = m_toc.sector_size;
+		m_buffer = (m_sector_size == SACD_PSN_SIZE) ? m_sector_buffer + 12 : m_sector_buffer;
 	}
-	if (m_file->read(sacdmtoc, 8) == 8) {
-		if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
-			m_sector_size = SACD_PSN_SIZE;
-			m_buffer = m_sector_buffer + 12;
+	else {
+		m_file->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_LSN_SIZE);
+		if (m_file->read(sacdmtoc, 8) == 8) {
+			if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
+				m_sector_size = SACD_LSN_SIZE;
+				m_buffer = m_sector_buffer;
+			}
 		}
+		if (!m_file->seek((uint64_t)START_OF_MASTER_TOC * (uint64_t)SACD_PSN_SIZE + 12)) {
+			close();
+			return false;
+		}
+		if (m_file->read(sacdmtoc, 8) == 8) {
+			if (memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
+				m_sector_size = SACD_PSN_SIZE;
+				m_buffer = m_sector_buffer + 12;
+			}
+		}
+		if (!m_file->seek(0)) {
+			close();
+			return false;
+		}
+		m_toc.sector_size = m_sector_size;
 	}
-	if (!m_file->seek(0)) {
-		close();
-		return false;
-	}
-	if (m_sector_size == 0) {
+	if (m_sector_size != SACD_LSN_SIZE && m_sector_size != SACD_PSN_SIZE) {
+		if (toc_cached) {
+			g_sacd_toc_cache.invalidate(m_toc_cache_path);
+		}
 		close();
 		return false;
 	}
 	if (!read_master_toc()) {
+		if (toc_cached) {
+			g_sacd_toc_cache.invalidate(m_toc_cache_path);
+		}
 		close();
 		return false;
 	}
+	if (m_toc.md5.is_empty()) {
+		m_toc.md5 = hasher_md5::get()->process_single(m_toc.master_data.data(), m_toc.master_data.size()).asString();
+	}
+	auto area_toc_ok = true;
 	if (m_sb.master_toc->area_1_toc_1_start) {
 		m_sb.area[m_sb.area_count].area_data = (uint8_t*)malloc(m_sb.master_toc->area_1_toc_size * SACD_LSN_SIZE);
 		if (!m_sb.area[m_sb.area_count].area_data) {
 			close();
 			return false;
 		}
-		if (!read_blocks_raw(m_sb.master_toc->area_1_toc_1_start, m_sb.master_toc->area_1_toc_size, m_sb.area[m_sb.area_count].area_data)) {
+		if (!read_toc_blocks(m_sb.master_toc->area_1_toc_1_start, m_sb.master_toc->area_1_toc_size, m_sb.area[m_sb.area_count].area_data, m_toc.area_data[0])) {
 			m_sb.master_toc->area_1_toc_1_start = 0;
+			area_toc_ok = false;
 		}
 		else {
 			if (read_area_toc(m_sb.area_count)) {
 				m_sb.area_count++;
 			}
+			else {
+				area_toc_ok = false;
+			}
 		}
 	}
 	if (m_sb.master_toc->area_2_toc_1_start) {
@@ -349,14 +385,25 @@ bool sacd_disc_t::open(sacd_media_t* p_file) {
 			close();
 			return false;
 		}
-		if (!read_blocks_raw(m_sb.master_toc->area_2_toc_1_start, m_sb.master_toc->area_2_toc_size, m_sb.area[m_sb.area_count].area_data)) {
+		if (!read_toc_blocks(m_sb.master_toc->area_2_toc_1_start, m_sb.master_toc->area_2_toc_size, m_sb.area[m_sb.area_count].area_data, m_toc.area_data[1])) {
 			m_sb.master_toc->area_2_toc_1_start = 0;
-			return true;
+			area_toc_ok = false;
 		}
-		if (read_area_toc(m_sb.area_count)) {
-			m_sb.area_count++;
+		else {
+			if (read_area_toc(m_sb.area_count)) {
+				m_sb.area_count++;
+			}
+			else {
+				area_toc_ok = false;
+			}
 		}
 	}
+	if (!area_toc_ok && toc_cached) {
+		g_sacd_toc_cache.invalidate(m_toc_cache_path); // A cached area TOC that fails to parse would fail every re-open
+	}
+	if (!toc_cached && area_toc_ok && !m_toc_cache_path.is_empty() && m_sector_bad_reads == 0) {
+		g_sacd_toc_cache.store(m_toc_cache_path, toc_stats, m_toc);
+	}
 	return true;
 }
 
@@ -566,6 +613,19 @@ bool sacd_disc_t::read_blocks_raw(uint32_t lb_start, size_t block_count, uint8_t
 	return true;
 }
 
+bool sacd_disc_t::read_toc_blocks(uint32_t lb_start, size_t block_count, uint8_t* data, vector<uint8_t>& toc_data) {
+	auto toc_size = block_count * SACD_LSN_SIZE;
+	if (toc_data.size() == toc_size) {
+		memcpy(data, toc_data.data(), toc_size);
+		return true;
+	}
+	if (!read_blocks_raw(lb_start, block_count, data)) {
+		return false;
+	}
+	toc_data.assign(data, data + toc_size);
+	return true;
+}
+
 bool sacd_disc_t::seek(double seconds) {
 	uint64_t offset = (uint64_t)(get_size() * seconds / get_duration(m_track_number));
 	return select_track(m_track_number, (uint32_t)(offset / m_sector_size));
@@ -660,7 +720,7 @@ bool sacd_disc_t::read_master_toc() {
 	if (!m_sb.master_data)
 		return false;
 
-	if (!read_blocks_raw(START_OF_MASTER_TOC, MASTER_TOC_LEN, m_sb.master_data))
+	if (!read_toc_blocks(START_OF_MASTER_TOC, MASTER_TOC_LEN, m_sb.master_data, m_toc.master_data))
 		return false;
 
 	master_toc = m_sb.master_toc = (master_toc_t*)m_sb.master_data;
@@ -26,6 +26,7 @@
 #include "endianess.h"
 #include "scarletbook.h"
 #include "sacd_reader.h"
+#include "sacd_toc_cache.h"
 
 constexpr int SACD_PSN_SIZE = 2064;
 constexpr int MAX_DST_SIZE  = 1024 * 64;
@@ -60,11 +61,15 @@ private:
 	int                  m_sector_bad_reads;
 	uint8_t*             m_buffer;
 	int                  m_buffer_offset;
+	string8              m_toc_cache_path;
+	sacd_toc_image_t     m_toc;
 public:
 	static bool g_is_sacd(const char* p_path);
 	static bool g_is_sacd(const char p_drive);
 	sacd_disc_t();
 	~sacd_disc_t();
+	void set_toc_cache_path(const char* p_path);
+	const char* get_toc_md5();
 	tuple<scarletbook_area_t*, uint32_t> get_area_and_index_from_track(uint32_t track_number);
 	uint32_t get_track_count(uint32_t mode);
 	uint32_t get_track_number(uint32_t track_index);
@@ -85,6 +90,7 @@ public:
 private:
 	uint64_t get_size();
 	uint64_t get_offset();
+	bool read_toc_blocks(uint32_t lb_start, size_t block_count, uint8_t* data, vector<uint8_t>& toc_data);
 	bool read_master_toc();
 	bool read_area_toc(int area_idx);
 	void free_area(scarletbook_area_t* area);
@@ -93,6 +93,7 @@ void sacd_dsdiff_t::set_mode(uint32_t mode) {
 bool sacd_dsdiff_t::open(sacd_media_t* p_file) {
 	m_file = p_file;
 	m_dsti_size = 0;
+	m_dst_index.clear();
 	m_id3_offset = 0;
 	uint32_t id3_tag_index = 0;
 	uint32_t start_mark_count = 0;
@@ -306,6 +307,7 @@ bool sacd_dsdiff_t::close() {
 	m_tracklist.resize(0);
 	m_id3_tagger.remove_all();
 	m_dsti_size = 0;
+	m_dst_index.clear();
 	m_id3_offset = 0;
 	return true;
 }
@@ -350,7 +352,14 @@ bool sacd_dsdiff_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_ty
 				}
 			}
 			else {
-				m_file->seek(1 - (int)sizeof(ck), file::seek_from_current);
+				auto ck_position = (uint64_t)m_file->get_position() - sizeof(ck);
+				if (ck != "DSTF" && ck_position + sizeof(ck) + ck.get_size() <= m_track_end && ck.get_size() < m_data_size) {
+					m_file->skip(ck.get_size());
+					m_file->skip(ck.get_size() & 1);
+				}
+				else if (!resync_dst_frame(ck_position)) {
+					break;
+				}
 			}
 		}
 	}
@@ -430,26 +439,81 @@ tuple<double, double> sacd_dsdiff_t::get_track_times(uint32_t track_number) {
 	return make_tuple(start_time, stop_time);
 }
 
+bool sacd_dsdiff_t::load_dst_index() {
+	if (m_dst_index.size() > 0) {
+		return true;
+	}
+	auto position = m_file->get_position();
+	if (m_dsti_size >= sizeof(DSTFrameIndex)) {
+		vector<DSTFrameIndex> dsti((size_t)(m_dsti_size / sizeof(DSTFrameIndex)));
+		m_file->seek(m_dsti_offset);
+		if (m_file->read(dsti.data(), dsti.size() * sizeof(DSTFrameIndex)) == dsti.size() * sizeof(DSTFrameIndex)) {
+			m_dst_index.reserve(dsti.size());
+			for (auto& frame_index : dsti) {
+				m_dst_index.push_back(hton64(frame_index.offset) - sizeof(Chunk));
+			}
+		}
+	}
+	if (m_dst_index.size() == 0) {
+		// No usable DSTI chunk, walk DSTF/DSTC chunks of the sound data once
+		m_dst_index.reserve(m_frame_count);
+		auto data_end = m_data_offset + m_data_size;
+		auto ck_position = m_data_offset;
+		Chunk ck;
+		m_file->seek(ck_position);
+		while (ck_position + sizeof(ck) <= data_end && m_file->read(&ck, sizeof(ck)) == sizeof(ck)) {
+			if (ck == "DSTF") {
+				m_dst_index.push_back(ck_position);
+			}
+			ck_position += sizeof(ck) + ck.get_size() + (ck.get_size() & 1);
+			m_file->seek(ck_position);
+		}
+	}
+	m_file->seek(position);
+	return m_dst_index.size() > 0;
+}
+
+bool sacd_dsdiff_t::resync_dst_frame(uint64_t position) {
+	uint8_t scan_data[4096];
+	auto scan_position = position + 1;
+	while (scan_position + sizeof(Chunk) <= m_track_end) {
+		m_file->seek(scan_position);
+		auto scan_size = m_file->read(scan_data, (size_t)min((uint64_t)sizeof(scan_data), m_track_end - scan_position));
+		if (scan_size < sizeof(Chunk)) {
+			break;
+		}
+		for (size_t i = 0; i + 4 <= scan_size; i++) {
+			if (memcmp(scan_data + i, "DSTF", 4) == 0) {
+				m_file->seek(scan_position + i);
+				return true;
+			}
+		}
+		scan_position += scan_size - 3;
+	}
+	m_file->seek(m_track_end);
+	return false;
+}
+
 uint64_t sacd_dsdiff_t::get_dsti_for_frame(uint32_t frame_nr) {
-	frame_nr = min(frame_nr, (uint32_t)(m_dsti_size / sizeof(DSTFrameIndex) - 1)); 
-	m_file->seek(m_dsti_offset + frame_nr * sizeof(DSTFrameIndex));
-	DSTFrameIndex frame_index;
-	m_file->read(&frame_index, sizeof(DSTFrameIndex));
-	return hton64(frame_index.offset) - sizeof(Chunk);
+	frame_nr = min(frame_nr, (uint32_t)(m_dst_index.size() - 1));
+	return m_dst_index[frame_nr];
 }
 
 uint64_t sacd_dsdiff_t::get_dstf_offset_for_time(double seconds) {
 	uint64_t dstf_offset = 0;
 	if (m_dst_encoded) {
-		dstf_offset = (uint64_t)(seconds * m_framerate / m_frame_count * m_data_size);
-		if (m_dsti_size > 0) {
-			auto frame_nr = (uint32_t)(seconds * m_framerate);
-			if (frame_nr < m_frame_count) {
-				dstf_offset = get_dsti_for_frame(frame_nr) - m_data_offset;
-			}
-			else {
-				dstf_offset = m_data_size;
-			}
+		auto frame_nr = (uint32_t)(seconds * m_framerate);
+		if (frame_nr == 0) {
+			dstf_offset = 0;
+		}
+		else if (frame_nr >= m_frame_count) {
+			dstf_offset = m_data_size;
+		}
+		else if (load_dst_index()) {
+			dstf_offset = get_dsti_for_frame(frame_nr) - m_data_offset;
+		}
+		else {
+			dstf_offset = (uint64_t)(seconds * m_framerate / m_frame_count * m_data_size);
 		}
 	}
 	else {
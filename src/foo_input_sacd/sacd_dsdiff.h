@@ -38,6 +38,7 @@ class sacd_dsdiff_t : public sacd_reader_t {
 	uint64_t      m_frm8_size;
 	uint64_t      m_dsti_offset;
 	uint64_t      m_dsti_size;
+	vector<uint64_t> m_dst_index;
 	uint64_t      m_data_offset;
 	uint64_t      m_data_size;
 	uint16_t      m_framerate;
@@ -73,6 +74,8 @@ public:
 	void commit();
 private:
 	tuple<double, double>get_track_times(uint32_t track_number);
+	bool load_dst_index();
+	bool resync_dst_frame(uint64_t position);
 	uint64_t get_dsti_for_frame(uint32_t frame_nr);
 	uint64_t get_dstf_offset_for_time(double seconds);
 	void write_id3_tag(const void* data, uint32_t size);
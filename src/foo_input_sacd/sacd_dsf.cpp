@@ -18,6 +18,96 @@
 */
 
 #include "sacd_dsf.h"
+#include "cpu_features.h"
+#include <tmmintrin.h>
+
+constexpr int DSF_SIMD_CHANNELS = 8;
+
+// pshufb masks gathering 16 samples of every channel into interleaved output vectors
+class dsf_interleave_masks_t {
+public:
+	alignas(16) uint8_t mask[DSF_SIMD_CHANNELS + 1][DSF_SIMD_CHANNELS][DSF_SIMD_CHANNELS][16];
+	dsf_interleave_masks_t() {
+		memset(mask, 0x80, sizeof(mask));
+		for (auto channels = 1; channels <= DSF_SIMD_CHANNELS; channels++) {
+			for (auto out = 0; out < channels; out++) {
+				for (auto b = 0; b < 16; b++) {
+					auto g = 16 * out + b;
+					mask[channels][out][g % channels][b] = (uint8_t)(g / channels);
+				}
+			}
+		}
+	}
+};
+
+static const dsf_interleave_masks_t g_dsf_interleave_masks;
+
+static inline __m128i reverse_bits(__m128i v) {
+	const auto nibble_mask = _mm_set1_epi8(0x0f);
+	const auto nibble_rev = _mm_setr_epi8(0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe, 0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf);
+	auto lo = _mm_shuffle_epi8(nibble_rev, _mm_and_si128(v, nibble_mask));
+	auto hi = _mm_shuffle_epi8(nibble_rev, _mm_and_si128(_mm_srli_epi16(v, 4), nibble_mask));
+	return _mm_or_si128(_mm_slli_epi16(lo, 4), hi);
+}
+
+template<bool is_lsb>
+static inline __m128i load_channel(const uint8_t* data) {
+	auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	return is_lsb ? reverse_bits(v) : v;
+}
+
+template<bool is_lsb>
+static size_t interleave_block_ssse3(const uint8_t* block, size_t block_size, int channels, uint8_t* out, size_t samples) {
+	size_t sample = 0;
+	switch (channels) {
+	case 1:
+		for (; sample + 16 <= samples; sample += 16) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + sample), load_channel<is_lsb>(block + sample));
+		}
+		break;
+	case 2:
+		for (; sample + 16 <= samples; sample += 16) {
+			auto l = load_channel<is_lsb>(block + sample);
+			auto r = load_channel<is_lsb>(block + block_size + sample);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * sample +  0), _mm_unpacklo_epi8(l, r));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * sample + 16), _mm_unpackhi_epi8(l, r));
+		}
+		break;
+	default:
+		if (channels <= DSF_SIMD_CHANNELS) {
+			auto& masks = g_dsf_interleave_masks.mask[channels];
+			__m128i v[DSF_SIMD_CHANNELS];
+			for (; sample + 16 <= samples; sample += 16) {
+				for (auto ch = 0; ch < channels; ch++) {
+					v[ch] = load_channel<is_lsb>(block + ch * block_size + sample);
+				}
+				for (auto o = 0; o < channels; o++) {
+					auto r = _mm_setzero_si128();
+					for (auto ch = 0; ch < channels; ch++) {
+						r = _mm_or_si128(r, _mm_shuffle_epi8(v[ch], _mm_load_si128(reinterpret_cast<const __m128i*>(masks[o][ch]))));
+					}
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + channels * sample + 16 * o), r);
+				}
+			}
+		}
+		break;
+	}
+	return sample;
+}
+
+template<bool is_lsb>
+static void interleave_block(const uint8_t* block, size_t block_size, int channels, const uint8_t* swap_bits, uint8_t* out, size_t samples) {
+	size_t sample = 0;
+	if (cpu_features_t::has_ssse3()) {
+		sample = interleave_block_ssse3<is_lsb>(block, block_size, channels, out, samples);
+	}
+	for (auto ch = 0; ch < channels; ch++) {
+		auto inp = block + ch * block_size;
+		for (auto s = sample; s < samples; s++) {
+			out[s * channels + ch] = is_lsb ? swap_bits[inp[s]] : inp[s];
+		}
+	}
+}
 
 sacd_dsf_t::sacd_dsf_t() {
 	for (int i = 0; i < 256; i++) {
@@ -186,8 +276,9 @@ bool sacd_dsf_t::select_track(uint32_t track_number, uint32_t offset) {
 }
 
 bool sacd_dsf_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type) {
+	auto samples = (int)*frame_size / m_channel_count;
 	auto samples_read = 0;
-	for (auto sample = 0; sample < (int)*frame_size / m_channel_count; sample++) {
+	while (samples_read < samples) {
 		if (m_sample_in_block >= m_block_data_end / m_channel_count) {
 			if (m_block_data_end > 0) {
 				m_sample_in_block = 0;
@@ -201,13 +292,19 @@ bool sacd_dsf_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_
 				m_block_data_end = 0;
 				break;
 			}
+			continue;
+		}
+		auto block_samples = min(samples - samples_read, m_block_data_end / m_channel_count - m_sample_in_block);
+		auto block_data = m_block_data.data() + m_sample_in_block;
+		auto out_data = frame_data + samples_read * m_channel_count;
+		if (m_is_lsb) {
+			interleave_block<true>(block_data, m_block_size, m_channel_count, swap_bits, out_data, block_samples);
 		}
-		for (auto ch = 0; ch < m_channel_count; ch++) {
-			auto b = m_block_data.data()[ch * m_block_size + m_sample_in_block];
-			frame_data[sample * m_channel_count + ch] = m_is_lsb ? swap_bits[b] : b;
+		else {
+			interleave_block<false>(block_data, m_block_size, m_channel_count, swap_bits, out_data, block_samples);
 		}
-		m_sample_in_block++;
-		samples_read++;
+		m_sample_in_block += block_samples;
+		samples_read += block_samples;
 	}
 	*frame_size = samples_read * m_channel_count;
 	*frame_type = samples_read > 0 ? frame_type_e::DSD : frame_type_e::INVALID;
@@ -84,12 +84,8 @@ auto is_linkable_tag = [](auto tag_name) {
 };
 
 string8 get_md5(sacd_disc_t* p_disc) {
-	uint8_t md5_source[MASTER_TOC_LEN * SACD_LSN_SIZE];
-	auto md5_string{ string8()};
-	if (p_disc->read_blocks_raw(START_OF_MASTER_TOC, MASTER_TOC_LEN, md5_source)) {
-		md5_string = hasher_md5::get()->process_single(md5_source, sizeof(md5_source)).asString();
-	}
-	else {
+	auto md5_string{ string8(p_disc->get_toc_md5()) };
+	if (md5_string.is_empty()) {
 		console::error("Cannot read MD5 hash source");
 	}
 	return md5_string;
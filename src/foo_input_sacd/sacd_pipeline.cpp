@@ -0,0 +1,285 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <chrono>
+#include "sacd_pipeline.h"
+
+using std::chrono::duration;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+static const char* g_stage_names[] = { "read", "dst", "dsd2pcm" };
+
+void sacd_frame_queue_t::open() {
+	lock_guard<mutex> lock(m_mutex);
+	m_frames.clear();
+	m_closed = false;
+}
+
+void sacd_frame_queue_t::close() {
+	lock_guard<mutex> lock(m_mutex);
+	m_closed = true;
+	m_cv.notify_all();
+}
+
+void sacd_frame_queue_t::push(sacd_frame_t* p_frame) {
+	lock_guard<mutex> lock(m_mutex);
+	if (!m_closed) {
+		m_frames.push_back(p_frame);
+		m_cv.notify_one();
+	}
+}
+
+bool sacd_frame_queue_t::pop(sacd_frame_t*& p_frame, int p_timeout_ms) {
+	unique_lock<mutex> lock(m_mutex);
+	auto ready = [this]() { return m_closed || !m_frames.empty(); };
+	if (p_timeout_ms < 0) {
+		m_cv.wait(lock, ready);
+	}
+	else if (!m_cv.wait_for(lock, milliseconds(p_timeout_ms), ready)) {
+		return false;
+	}
+	if (m_closed) {
+		return false;
+	}
+	p_frame = m_frames.front();
+	m_frames.pop_front();
+	return true;
+}
+
+sacd_pipeline_t::sacd_pipeline_t() {
+	m_reader = nullptr;
+	m_converter = nullptr;
+	m_dst_threads = 0;
+	m_channels = 0;
+	m_samplerate = 0;
+	m_framerate = 0;
+	m_flush_converter = false;
+	m_running = false;
+	m_wait_seconds = 0;
+	m_frames = 0;
+	memset(m_stage_seconds, 0, sizeof(m_stage_seconds));
+}
+
+sacd_pipeline_t::~sacd_pipeline_t() {
+	stop();
+}
+
+void sacd_pipeline_t::init(sacd_reader_t* p_reader, DSDPCMConverterEngine* p_converter, int p_dst_threads, int p_channels, int p_samplerate, int p_framerate, int p_pcm_max_samples) {
+	stop();
+	m_reader = p_reader;
+	m_converter = p_converter;
+	m_dst_threads = p_dst_threads;
+	m_channels = p_channels;
+	m_samplerate = p_samplerate;
+	m_framerate = p_framerate;
+	auto frame_size = (size_t)(m_samplerate / 8 / m_framerate * m_channels);
+	m_pool.resize(m_dst_threads + SACD_PIPELINE_SPARE_FRAMES);
+	for (auto& frame : m_pool) {
+		frame.dst_data.resize(frame_size);
+		frame.dsd_data.resize(frame_size);
+		frame.pcm_data.resize(p_pcm_max_samples * m_channels);
+	}
+}
+
+void sacd_pipeline_t::start(bool p_flush_converter) {
+	stop();
+	m_flush_converter = p_flush_converter;
+	m_free_queue.open();
+	m_dst_queue.open();
+	m_pcm_queue.open();
+	m_out_queue.open();
+	for (auto& frame : m_pool) {
+		m_free_queue.push(&frame);
+	}
+	memset(m_stage_seconds, 0, sizeof(m_stage_seconds));
+	m_wait_seconds = 0;
+	m_frames = 0;
+	m_threads[(int)pipeline_stage_e::READ] = std::thread([this]() { run_read(); });
+	m_threads[(int)pipeline_stage_e::DST] = std::thread([this]() { run_dst(); });
+	m_threads[(int)pipeline_stage_e::DSD2PCM] = std::thread([this]() { run_dsd2pcm(); });
+	m_running = true;
+}
+
+void sacd_pipeline_t::stop() {
+	if (!m_running) {
+		return;
+	}
+	m_free_queue.close();
+	m_dst_queue.close();
+	m_pcm_queue.close();
+	m_out_queue.close();
+	for (auto& stage_thread : m_threads) {
+		if (stage_thread.joinable()) {
+			stage_thread.join();
+		}
+	}
+	m_dst_decoder.reset(); // In-flight slots are lost, a restarted pipeline needs a fresh decoder
+	m_running = false;
+	if (m_frames > 0) {
+		auto audio_seconds = (double)m_frames / m_framerate;
+		string_formatter(stats);
+		stats << "SACD pipeline [frames = " << (t_uint32)m_frames << ", audio = " << format_float(audio_seconds, 0, 2) << " s]";
+		for (int stage = 0; stage < (int)pipeline_stage_e::COUNT; stage++) {
+			stats << " " << g_stage_names[stage] << ": " << format_float(m_stage_seconds[stage], 0, 3) << " s";
+		}
+		stats << " consumer wait: " << format_float(m_wait_seconds, 0, 3) << " s";
+		console::print(stats);
+	}
+}
+
+bool sacd_pipeline_t::is_running() const {
+	return m_running;
+}
+
+// Returns false on timeout, so the caller can poll its abort callback
+bool sacd_pipeline_t::pop(sacd_frame_t*& p_frame, int p_timeout_ms) {
+	auto t0 = steady_clock::now();
+	auto ok = m_out_queue.pop(p_frame, p_timeout_ms);
+	m_wait_seconds += duration<double>(steady_clock::now() - t0).count();
+	if (ok && !p_frame->is_last) {
+		m_frames++;
+	}
+	return ok;
+}
+
+void sacd_pipeline_t::release(sacd_frame_t* p_frame) {
+	m_free_queue.push(p_frame);
+}
+
+void sacd_pipeline_t::run_read() {
+	auto& seconds = m_stage_seconds[(int)pipeline_stage_e::READ];
+	sacd_frame_t* frame;
+	while (m_free_queue.pop(frame)) {
+		auto t0 = steady_clock::now();
+		frame->dst_size = frame->dst_data.size();
+		frame->dsd_size = 0;
+		frame->pcm_samples = 0;
+		frame->is_error = false;
+		frame->is_last = !m_reader->read_frame(frame->dst_data.data(), &frame->dst_size, &frame->frame_type);
+		seconds += duration<double>(steady_clock::now() - t0).count();
+		m_dst_queue.push(frame);
+		if (frame->is_last) {
+			break;
+		}
+	}
+}
+
+// dst_decoder_t hands back the output of the oldest loaded slot, frames wait in p_inflight until their slot is done
+void sacd_pipeline_t::run_dst() {
+	auto& seconds = m_stage_seconds[(int)pipeline_stage_e::DST];
+	deque<sacd_frame_t*> inflight;
+	sacd_frame_t* frame;
+	while (m_dst_queue.pop(frame)) {
+		auto t0 = steady_clock::now();
+		if (frame->is_last) {
+			frame->is_error = !flush_dst(inflight);
+			seconds += duration<double>(steady_clock::now() - t0).count();
+			m_pcm_queue.push(frame);
+			break;
+		}
+		if (frame->dst_size == 0) {
+			m_free_queue.push(frame);
+			continue;
+		}
+		switch (frame->frame_type) {
+		case frame_type_e::DSD:
+			frame->is_error = !flush_dst(inflight);
+			frame->dst_data.swap(frame->dsd_data);
+			frame->dsd_size = frame->dst_size;
+			m_pcm_queue.push(frame);
+			break;
+		case frame_type_e::DST:
+			if (!m_dst_decoder) {
+				m_dst_decoder = make_unique<dst_decoder_t>(m_dst_threads);
+				if (m_dst_decoder->init(m_channels, m_samplerate, m_framerate) != 0) {
+					m_dst_decoder.reset();
+					console::printf("Error: sacd_pipeline_t::run_dst() => Cannot initialize DST decoder");
+					frame->is_last = true;
+					frame->is_error = true;
+					m_pcm_queue.push(frame);
+					return;
+				}
+			}
+			{
+				auto dsd_data = frame->dsd_data.data();
+				size_t dsd_size = 0;
+				inflight.push_back(frame);
+				m_dst_decoder->decode(frame->dst_data.data(), frame->dst_size, &dsd_data, &dsd_size);
+				if (dsd_size > 0) {
+					auto done = inflight.front();
+					inflight.pop_front();
+					done->dsd_size = dsd_size;
+					m_pcm_queue.push(done);
+				}
+			}
+			break;
+		default:
+			m_free_queue.push(frame);
+			break;
+		}
+		seconds += duration<double>(steady_clock::now() - t0).count();
+	}
+	for (auto inflight_frame : inflight) {
+		m_free_queue.push(inflight_frame);
+	}
+}
+
+// Returns false if some in-flight frames never came out of the decoder, their audio is lost
+bool sacd_pipeline_t::flush_dst(deque<sacd_frame_t*>& p_inflight) {
+	for (int i = 0; i < 2 * m_dst_threads && !p_inflight.empty() && m_dst_decoder; i++) {
+		uint8_t* dsd_data = nullptr;
+		size_t dsd_size = 0;
+		m_dst_decoder->decode(nullptr, 0, &dsd_data, &dsd_size);
+		if (dsd_size > 0) {
+			auto done = p_inflight.front();
+			p_inflight.pop_front();
+			done->dsd_size = dsd_size;
+			m_pcm_queue.push(done);
+		}
+	}
+	if (p_inflight.empty()) {
+		return true;
+	}
+	console::printf("Error: sacd_pipeline_t::flush_dst() => %d DST frames were not decoded", (int)p_inflight.size());
+	while (!p_inflight.empty()) {
+		m_free_queue.push(p_inflight.front());
+		p_inflight.pop_front();
+	}
+	return false;
+}
+
+void sacd_pipeline_t::run_dsd2pcm() {
+	auto& seconds = m_stage_seconds[(int)pipeline_stage_e::DSD2PCM];
+	sacd_frame_t* frame;
+	while (m_pcm_queue.pop(frame)) {
+		auto t0 = steady_clock::now();
+		if (frame->is_last) {
+			if (m_flush_converter) {
+				frame->pcm_samples = m_converter->convert(nullptr, 0, frame->pcm_data.data()) / m_channels;
+			}
+			seconds += duration<double>(steady_clock::now() - t0).count();
+			m_out_queue.push(frame);
+			break;
+		}
+		frame->pcm_samples = m_converter->convert(frame->dsd_data.data(), (int)frame->dsd_size, frame->pcm_data.data()) / m_channels;
+		seconds += duration<double>(steady_clock::now() - t0).count();
+		m_out_queue.push(frame);
+	}
+}
@@ -0,0 +1,106 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2019 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _SACD_PIPELINE_H_INCLUDED
+#define _SACD_PIPELINE_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "sacd_config.h"
+#include "sacd_reader.h"
+#include "dst_decoder_mt.h"
+#include "DSDPCMConverterEngine.h"
+
+using std::condition_variable;
+using std::deque;
+using std::mutex;
+using std::unique_lock;
+using std::unique_ptr;
+
+constexpr int SACD_PIPELINE_SPARE_FRAMES = 4; // frames in flight on top of the ones held by the DST decoder slots
+
+enum class pipeline_stage_e { READ, DST, DSD2PCM, COUNT };
+
+class sacd_frame_t {
+public:
+	vector<uint8_t>      dst_data;
+	size_t               dst_size = 0;
+	frame_type_e         frame_type = frame_type_e::INVALID;
+	vector<uint8_t>      dsd_data;
+	size_t               dsd_size = 0;
+	vector<audio_sample> pcm_data;
+	size_t               pcm_samples = 0;
+	bool                 is_last = false;
+	bool                 is_error = false; // audio was lost before this frame, the consumer must not carry on
+};
+
+// Blocking FIFO between two stages, close() releases every waiter
+class sacd_frame_queue_t {
+	mutex                m_mutex;
+	condition_variable   m_cv;
+	deque<sacd_frame_t*> m_frames;
+	bool                 m_closed = false;
+public:
+	void open();
+	void close();
+	void push(sacd_frame_t* p_frame);
+	bool pop(sacd_frame_t*& p_frame, int p_timeout_ms = -1);
+};
+
+// Read -> DST decode -> DSD2PCM on a thread per stage. Frames come from a fixed pool, so a slow consumer
+// stalls the reader instead of growing the queues.
+class sacd_pipeline_t {
+	sacd_reader_t*            m_reader;
+	DSDPCMConverterEngine*    m_converter;
+	unique_ptr<dst_decoder_t> m_dst_decoder;
+	int                       m_dst_threads;
+	int                       m_channels;
+	int                       m_samplerate;
+	int                       m_framerate;
+	bool                      m_flush_converter;
+	bool                      m_running;
+	vector<sacd_frame_t>      m_pool;
+	sacd_frame_queue_t        m_free_queue;
+	sacd_frame_queue_t        m_dst_queue;
+	sacd_frame_queue_t        m_pcm_queue;
+	sacd_frame_queue_t        m_out_queue;
+	std::thread               m_threads[(int)pipeline_stage_e::COUNT];
+	double                    m_stage_seconds[(int)pipeline_stage_e::COUNT];
+	double                    m_wait_seconds;
+	size_t                    m_frames;
+public:
+	sacd_pipeline_t();
+	~sacd_pipeline_t();
+	void init(sacd_reader_t* p_reader, DSDPCMConverterEngine* p_converter, int p_dst_threads, int p_channels, int p_samplerate, int p_framerate, int p_pcm_max_samples);
+	void start(bool p_flush_converter);
+	void stop();
+	bool is_running() const;
+	bool pop(sacd_frame_t*& p_frame, int p_timeout_ms);
+	void release(sacd_frame_t* p_frame);
+private:
+	void run_read();
+	void run_dst();
+	void run_dsd2pcm();
+	bool flush_dst(deque<sacd_frame_t*>& p_inflight);
+};
+
+#endif
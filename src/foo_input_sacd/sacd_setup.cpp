@@ -74,6 +74,27 @@ static cfg_guid g_cfg_dsddsp(g_guid_cfg_dsddsp, GUID_NULL);
 static const GUID g_guid_cfg_trace = { 0x21260974, 0x5312, 0x4c3f,{ 0x85, 0x18, 0x32, 0x64, 0xca, 0x6f, 0x73, 0x37 } };
 static cfg_uint g_cfg_trace(g_guid_cfg_trace, BST_UNCHECKED);
 
+static const GUID g_guid_advconfig_dsd_sink = { 0x5d66ec3d, 0x49a8, 0x4693, { 0xa6, 0x7f, 0xe1, 0x5, 0xe6, 0xca, 0xf0, 0x77 } };
+static advconfig_branch_factory g_advconfig_dsd_sink("SACD native DSD sink", g_guid_advconfig_dsd_sink, advconfig_branch::guid_branch_playback, 0);
+
+static const GUID g_guid_advconfig_dsd_sink_file = { 0x44734a25, 0x5f97, 0x464e, { 0xbd, 0x2b, 0xbb, 0xd4, 0xd1, 0xa3, 0x84, 0x52 } };
+static advconfig_string_factory g_advconfig_dsd_sink_file("Raw DSD file (empty = DoP output)", g_guid_advconfig_dsd_sink_file, g_guid_advconfig_dsd_sink, 0, "");
+
+static const GUID g_guid_advconfig_dsd_sink_word_bits = { 0xb2de2ae3, 0x937c, 0x4e6e, { 0x9b, 0x5, 0x9a, 0xe0, 0x3c, 0xc1, 0x3e, 0xac } };
+static advconfig_integer_factory g_advconfig_dsd_sink_word_bits("Word bits (8, 16, 32)", g_guid_advconfig_dsd_sink_word_bits, g_guid_advconfig_dsd_sink, 1, 8, 8, 32);
+
+static const GUID g_guid_advconfig_dsd_sink_lsb_first = { 0xe22c579d, 0xd138, 0x4d10, { 0xbe, 0x9c, 0x33, 0x68, 0x74, 0xbf, 0x35, 0x60 } };
+static advconfig_checkbox_factory g_advconfig_dsd_sink_lsb_first("LSB first", g_guid_advconfig_dsd_sink_lsb_first, g_guid_advconfig_dsd_sink, 2, false);
+
+static const GUID g_guid_advconfig_loudness = { 0x0073aab0, 0xbbbd, 0x406e, { 0x93, 0xe6, 0xf7, 0x51, 0x71, 0xf1, 0x27, 0xbe } };
+static advconfig_branch_factory g_advconfig_loudness("SACD loudness metering", g_guid_advconfig_loudness, advconfig_branch::guid_branch_decoding, 0);
+
+static const GUID g_guid_advconfig_loudness_meter = { 0x027c554b, 0x0487, 0x4a73, { 0x84, 0x03, 0xd9, 0x83, 0xf3, 0x8a, 0xbc, 0xf3 } };
+static advconfig_checkbox_factory g_advconfig_loudness_meter("Measure BS.1770 loudness and true-peak on conversion", g_guid_advconfig_loudness_meter, g_guid_advconfig_loudness, 0, false);
+
+static const GUID g_guid_advconfig_loudness_target = { 0xf80c985f, 0x88e1, 0x4acf, { 0xba, 0x87, 0x3c, 0xb5, 0xe5, 0xcc, 0xf7, 0xae } };
+static advconfig_integer_factory g_advconfig_loudness_target("Auto gain target loudness, -LUFS (0 = off)", g_guid_advconfig_loudness_target, g_guid_advconfig_loudness, 1, 0, 0, 70);
+
 bool CSACDPreferences::use_dsd_path() {
 	return (g_cfg_output_mode.get_value() == 1 || g_cfg_output_mode.get_value() == 2) ? true : false;
 }
@@ -161,6 +182,28 @@ GUID CSACDPreferences::get_dsd_processor() {
 	return g_cfg_dsddsp;
 }
 
+string8 CSACDPreferences::get_dsd_sink_file() {
+	string8 path;
+	g_advconfig_dsd_sink_file.get(path);
+	return path;
+}
+
+unsigned CSACDPreferences::get_dsd_sink_word_bits() {
+	return (unsigned)g_advconfig_dsd_sink_word_bits.get();
+}
+
+bool CSACDPreferences::get_dsd_sink_lsb_first() {
+	return g_advconfig_dsd_sink_lsb_first.get();
+}
+
+bool CSACDPreferences::get_loudness_meter() {
+	return g_advconfig_loudness_meter.get();
+}
+
+int CSACDPreferences::get_loudness_target() {
+	return -(int)g_advconfig_loudness_target.get();
+}
+
 bool CSACDPreferences::g_get_trace() {
 	return g_cfg_trace == BST_CHECKED;
 }
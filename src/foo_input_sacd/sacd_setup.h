@@ -45,6 +45,11 @@ public:
 	static bool get_emaster();
 	static bool get_std_tags();
 	static GUID get_dsd_processor();
+	static string8 get_dsd_sink_file();
+	static unsigned get_dsd_sink_word_bits();
+	static bool get_dsd_sink_lsb_first();
+	static bool get_loudness_meter();
+	static int get_loudness_target();
 	static bool g_get_trace();
 	CSACDPreferences(preferences_page_callback::ptr callback);
 
@@ -0,0 +1,221 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "sacd_toc_cache.h"
+
+sacd_toc_cache_t g_sacd_toc_cache;
+
+auto read_blob = [](auto& file, auto& blob, auto& abort) {
+	uint32_t blob_size;
+	file->read_lendian_t(blob_size, abort);
+	if (blob_size > TOC_CACHE_SIZE_MAX) {
+		throw exception_io_data();
+	}
+	blob.resize(blob_size);
+	if (blob_size > 0) {
+		file->read_object(blob.data(), blob_size, abort);
+	}
+};
+
+auto write_blob = [](auto& file, const auto& blob, auto& abort) {
+	file->write_lendian_t((uint32_t)blob.size(), abort);
+	if (blob.size() > 0) {
+		file->write_object(blob.data(), blob.size(), abort);
+	}
+};
+
+size_t sacd_toc_image_t::get_size() const {
+	auto image_size = master_data.size() + md5.length();
+	for (auto& area : area_data) {
+		image_size += area.size();
+	}
+	return image_size;
+}
+
+void sacd_toc_image_t::clear() {
+	sector_size = 0;
+	md5.reset();
+	master_data.clear();
+	for (auto& area : area_data) {
+		area.clear();
+	}
+}
+
+sacd_toc_cache_t::sacd_toc_cache_t() {
+	m_size = 0;
+	m_loaded = false;
+	m_dirty = false;
+}
+
+bool sacd_toc_cache_t::lookup(const char* p_path, const t_filestats& p_stats, sacd_toc_image_t& p_image) {
+	if (!is_cacheable(p_stats)) {
+		return false;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	load();
+	for (auto entry = m_entries.begin(); entry != m_entries.end(); entry++) {
+		if (stricmp_utf8(entry->path, p_path) == 0) {
+			if (entry->stats != p_stats) {
+				m_size -= entry->image.get_size();
+				m_entries.erase(entry);
+				m_dirty = true;
+				return false;
+			}
+			if (entry != m_entries.begin()) {
+				m_entries.splice(m_entries.begin(), m_entries, entry);
+				m_dirty = true;
+			}
+			p_image = m_entries.front().image;
+			return true;
+		}
+	}
+	return false;
+}
+
+void sacd_toc_cache_t::store(const char* p_path, const t_filestats& p_stats, const sacd_toc_image_t& p_image) {
+	if (!is_cacheable(p_stats) || p_image.get_size() > TOC_CACHE_SIZE_MAX) {
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	load();
+	for (auto entry = m_entries.begin(); entry != m_entries.end(); entry++) {
+		if (stricmp_utf8(entry->path, p_path) == 0) {
+			m_size -= entry->image.get_size();
+			m_entries.erase(entry);
+			break;
+		}
+	}
+	m_entries.push_front(toc_entry_t());
+	auto& entry = m_entries.front();
+	entry.path = p_path;
+	entry.stats = p_stats;
+	entry.image = p_image;
+	m_size += entry.image.get_size();
+	trim();
+	m_dirty = true;
+}
+
+void sacd_toc_cache_t::invalidate(const char* p_path) {
+	lock_guard<mutex> lock(m_mutex);
+	load();
+	for (auto entry = m_entries.begin(); entry != m_entries.end(); entry++) {
+		if (stricmp_utf8(entry->path, p_path) == 0) {
+			m_size -= entry->image.get_size();
+			m_entries.erase(entry);
+			m_dirty = true;
+			break;
+		}
+	}
+}
+
+void sacd_toc_cache_t::flush() {
+	lock_guard<mutex> lock(m_mutex);
+	if (m_dirty) {
+		save();
+		m_dirty = false;
+	}
+}
+
+bool sacd_toc_cache_t::is_cacheable(const t_filestats& p_stats) {
+	return p_stats.m_size != filesize_invalid && p_stats.m_timestamp != filetimestamp_invalid;
+}
+
+string8 sacd_toc_cache_t::get_cache_file() {
+	string8 cache_file = core_api::get_profile_path();
+	cache_file.end_with_slash();
+	cache_file += TOC_CACHE_FILE;
+	return cache_file;
+}
+
+void sacd_toc_cache_t::load() {
+	if (m_loaded) {
+		return;
+	}
+	m_loaded = true;
+	m_entries.clear();
+	m_size = 0;
+	try {
+		auto cache_file = get_cache_file();
+		if (!filesystem::g_exists(cache_file, m_abort)) {
+			return;
+		}
+		file_ptr file;
+		filesystem::g_open_read(file, cache_file, m_abort);
+		char cache_id[8];
+		uint32_t cache_version;
+		uint32_t entry_count;
+		file->read_object(cache_id, sizeof(cache_id), m_abort);
+		file->read_lendian_t(cache_version, m_abort);
+		if (memcmp(cache_id, TOC_CACHE_ID, sizeof(cache_id)) != 0 || cache_version != TOC_CACHE_VERSION) {
+			return;
+		}
+		file->read_lendian_t(entry_count, m_abort);
+		for (uint32_t i = 0; i < entry_count; i++) {
+			toc_entry_t entry;
+			file->read_string(entry.path, m_abort);
+			file->read_lendian_t(entry.stats.m_size, m_abort);
+			file->read_lendian_t(entry.stats.m_timestamp, m_abort);
+			file->read_lendian_t(entry.image.sector_size, m_abort);
+			file->read_string(entry.image.md5, m_abort);
+			read_blob(file, entry.image.master_data, m_abort);
+			for (auto& area : entry.image.area_data) {
+				read_blob(file, area, m_abort);
+			}
+			m_size += entry.image.get_size();
+			m_entries.push_back(std::move(entry));
+		}
+	}
+	catch (std::exception& e) {
+		console::printf("Cannot load SACD TOC cache: %s", e.what());
+		m_entries.clear();
+		m_size = 0;
+	}
+	trim();
+}
+
+void sacd_toc_cache_t::save() {
+	try {
+		file_ptr file;
+		filesystem::g_open_write_new(file, get_cache_file(), m_abort);
+		file->write_object(TOC_CACHE_ID, 8, m_abort);
+		file->write_lendian_t(TOC_CACHE_VERSION, m_abort);
+		file->write_lendian_t((uint32_t)m_entries.size(), m_abort);
+		for (auto& entry : m_entries) {
+			file->write_string(entry.path, m_abort);
+			file->write_lendian_t(entry.stats.m_size, m_abort);
+			file->write_lendian_t(entry.stats.m_timestamp, m_abort);
+			file->write_lendian_t(entry.image.sector_size, m_abort);
+			file->write_string(entry.image.md5, m_abort);
+			write_blob(file, entry.image.master_data, m_abort);
+			for (auto& area : entry.image.area_data) {
+				write_blob(file, area, m_abort);
+			}
+		}
+	}
+	catch (std::exception& e) {
+		console::printf("Cannot save SACD TOC cache: %s", e.what());
+	}
+}
+
+void sacd_toc_cache_t::trim() {
+	while (m_size > TOC_CACHE_SIZE_MAX && m_entries.size() > 0) {
+		m_size -= m_entries.back().image.get_size();
+		m_entries.pop_back();
+	}
+}
@@ -0,0 +1,79 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _SACD_TOC_CACHE_H_INCLUDED
+#define _SACD_TOC_CACHE_H_INCLUDED
+
+#include <list>
+#include <mutex>
+#include "sacd_config.h"
+
+using std::list;
+using std::mutex;
+using std::lock_guard;
+
+constexpr const char* TOC_CACHE_FILE     = "sacd_toc_cache.bin";
+constexpr const char* TOC_CACHE_ID       = "SACDTOCC";
+constexpr uint32_t    TOC_CACHE_VERSION  = 1;
+constexpr size_t      TOC_CACHE_SIZE_MAX = 8 * 1024 * 1024;
+constexpr int         TOC_CACHE_AREAS    = 2;
+
+// Raw (not byte-swapped) master and area TOC sectors of an SACD image
+class sacd_toc_image_t {
+public:
+	uint32_t        sector_size = 0;
+	string8         md5;
+	vector<uint8_t> master_data;
+	vector<uint8_t> area_data[TOC_CACHE_AREAS];
+	size_t get_size() const;
+	void clear();
+};
+
+// Persistent TOC cache keyed by path + size + timestamp, least recently used entries are dropped first.
+// Changes are kept in memory and written to the profile once, by flush() on shutdown
+class sacd_toc_cache_t {
+	class toc_entry_t {
+	public:
+		string8          path;
+		t_filestats      stats;
+		sacd_toc_image_t image;
+	};
+	mutex               m_mutex;
+	list<toc_entry_t>   m_entries;
+	size_t              m_size;
+	bool                m_loaded;
+	bool                m_dirty;
+	abort_callback_impl m_abort;
+public:
+	sacd_toc_cache_t();
+	bool lookup(const char* p_path, const t_filestats& p_stats, sacd_toc_image_t& p_image);
+	void store(const char* p_path, const t_filestats& p_stats, const sacd_toc_image_t& p_image);
+	void invalidate(const char* p_path);
+	void flush();
+private:
+	static bool is_cacheable(const t_filestats& p_stats);
+	string8 get_cache_file();
+	void load();
+	void save();
+	void trim();
+};
+
+extern sacd_toc_cache_t g_sacd_toc_cache;
+
+#endif
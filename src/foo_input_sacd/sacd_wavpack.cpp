@@ -18,6 +18,24 @@
 */
  
 #include "sacd_wavpack.h"
+#include <emmintrin.h>
+
+static void pack_dsd_bytes(const int32_t* inp_data, uint8_t* out_data, size_t count) {
+	const auto byte_mask = _mm_set1_epi32(0xff);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		auto v0 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inp_data + i +  0)), byte_mask);
+		auto v1 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inp_data + i +  4)), byte_mask);
+		auto v2 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inp_data + i +  8)), byte_mask);
+		auto v3 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inp_data + i + 12)), byte_mask);
+		auto w0 = _mm_packs_epi32(v0, v1);
+		auto w1 = _mm_packs_epi32(v2, v3);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_data + i), _mm_packus_epi16(w0, w1));
+	}
+	for (; i < count; i++) {
+		out_data[i] = (uint8_t)inp_data[i];
+	}
+}
 
 static int32_t wavpack_read_bytes(void* id, void* data, int32_t bcount) {
 	return (int32_t)reinterpret_cast<sacd_media_t*>(id)->read(data, bcount);
@@ -73,6 +91,141 @@ static WavpackStreamReader64 wavpack_reader = {
 	wavpack_close_stream
 };
 
+static void wavpack_run_thread(wavpack_slot_t* slot) {
+	while (slot->run_slot) {
+		slot->inp_semaphore.wait();
+		if (slot->run_slot) {
+			slot->state = wavpack_slot_state_e::SLOT_RUNNING;
+			slot->decoded = 0;
+			auto seek_ok = WavpackSeekSample64(slot->wpc, slot->position) == TRUE;
+			while (seek_ok && slot->decoded < slot->samples) {
+				auto unpack_samples = min(slot->samples - slot->decoded, slot->unpack_data.size() / slot->channel_count);
+				auto samples = (size_t)WavpackUnpackSamples(slot->wpc, slot->unpack_data.data(), (uint32_t)unpack_samples);
+				if (samples == 0) {
+					break;
+				}
+				pack_dsd_bytes(slot->unpack_data.data(), slot->dsd_data.data() + slot->decoded * slot->channel_count, samples * slot->channel_count);
+				slot->decoded += samples;
+			}
+			slot->state = (seek_ok && slot->decoded == slot->samples) ? wavpack_slot_state_e::SLOT_READY : wavpack_slot_state_e::SLOT_READY_WITH_ERROR; // a short unpack would shift the following audio
+		}
+		slot->out_semaphore.notify();
+	}
+}
+
+wavpack_decoder_mt_t::wavpack_decoder_mt_t(int threads) {
+	m_slots.resize(max(threads, 1));
+	m_slot_nr = 0;
+	m_channel_count = 0;
+	m_segment_samples = 0;
+	m_next_position = 0;
+	m_end_position = 0;
+}
+
+wavpack_decoder_mt_t::~wavpack_decoder_mt_t() {
+	for (auto& slot : m_slots) {
+		if (slot.run_thread.joinable()) {
+			slot.run_slot = false;
+			slot.inp_semaphore.notify(); // Release worker (decoding) thread for exit
+			slot.run_thread.join(); // Wait until worker (decoding) thread exit
+		}
+		if (slot.wpc) {
+			WavpackCloseFile(slot.wpc);
+			slot.wpc = nullptr;
+		}
+		slot.media.close();
+	}
+}
+
+bool wavpack_decoder_mt_t::init(const char* path, int channels, size_t segment_samples) {
+	m_channel_count = channels;
+	m_segment_samples = segment_samples;
+	for (auto& slot : m_slots) {
+		char error[80];
+		if (!slot.media.open(file_ptr(), path, input_open_decode)) {
+			return false;
+		}
+		slot.wpc = WavpackOpenFileInputEx64(&wavpack_reader, &slot.media, nullptr, error, OPEN_FILE_UTF8 | OPEN_DSD_NATIVE | OPEN_ALT_TYPES, 0);
+		if (!slot.wpc) {
+			console::printf("Error: wavpack_decoder_mt_t::init() => %s", error);
+			return false;
+		}
+		slot.channel_count = channels;
+		slot.unpack_data.resize(min(segment_samples, (size_t)4096) * channels);
+		slot.dsd_data.resize(segment_samples * channels);
+		slot.run_slot = true;
+		slot.run_thread = std::thread(wavpack_run_thread, &slot);
+		if (!slot.run_thread.joinable()) {
+			console::error("Could not start WavPack decoder thread");
+			return false;
+		}
+	}
+	return true;
+}
+
+void wavpack_decoder_mt_t::start(uint64_t position, uint64_t end_position) {
+	drain();
+	m_next_position = position;
+	m_end_position = end_position;
+	m_slot_nr = 0;
+	for (auto& slot : m_slots) {
+		load_slot(slot);
+	}
+}
+
+size_t wavpack_decoder_mt_t::read(uint8_t* dsd_data, size_t samples) {
+	size_t read_samples = 0;
+	while (read_samples < samples) {
+		auto& slot = m_slots[m_slot_nr];
+		if (slot.pending) {
+			slot.out_semaphore.wait();
+			slot.pending = false;
+		}
+		if (slot.state == wavpack_slot_state_e::SLOT_EMPTY) {
+			break;
+		}
+		if (slot.state == wavpack_slot_state_e::SLOT_READY_WITH_ERROR) {
+			console::printf("Error: wavpack_decoder_mt_t::read() => Segment at sample %llu decoded %u of %u samples", (unsigned long long)slot.position, (unsigned)slot.decoded, (unsigned)slot.samples);
+			throw exception_io_data();
+		}
+		auto copy_samples = min(samples - read_samples, slot.decoded - slot.consumed);
+		memcpy(dsd_data + read_samples * m_channel_count, slot.dsd_data.data() + slot.consumed * m_channel_count, copy_samples * m_channel_count);
+		slot.consumed += copy_samples;
+		read_samples += copy_samples;
+		if (slot.consumed >= slot.decoded) {
+			load_slot(slot);
+			m_slot_nr = (m_slot_nr + 1) % m_slots.size();
+		}
+	}
+	return read_samples;
+}
+
+void wavpack_decoder_mt_t::drain() {
+	for (auto& slot : m_slots) {
+		if (slot.pending) {
+			slot.out_semaphore.wait();
+			slot.pending = false;
+		}
+		slot.state = wavpack_slot_state_e::SLOT_EMPTY;
+	}
+}
+
+void wavpack_decoder_mt_t::load_slot(wavpack_slot_t& slot) {
+	slot.decoded = 0;
+	slot.consumed = 0;
+	if (m_next_position < m_end_position) {
+		slot.position = m_next_position;
+		slot.samples = (size_t)min((uint64_t)m_segment_samples, m_end_position - m_next_position);
+		m_next_position += slot.samples;
+		slot.state = wavpack_slot_state_e::SLOT_LOADED;
+		slot.pending = true;
+		slot.inp_semaphore.notify();
+	}
+	else {
+		slot.state = wavpack_slot_state_e::SLOT_EMPTY;
+	}
+}
+
 #define BITSTREAM_SHORTS
 
 static void block_update_checksum(unsigned char *buffer_start)
@@ -244,6 +397,23 @@ void sacd_wavpack_t::set_mode(uint32_t mode) {
 	m_mode = mode;
 }
 
+void sacd_wavpack_t::set_decoder_threads(const char* p_path, int threads) {
+	m_decoder_mt.reset();
+	if (threads > 1 && m_channel_count > 0) {
+		auto samples_in_frame = m_samplerate / 8 / m_framerate;
+		try {
+			m_decoder_mt = make_unique<wavpack_decoder_mt_t>(threads);
+			if (!m_decoder_mt->init(p_path, m_channel_count, WAVPACK_MT_SEGMENT_FRAMES * samples_in_frame)) {
+				m_decoder_mt.reset();
+			}
+		}
+		catch (std::exception& e) {
+			console::printf("Error: sacd_wavpack_t::set_decoder_threads() => %s", e.what());
+			m_decoder_mt.reset();
+		}
+	}
+}
+
 bool sacd_wavpack_t::open(sacd_media_t* p_file) {
 	m_file = p_file;
 	m_tracklist.resize(0);
@@ -305,6 +475,7 @@ bool sacd_wavpack_t::open(sacd_media_t* p_file) {
 }
 
 bool sacd_wavpack_t::close() {
+	m_decoder_mt.reset();
 	m_track_number = 0;
 	m_tracklist.resize(0);
 	m_id3_tagger.remove_all();
@@ -322,16 +493,26 @@ bool sacd_wavpack_t::select_track(uint32_t track_number, uint32_t offset) {
 	m_track_end = (uint64_t)(m_samples * stop_time / m_duration);
 	auto samples_in_frame = m_samplerate / 8 / m_framerate;
 	m_track_position = (m_track_start / samples_in_frame) * samples_in_frame;
+	m_data.resize(samples_in_frame * m_channel_count);
+	if (m_decoder_mt) {
+		m_decoder_mt->start(m_track_position, m_track_end);
+		return true;
+	}
 	return WavpackSeekSample64(m_wpc, m_track_position) == TRUE;
 }
 
 bool sacd_wavpack_t::read_frame(uint8_t* frame_data, size_t* frame_size, frame_type_e* frame_type) {
 	if (m_track_position < m_track_end) {
-		m_data.resize(*frame_size);
 		size_t samples = *frame_size / m_channel_count;
-		samples = WavpackUnpackSamples(m_wpc, m_data.data(), samples);
-		for (size_t sample = 0; sample < m_data.size(); sample++) {
-			frame_data[sample] = m_data[sample];
+		if (m_decoder_mt) {
+			samples = m_decoder_mt->read(frame_data, samples);
+		}
+		else {
+			if (m_data.size() < *frame_size) {
+				m_data.resize(*frame_size);
+			}
+			samples = WavpackUnpackSamples(m_wpc, m_data.data(), samples);
+			pack_dsd_bytes(m_data.data(), frame_data, samples * m_channel_count);
 		}
 		*frame_type = frame_type_e::DSD;
 		*frame_size = samples * m_channel_count;
@@ -347,6 +528,10 @@ bool sacd_wavpack_t::seek(double seconds) {
 	auto track_offset = min((uint64_t)((m_track_end - m_track_start) * seconds / get_duration(m_track_number)), m_track_end - m_track_start);
 	auto samples_in_frame = m_samplerate / 8 / m_framerate;
 	m_track_position = m_track_start + (track_offset / samples_in_frame) * samples_in_frame;
+	if (m_decoder_mt) {
+		m_decoder_mt->start(m_track_position, m_track_end);
+		return true;
+	}
 	return WavpackSeekSample64(m_wpc, m_track_position) == TRUE;
 }
 
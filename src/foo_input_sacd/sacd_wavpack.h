@@ -20,6 +20,8 @@
 #ifndef _SACD_WAVPACK_H_INCLUDED
 #define _SACD_WAVPACK_H_INCLUDED
 
+#include <thread>
+#include "semaphore.h"
 #include "sacd_config.h"
 #include "endianess.h"
 #include "scarletbook.h"
@@ -32,6 +34,8 @@
 
 using cue_parser::embeddedcue_metadata_manager;
 
+constexpr int WAVPACK_MT_SEGMENT_FRAMES = 32;
+
 bool g_dsd_in_wavpack(const char* file);
 
 class file_wavpack_t {
@@ -56,6 +60,59 @@ private:
 	bool create_alt_trailer_block();
 };
 
+enum class wavpack_slot_state_e { SLOT_EMPTY, SLOT_LOADED, SLOT_RUNNING, SLOT_READY, SLOT_READY_WITH_ERROR };
+
+class wavpack_slot_t {
+public:
+	bool                 run_slot;
+	std::thread          run_thread;
+	semaphore            inp_semaphore;
+	semaphore            out_semaphore;
+	wavpack_slot_state_e state;
+	bool                 pending;
+	sacd_media_file_t    media;
+	WavpackContext*      wpc;
+	int                  channel_count;
+	uint64_t             position;
+	size_t               samples;
+	size_t               decoded;
+	size_t               consumed;
+	vector<int32_t>      unpack_data;
+	vector<uint8_t>      dsd_data;
+	wavpack_slot_t() {
+		run_slot = false;
+		state = wavpack_slot_state_e::SLOT_EMPTY;
+		pending = false;
+		wpc = nullptr;
+		channel_count = 0;
+		position = 0;
+		samples = 0;
+		decoded = 0;
+		consumed = 0;
+	}
+	wavpack_slot_t(const wavpack_slot_t& slot) : wavpack_slot_t() {
+	}
+};
+
+// Decodes consecutive segments of a WavPack DSD stream on a pool of independent contexts
+class wavpack_decoder_mt_t {
+	vector<wavpack_slot_t> m_slots;
+	int                    m_slot_nr;
+	int                    m_channel_count;
+	size_t                 m_segment_samples;
+	uint64_t               m_next_position;
+	uint64_t               m_end_position;
+public:
+	wavpack_decoder_mt_t(int threads);
+	~wavpack_decoder_mt_t();
+	bool init(const char* path, int channels, size_t segment_samples);
+	void start(uint64_t position, uint64_t end_position);
+	size_t read(uint8_t* dsd_data, size_t samples);
+private:
+	void drain();
+	void load_slot(wavpack_slot_t& slot);
+};
+
 class sacd_wavpack_t : public sacd_reader_t {
 	sacd_media_t*   m_file;
 	uint32_t        m_mode;
@@ -78,6 +135,7 @@ class sacd_wavpack_t : public sacd_reader_t {
 	bool            m_has_id3;
 	file_wavpack_t  m_wv;
 	embeddedcue_metadata_manager m_cuesheet;
+	unique_ptr<wavpack_decoder_mt_t> m_decoder_mt;
 public:
 	sacd_wavpack_t();
 	~sacd_wavpack_t();
@@ -89,6 +147,7 @@ public:
 	int get_framerate(uint32_t track_number);
 	double get_duration(uint32_t track_number);
 	void set_mode(uint32_t mode);
+	void set_decoder_threads(const char* p_path, int threads);
 	bool open(sacd_media_t* p_file);
 	bool close();
 	bool select_track(uint32_t track_number, uint32_t offset);
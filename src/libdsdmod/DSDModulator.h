@@ -0,0 +1,114 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <emmintrin.h>
+
+#include "DSDModulatorNTF.h"
+
+constexpr double MODULATOR_STATE_LIMIT = 8.0;
+
+// Error feedback 1-bit modulator, y = x + NTF * e, running two channels in the lanes of an SSE2 register
+class DSDModulatorPair {
+	int     order;
+	__m128d coef_e[NTF_ORDER_MAX + 1];
+	__m128d coef_g[NTF_ORDER_MAX + 1];
+	__m128d state_e[NTF_ORDER_MAX + 1];
+	__m128d state_g[NTF_ORDER_MAX + 1];
+public:
+	DSDModulatorPair() {
+		order = 0;
+		reset();
+	}
+	bool init(int order) {
+		vector<double> b, a;
+		if (!DSDModulatorNTF::design(order, NTF_H_INF, b, a)) {
+			return false;
+		}
+		this->order = order;
+		for (int k = 0; k <= NTF_ORDER_MAX; k++) {
+			coef_e[k] = _mm_set1_pd(k <= order ? b[k] - a[k] : 0.0);
+			coef_g[k] = _mm_set1_pd(k <= order ? -a[k] : 0.0);
+		}
+		reset();
+		return true;
+	}
+	void reset() {
+		for (int k = 0; k <= NTF_ORDER_MAX; k++) {
+			state_e[k] = _mm_setzero_pd();
+			state_g[k] = _mm_setzero_pd();
+		}
+	}
+	// samples must be a multiple of 8, every output byte holds 8 samples MSB first
+	void modulate(const float* inp0, const float* inp1, int samples, uint8_t* out0, uint8_t* out1, int out_stride) {
+		switch (order) {
+		case 5:
+			modulate_order<5>(inp0, inp1, samples, out0, out1, out_stride);
+			break;
+		case 6:
+			modulate_order<6>(inp0, inp1, samples, out0, out1, out_stride);
+			break;
+		case 7:
+			modulate_order<7>(inp0, inp1, samples, out0, out1, out_stride);
+			break;
+		}
+	}
+private:
+	template<int ORDER>
+	void modulate_order(const float* inp0, const float* inp1, int samples, uint8_t* out0, uint8_t* out1, int out_stride) {
+		const auto zero = _mm_setzero_pd();
+		const auto one = _mm_set1_pd(1.0);
+		const auto sign_mask = _mm_set1_pd(-0.0);
+		const auto limit = _mm_set1_pd(MODULATOR_STATE_LIMIT);
+		auto inp_1 = inp1 ? inp1 : inp0;
+		for (int i = 0; i < samples / 8; i++) {
+			int byte0 = 0;
+			int byte1 = 0;
+			for (int bit = 0; bit < 8; bit++) {
+				auto s = 8 * i + bit;
+				auto g = _mm_setzero_pd();
+				for (int k = 1; k <= ORDER; k++) {
+					g = _mm_add_pd(g, _mm_add_pd(_mm_mul_pd(coef_e[k], state_e[k]), _mm_mul_pd(coef_g[k], state_g[k])));
+				}
+				auto u = _mm_add_pd(_mm_set_pd(inp_1[s], inp0[s]), g);
+				auto positive = _mm_cmpge_pd(u, zero);
+				auto q = _mm_or_pd(_mm_and_pd(positive, one), _mm_andnot_pd(positive, _mm_xor_pd(one, sign_mask)));
+				auto e = _mm_sub_pd(q, u);
+				for (int k = ORDER; k > 1; k--) {
+					state_e[k] = state_e[k - 1];
+					state_g[k] = state_g[k - 1];
+				}
+				state_e[1] = e;
+				state_g[1] = g;
+				auto bits = _mm_movemask_pd(positive);
+				byte0 = (byte0 << 1) | (bits & 1);
+				byte1 = (byte1 << 1) | ((bits >> 1) & 1);
+				if (_mm_movemask_pd(_mm_cmpgt_pd(_mm_andnot_pd(sign_mask, u), limit))) {
+					reset(); // The loop went unstable on an overload, restart it from a quiet state
+				}
+			}
+			out0[i * out_stride] = (uint8_t)byte0;
+			if (out1) {
+				out1[i * out_stride] = (uint8_t)byte1;
+			}
+		}
+	}
+};
@@ -0,0 +1,150 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <chrono>
+#include "DSDModulatorEngine.h"
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+void modulator_thread(DSDModulatorSlot* slot) {
+	while (slot->run_slot) {
+		slot->pcm_semaphore.wait();
+		if (slot->run_slot) {
+			auto t0 = steady_clock::now();
+			auto dsd_inp_samples = slot->pcm_samples * slot->upsampler[0].get_ratio();
+			for (int ch = 0; ch < slot->pair_channels; ch++) {
+				slot->dsd_inp[ch].resize(dsd_inp_samples);
+				slot->upsampler[ch].run(slot->pcm_data + ch, slot->pcm_samples, slot->stride, slot->dsd_inp[ch].data());
+			}
+			slot->modulator.modulate(
+				slot->dsd_inp[0].data(), slot->pair_channels > 1 ? slot->dsd_inp[1].data() : nullptr, dsd_inp_samples,
+				slot->dsd_data, slot->pair_channels > 1 ? slot->dsd_data + 1 : nullptr, slot->stride
+			);
+			slot->cpu_time += duration<double>(steady_clock::now() - t0).count();
+		}
+		slot->dsd_semaphore.notify();
+	}
+}
+
+DSDModulatorEngine::DSDModulatorEngine() {
+	channels = 0;
+	pcm_samplerate = 0;
+	dsd_samplerate = 0;
+	order = 0;
+}
+
+DSDModulatorEngine::~DSDModulatorEngine() {
+	free();
+}
+
+int DSDModulatorEngine::get_dsd_samplerate(int pcm_samplerate, int dsd_multiplier) {
+	auto base_samplerate = (pcm_samplerate % 44100 == 0) ? 44100 : 48000;
+	auto dsd_samplerate = base_samplerate * 64 * dsd_multiplier;
+	if (pcm_samplerate <= 0 || dsd_samplerate % pcm_samplerate != 0 || (dsd_samplerate / pcm_samplerate) % UPSAMPLER_FIR_RATIO != 0) {
+		return 0;
+	}
+	return dsd_samplerate;
+}
+
+int DSDModulatorEngine::init(int channels, int pcm_samplerate, int dsd_samplerate, int order) {
+	if (this->channels == channels && this->pcm_samplerate == pcm_samplerate && this->dsd_samplerate == dsd_samplerate && this->order == order) {
+		return 1;
+	}
+	if (channels <= 0 || pcm_samplerate <= 0 || dsd_samplerate % pcm_samplerate != 0) {
+		return -1;
+	}
+	auto ratio = dsd_samplerate / pcm_samplerate;
+	if (ratio % UPSAMPLER_FIR_RATIO != 0 || order < NTF_ORDER_MIN || order > NTF_ORDER_MAX) {
+		return -1;
+	}
+	free();
+	this->channels = channels;
+	this->pcm_samplerate = pcm_samplerate;
+	this->dsd_samplerate = dsd_samplerate;
+	this->order = order;
+	modSlots.resize((channels + 1) / 2);
+	auto ch = 0;
+	for (auto& slot : modSlots) {
+		slot.channel = ch;
+		slot.pair_channels = (channels - ch > 1) ? 2 : 1;
+		for (int i = 0; i < slot.pair_channels; i++) {
+			slot.upsampler[i].init(ratio, MODULATOR_INPUT_GAIN);
+		}
+		slot.modulator.init(order);
+		slot.cpu_time = 0.0;
+		slot.run_slot = true;
+		slot.run_thread = thread(modulator_thread, &slot);
+		if (!slot.run_thread.joinable()) {
+			return -2;
+		}
+		ch += slot.pair_channels;
+	}
+	return 0;
+}
+
+int DSDModulatorEngine::free() {
+	for (auto& slot : modSlots) {
+		slot.run_slot = false;
+		slot.pcm_semaphore.notify(); // Release worker (modulator) thread for exit
+		if (slot.run_thread.joinable()) {
+			slot.run_thread.join(); // Wait until worker (modulator) thread exit
+		}
+	}
+	modSlots.resize(0);
+	channels = 0;
+	pcm_samplerate = 0;
+	dsd_samplerate = 0;
+	order = 0;
+	return 0;
+}
+
+void DSDModulatorEngine::reset() {
+	auto ratio = pcm_samplerate > 0 ? dsd_samplerate / pcm_samplerate : 0;
+	for (auto& slot : modSlots) {
+		for (int i = 0; i < slot.pair_channels; i++) {
+			slot.upsampler[i].init(ratio, MODULATOR_INPUT_GAIN);
+		}
+		slot.modulator.reset();
+	}
+}
+
+// pcm_data holds interleaved float samples, dsd_data receives interleaved DSD bytes (one byte per channel per 8 samples)
+int DSDModulatorEngine::convert(const float* pcm_data, int pcm_samples, uint8_t* dsd_data) {
+	for (auto& slot : modSlots) {
+		slot.pcm_data = pcm_data + slot.channel;
+		slot.pcm_samples = pcm_samples;
+		slot.dsd_data = dsd_data + slot.channel;
+		slot.stride = channels;
+		slot.pcm_semaphore.notify(); // Release worker (modulator) thread on the loaded slot
+	}
+	for (auto& slot : modSlots) {
+		slot.dsd_semaphore.wait(); // Wait until worker (modulator) thread is complete
+	}
+	return pcm_samples * (dsd_samplerate / pcm_samplerate) / 8;
+}
+
+double DSDModulatorEngine::get_cpu_time(int channel) {
+	for (auto& slot : modSlots) {
+		if (channel >= slot.channel && channel < slot.channel + slot.pair_channels) {
+			return slot.cpu_time / slot.pair_channels;
+		}
+	}
+	return 0.0;
+}
@@ -0,0 +1,80 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include "../libdsdpcm/semaphore.h"
+#include "PCMDSDUpsampler.h"
+#include "DSDModulator.h"
+
+using std::thread;
+using std::vector;
+
+constexpr float MODULATOR_INPUT_GAIN = 0.5f; // -6 dB headroom keeps the high order loop stable
+
+class DSDModulatorSlot {
+public:
+	const float*     pcm_data;
+	int              pcm_samples;
+	uint8_t*         dsd_data;
+	int              stride;
+	int              channel;
+	int              pair_channels;
+	PCMDSDUpsampler  upsampler[2];
+	vector<float>    dsd_inp[2];
+	DSDModulatorPair modulator;
+	double           cpu_time;
+	semaphore        pcm_semaphore;
+	semaphore        dsd_semaphore;
+	bool             run_slot;
+	thread           run_thread;
+	DSDModulatorSlot() {
+		pcm_data = nullptr;
+		pcm_samples = 0;
+		dsd_data = nullptr;
+		stride = 0;
+		channel = 0;
+		pair_channels = 0;
+		cpu_time = 0.0;
+		run_slot = false;
+	}
+	DSDModulatorSlot(const DSDModulatorSlot& slot) : DSDModulatorSlot() {
+	}
+};
+
+// PCM -> DSD conversion, channel pairs share one SIMD modulator and run on their own thread
+class DSDModulatorEngine {
+	int channels;
+	int pcm_samplerate;
+	int dsd_samplerate;
+	int order;
+	vector<DSDModulatorSlot> modSlots;
+public:
+	DSDModulatorEngine();
+	~DSDModulatorEngine();
+	static int get_dsd_samplerate(int pcm_samplerate, int dsd_multiplier);
+	int init(int channels, int pcm_samplerate, int dsd_samplerate, int order);
+	int free();
+	void reset();
+	int convert(const float* pcm_data, int pcm_samples, uint8_t* dsd_data);
+	double get_cpu_time(int channel);
+};
@@ -0,0 +1,91 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <complex>
+#include <math.h>
+#include <vector>
+
+using std::complex;
+using std::vector;
+
+constexpr int    NTF_ORDER_MIN = 5;
+constexpr int    NTF_ORDER_MAX = 7;
+constexpr double NTF_H_INF     = 1.5;
+
+// Noise transfer function NTF(z) = (1 - z^-1)^N / A(z) with maximally flat (Butterworth) poles,
+// the pole radius is chosen so that |NTF| at Nyquist equals the Lee criterion limit h_inf
+class DSDModulatorNTF {
+public:
+	static bool design(int order, double h_inf, vector<double>& b, vector<double>& a) {
+		if (order < NTF_ORDER_MIN || order > NTF_ORDER_MAX) {
+			return false;
+		}
+		double wc_lo = 1e-4;
+		double wc_hi = 3.0;
+		for (int i = 0; i < 100; i++) {
+			auto wc = sqrt(wc_lo * wc_hi);
+			if (get_h_inf(order, wc) > h_inf) {
+				wc_hi = wc;
+			}
+			else {
+				wc_lo = wc;
+			}
+		}
+		vector<complex<double>> zeros(order, 1.0);
+		b = get_poly(zeros);
+		a = get_poly(get_poles(order, wc_lo));
+		return true;
+	}
+private:
+	static vector<complex<double>> get_poles(int order, double wc) {
+		const double PI = 3.14159265358979323846;
+		vector<complex<double>> poles;
+		for (int k = 0; k < order; k++) {
+			auto s = std::polar(1.0, PI * (2 * k + order + 1) / (2.0 * order));
+			auto s_hp = wc / s;
+			poles.push_back((1.0 + s_hp / 2.0) / (1.0 - s_hp / 2.0));
+		}
+		return poles;
+	}
+	static double get_h_inf(int order, double wc) {
+		auto h = pow(2.0, order);
+		for (auto& pole : get_poles(order, wc)) {
+			h /= abs(-1.0 - pole);
+		}
+		return h;
+	}
+	static vector<double> get_poly(const vector<complex<double>>& roots) {
+		vector<complex<double>> c(1, 1.0);
+		for (auto& root : roots) {
+			vector<complex<double>> n(c.size() + 1, 0.0);
+			for (size_t i = 0; i < c.size(); i++) {
+				n[i] += c[i];
+				n[i + 1] -= c[i] * root;
+			}
+			c = n;
+		}
+		vector<double> poly;
+		for (auto& v : c) {
+			poly.push_back(v.real());
+		}
+		return poly;
+	}
+};
@@ -0,0 +1,108 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <string.h>
+#include <xmmintrin.h>
+
+#include "DSDModulatorNTF.h"
+
+constexpr int UPSAMPLER_FIR_RATIO = 8;
+constexpr int UPSAMPLER_FIR_TAPS  = 64; // per phase
+
+// PCM -> DSD rate front-end: polyphase FIR by 8 followed by linear interpolation up to the modulator rate
+class PCMDSDUpsampler {
+	int           ratio;
+	int           lin_ratio;
+	float         gain;
+	vector<float> fir_phases; // UPSAMPLER_FIR_RATIO phases, taps reversed
+	vector<float> history;
+	float         last_sample;
+public:
+	PCMDSDUpsampler() {
+		ratio = 0;
+		lin_ratio = 0;
+		gain = 1.0f;
+		last_sample = 0.0f;
+	}
+	bool init(int ratio, float gain) {
+		if (ratio < UPSAMPLER_FIR_RATIO || ratio % UPSAMPLER_FIR_RATIO != 0) {
+			return false;
+		}
+		const double PI = 3.14159265358979323846;
+		this->ratio = ratio;
+		this->lin_ratio = ratio / UPSAMPLER_FIR_RATIO;
+		this->gain = gain;
+		auto length = UPSAMPLER_FIR_RATIO * UPSAMPLER_FIR_TAPS;
+		auto cutoff = 0.5 / UPSAMPLER_FIR_RATIO;
+		vector<double> taps(length);
+		double sum = 0;
+		for (int n = 0; n < length; n++) {
+			auto t = n - 0.5 * (length - 1);
+			auto sinc = sin(2 * PI * cutoff * t) / (PI * t);
+			auto window = 0.42 - 0.5 * cos(2 * PI * n / (length - 1)) + 0.08 * cos(4 * PI * n / (length - 1));
+			taps[n] = sinc * window;
+			sum += taps[n];
+		}
+		fir_phases.resize(length);
+		for (int phase = 0; phase < UPSAMPLER_FIR_RATIO; phase++) {
+			for (int j = 0; j < UPSAMPLER_FIR_TAPS; j++) {
+				fir_phases[phase * UPSAMPLER_FIR_TAPS + (UPSAMPLER_FIR_TAPS - 1 - j)] = (float)(taps[phase + UPSAMPLER_FIR_RATIO * j] * UPSAMPLER_FIR_RATIO / sum);
+			}
+		}
+		history.assign(UPSAMPLER_FIR_TAPS - 1, 0.0f);
+		last_sample = 0.0f;
+		return true;
+	}
+	int get_ratio() const {
+		return ratio;
+	}
+	// Reads pcm_samples with the given stride, writes pcm_samples * ratio samples
+	void run(const float* pcm_data, int pcm_samples, int pcm_stride, float* out_data) {
+		auto history_size = UPSAMPLER_FIR_TAPS - 1;
+		history.resize(history_size + pcm_samples);
+		for (int i = 0; i < pcm_samples; i++) {
+			auto x = pcm_data[i * pcm_stride];
+			history[history_size + i] = gain * (x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x));
+		}
+		auto step = 1.0f / lin_ratio;
+		for (int i = 0; i < pcm_samples; i++) {
+			auto window = history.data() + i;
+			for (int phase = 0; phase < UPSAMPLER_FIR_RATIO; phase++) {
+				auto y = dot_product(fir_phases.data() + phase * UPSAMPLER_FIR_TAPS, window);
+				for (int l = 0; l < lin_ratio; l++) {
+					*out_data++ = last_sample + (y - last_sample) * (l + 1) * step;
+				}
+				last_sample = y;
+			}
+		}
+		memmove(history.data(), history.data() + pcm_samples, history_size * sizeof(float));
+	}
+private:
+	static float dot_product(const float* coefs, const float* data) {
+		auto sum = _mm_setzero_ps();
+		for (int j = 0; j < UPSAMPLER_FIR_TAPS; j += 4) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(coefs + j), _mm_loadu_ps(data + j)));
+		}
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+	}
+};
@@ -34,22 +34,22 @@ class DSDPCMConverterDirect_x1024 : public DSDPCMConverterDirect<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 8);
-		alloc_pcm_temp2(dsd_samples / 16);
+		this->alloc_pcm_temp1(dsd_samples / 8);
+		this->alloc_pcm_temp2(dsd_samples / 16);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 64);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2c.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir2c.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir2c.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -62,20 +62,20 @@ class DSDPCMConverterDirect_x512 : public DSDPCMConverterDirect<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 8);
-		alloc_pcm_temp2(dsd_samples / 16);
+		this->alloc_pcm_temp1(dsd_samples / 8);
+		this->alloc_pcm_temp2(dsd_samples / 16);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 64);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = ((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = ((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -87,18 +87,18 @@ class DSDPCMConverterDirect_x256 : public DSDPCMConverterDirect<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 8);
-		alloc_pcm_temp2(dsd_samples / 16);
+		this->alloc_pcm_temp1(dsd_samples / 8);
+		this->alloc_pcm_temp2(dsd_samples / 16);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 64);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -109,15 +109,15 @@ class DSDPCMConverterDirect_x128 : public DSDPCMConverterDirect<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 8);
+		this->alloc_pcm_temp1(dsd_samples / 8);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 64);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -128,15 +128,15 @@ class DSDPCMConverterDirect_x64 : public DSDPCMConverterDirect<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 32);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -146,9 +146,9 @@ class DSDPCMConverterDirect_x32: public DSDPCMConverterDirect<real_t> {
 	DSDPCMFir<real_t> dsd_fir1;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 32);
-		delay = dsd_fir1.get_delay();
+		this->delay = dsd_fir1.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
@@ -162,9 +162,9 @@ class DSDPCMConverterDirect_x16 : public DSDPCMConverterDirect<real_t> {
 	DSDPCMFir<real_t> dsd_fir1;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp1(dsd_samples / 2);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 16);
-		delay = dsd_fir1.get_delay();
+		this->delay = dsd_fir1.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
@@ -178,9 +178,9 @@ class DSDPCMConverterDirect_x8 : public DSDPCMConverterDirect<real_t> {
 	DSDPCMFir<real_t> dsd_fir1;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples);
+		this->alloc_pcm_temp1(dsd_samples);
 		dsd_fir1.init(flt_setup.get_fir1_64_ctables(), flt_setup.get_fir1_64_length(), 8);
-		delay = dsd_fir1.get_delay();
+		this->delay = dsd_fir1.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
@@ -36,8 +36,8 @@ class DSDPCMConverterMultistage_x1024 : public DSDPCMConverterMultistage<real_t>
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
-		alloc_pcm_temp2(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp2(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_16_ctables(), flt_setup.get_fir1_16_length(), 16);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
@@ -45,17 +45,17 @@ public:
 		pcm_fir2d.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2e.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (((((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir2d.get_decimation() + pcm_fir2d.get_delay()) / pcm_fir2e.get_decimation() + pcm_fir2e.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (((((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir2d.get_decimation() + pcm_fir2d.get_delay()) / pcm_fir2e.get_decimation() + pcm_fir2e.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir2c.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2d.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir2e.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir2c.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2d.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir2e.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -70,24 +70,24 @@ class DSDPCMConverterMultistage_x512 : public DSDPCMConverterMultistage<real_t>
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
-		alloc_pcm_temp2(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp2(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_16_ctables(), flt_setup.get_fir1_16_length(), 16);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2c.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2d.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = ((((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir2d.get_decimation() + pcm_fir2d.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = ((((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir2d.get_decimation() + pcm_fir2d.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir2c.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2d.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir2c.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2d.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -101,22 +101,22 @@ class DSDPCMConverterMultistage_x256 : public DSDPCMConverterMultistage<real_t>
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
-		alloc_pcm_temp2(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp2(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_16_ctables(), flt_setup.get_fir1_16_length(), 16);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2c.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir2c.get_decimation() + pcm_fir2c.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir2c.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir2c.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -129,20 +129,20 @@ class DSDPCMConverterMultistage_x128 : public DSDPCMConverterMultistage<real_t>
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
-		alloc_pcm_temp2(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp2(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_16_ctables(), flt_setup.get_fir1_16_length(), 16);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir2b.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = ((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = ((dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir2b.get_decimation() + pcm_fir2b.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir2b.run(pcm_temp2, pcm_temp1, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir2b.run(this->pcm_temp2, this->pcm_temp1, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -154,18 +154,18 @@ class DSDPCMConverterMultistage_x64 : public DSDPCMConverterMultistage<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples / 2);
-		alloc_pcm_temp2(dsd_samples / 4);
+		this->alloc_pcm_temp1(dsd_samples / 2);
+		this->alloc_pcm_temp2(dsd_samples / 4);
 		dsd_fir1.init(flt_setup.get_fir1_16_ctables(), flt_setup.get_fir1_16_length(), 16);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -177,18 +177,18 @@ class DSDPCMConverterMultistage_x32 : public DSDPCMConverterMultistage<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples);
-		alloc_pcm_temp2(dsd_samples / 2);
+		this->alloc_pcm_temp1(dsd_samples);
+		this->alloc_pcm_temp2(dsd_samples / 2);
 		dsd_fir1.init(flt_setup.get_fir1_8_ctables(), flt_setup.get_fir1_8_length(), 8);
 		pcm_fir2a.init(flt_setup.get_fir2_2_coefs(), flt_setup.get_fir2_2_length(), 2);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = (dsd_fir1.get_delay() / pcm_fir2a.get_decimation() + pcm_fir2a.get_delay()) / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir2a.run(pcm_temp1, pcm_temp2, pcm_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp2, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir2a.run(this->pcm_temp1, this->pcm_temp2, pcm_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp2, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -199,15 +199,15 @@ class DSDPCMConverterMultistage_x16 : public DSDPCMConverterMultistage<real_t> {
 	PCMPCMFir<real_t> pcm_fir3;
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
-		alloc_pcm_temp1(dsd_samples);
+		this->alloc_pcm_temp1(dsd_samples);
 		dsd_fir1.init(flt_setup.get_fir1_8_ctables(), flt_setup.get_fir1_8_length(), 8);
 		pcm_fir3.init(flt_setup.get_fir3_2_coefs(), flt_setup.get_fir3_2_length(), 2);
-		delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
+		this->delay = dsd_fir1.get_delay() / pcm_fir3.get_decimation() + pcm_fir3.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
-		pcm_samples = dsd_fir1.run(dsd_data, pcm_temp1, dsd_samples);
-		pcm_samples = pcm_fir3.run(pcm_temp1, m_pcm_data, pcm_samples);
+		pcm_samples = dsd_fir1.run(dsd_data, this->pcm_temp1, dsd_samples);
+		pcm_samples = pcm_fir3.run(this->pcm_temp1, m_pcm_data, pcm_samples);
 		return pcm_samples;
 	}
 };
@@ -218,7 +218,7 @@ class DSDPCMConverterMultistage_x8 : public DSDPCMConverterMultistage<real_t> {
 public:
 	void init(DSDPCMFilterSetup<real_t>& flt_setup, int dsd_samples) {
 		dsd_fir1.init(flt_setup.get_fir1_8_ctables(), flt_setup.get_fir1_8_length(), 8);
-		delay = dsd_fir1.get_delay();
+		this->delay = dsd_fir1.get_delay();
 	}
 	int convert(uint8_t* dsd_data, real_t* m_pcm_data, int dsd_samples) {
 		int pcm_samples;
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <math.h>
 #include "DSDPCMConstants.h"
 #include "DSDPCMUtil.h"
 
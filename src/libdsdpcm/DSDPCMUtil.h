@@ -28,7 +28,14 @@ class DSDPCMUtil {
 	static constexpr int MEM_ALIGN = 64;
 public:
 	static void* mem_alloc(size_t size) {
+#ifdef _WIN32
 		auto memory = _aligned_malloc(size, MEM_ALIGN);
+#else
+		void* memory = nullptr;
+		if (posix_memalign(&memory, MEM_ALIGN, size) != 0) {
+			memory = nullptr;
+		}
+#endif
 		if (memory) {
 			memset(memory, 0, size);
 		}
@@ -36,7 +43,11 @@ public:
 	}
 	static void mem_free(void* memory) {
 		if (memory) {
+#ifdef _WIN32
 			_aligned_free(memory);
+#else
+			free(memory);
+#endif
 		}
 	}
 };
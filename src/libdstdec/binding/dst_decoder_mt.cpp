@@ -48,6 +48,14 @@ int log_printf(char* fmt, ...) {
 
 #define LOG(p1, p2)
 
+int log_printf(char* fmt, ...) {
+	va_list vl;
+	va_start(vl, fmt);
+	vfprintf(stderr, fmt, vl);
+	va_end(vl);
+	return 0;
+}
+
 #endif
 
 void dst_run_thread(frame_slot_t* slot) {
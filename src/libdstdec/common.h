@@ -12,11 +12,11 @@ extern int log_printf(char* fmt, ...);
 
 namespace dst {
 
-auto GET_BIT = [](auto base, auto index) {
+static auto GET_BIT = [](auto base, auto index) {
 	return (((unsigned char*)base)[index >> 3] >> (7 - (index & 7))) & 1;
 };
 
-auto GET_NIBBLE = [](auto base, auto index) {
+static auto GET_NIBBLE = [](auto base, auto index) {
 	return (((unsigned char*)base)[index >> 1] >> ((index & 1) << 2)) & 0x0f;
 };
 
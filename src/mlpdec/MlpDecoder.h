@@ -133,8 +133,12 @@ typedef struct MLPDecodeContext {
     int         filter_changed[MAX_CHANNELS][NUM_FILTERS];
 
     int8_t      noise_buffer[MAX_BLOCKSIZE_POW2];
-    int8_t      bypassed_lsbs[MAX_BLOCKSIZE][MAX_CHANNELS];
-    int32_t     sample_buffer[MAX_BLOCKSIZE][MAX_CHANNELS];
+    //! Channel-planar, each row is a whole number of cache lines.
+    DECLARE_ALIGNED(64, int8_t, bypassed_lsbs)[MAX_MATRICES][MAX_BLOCKSIZE];
+    DECLARE_ALIGNED(64, int32_t, sample_buffer)[MAX_CHANNELS][MAX_BLOCKSIZE];
 
     DSPContext  dsp;
+
+    //! Parity, checksum and lossless check results since the decoder was set up.
+    MLPIntegrity integrity;
 } MLPDecodeContext;
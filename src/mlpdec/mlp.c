@@ -21,7 +21,6 @@
 
 #include <stdint.h>
 
-#include "libavutil/crc.h"
 #include "libavutil/intreadwrite.h"
 #include "mlp.h"
 
@@ -42,21 +41,101 @@ const uint8_t ff_mlp_huffman_tables[3][18][2] = {
 };
 
 static int crc_init = 0;
-#if CONFIG_SMALL
-#define CRC_TABLE_SIZE 257
-#else
-#define CRC_TABLE_SIZE 1024
-#endif
-static AVCRC crc_63[CRC_TABLE_SIZE];
-static AVCRC crc_1D[CRC_TABLE_SIZE];
-static AVCRC crc_2D[CRC_TABLE_SIZE];
+static MLPCRC crc_63;
+static MLPCRC crc_1D;
+static MLPCRC crc_2D;
+
+static uint32_t mlp_crc_c(const MLPCRC *ctx, uint32_t crc, const uint8_t *buf, size_t buf_size)
+{
+    const uint16_t (*t)[256] = ctx->table;
+    const uint32_t mask = (1 << ctx->bits) - 1;
+
+    for (; buf_size >= 8; buf += 8, buf_size -= 8) {
+        uint32_t hi = AV_RB32(buf) ^ (crc << (32 - ctx->bits));
+        uint32_t lo = AV_RB32(buf + 4);
+        crc = t[7][hi >> 24] ^ t[6][(hi >> 16) & 0xff] ^ t[5][(hi >> 8) & 0xff] ^ t[4][hi & 0xff]
+            ^ t[3][lo >> 24] ^ t[2][(lo >> 16) & 0xff] ^ t[1][(lo >> 8) & 0xff] ^ t[0][lo & 0xff];
+    }
+    for (; buf_size > 0; buf_size--)
+        crc = t[0][(crc >> (ctx->bits - 8)) ^ *buf++] ^ ((crc << 8) & mask);
+
+    return crc;
+}
+
+static uint8_t mlp_calculate_parity_c(const uint8_t *buf, unsigned int buf_size)
+{
+    uint32_t scratch = 0;
+    const uint8_t *buf_end = buf + buf_size;
+
+    for (; ((intptr_t) buf & 3) && buf < buf_end; buf++)
+        scratch ^= *buf;
+    for (; buf < buf_end - 3; buf += 4)
+        scratch ^= *((const uint32_t*)buf);
+
+    scratch = xor_32_to_8(scratch);
+
+    for (; buf < buf_end; buf++)
+        scratch ^= *buf;
+
+    return scratch;
+}
+
+static MLPCRCContext crc_dsp = { mlp_crc_c, mlp_calculate_parity_c };
+
+/** Multiply r by x^n modulo the generator. */
+static uint32_t crc_mul_xpow(const MLPCRC *ctx, uint32_t r, int n)
+{
+    while (n-- > 0) {
+        r <<= 1;
+        if (r >> ctx->bits)
+            r ^= ctx->poly;
+    }
+    return r;
+}
+
+static av_cold void crc_init_table(MLPCRC *ctx, int bits, uint32_t poly)
+{
+    uint32_t r;
+    int i, b;
+
+    ctx->bits = bits;
+    ctx->poly = (1 << bits) | poly;
+
+    for (b = 0; b < 256; b++) {
+        r = crc_mul_xpow(ctx, b, bits);
+        for (i = 0; i < 8; i++) {
+            ctx->table[i][b] = r;
+            r = crc_mul_xpow(ctx, r, 8);
+        }
+    }
+
+    ctx->fold_16[0] = crc_mul_xpow(ctx, 1, 128);
+    ctx->fold_16[1] = crc_mul_xpow(ctx, 1, 192);
+    ctx->fold_64[0] = crc_mul_xpow(ctx, 1, 512);
+    ctx->fold_64[1] = crc_mul_xpow(ctx, 1, 576);
+    ctx->reduce     = crc_mul_xpow(ctx, 1,  64);
+
+    /* Long division of x^(64 + bits); the quotient's x^64 term is implied. */
+    ctx->barrett = 0;
+    r = 0;
+    for (i = 64 + bits; i >= 0; i--) {
+        r = (r << 1) | (i == 64 + bits);
+        if (r >> bits) {
+            r ^= ctx->poly;
+            if (i < 64)
+                ctx->barrett |= 1ULL << i;
+        }
+    }
+}
 
 av_cold void ff_mlp_init_crc(void)
 {
     if (!crc_init) {
-        av_crc_init(crc_63, 0,  8,   0x63, sizeof(crc_63));
-        av_crc_init(crc_1D, 0,  8,   0x1D, sizeof(crc_1D));
-        av_crc_init(crc_2D, 0, 16, 0x002D, sizeof(crc_2D));
+        crc_init_table(&crc_63,  8,   0x63);
+        crc_init_table(&crc_1D,  8,   0x1D);
+        crc_init_table(&crc_2D, 16, 0x002D);
+        if (ARCH_X86)
+            ff_mlp_init_crc_x86(&crc_dsp);
         crc_init = 1;
     }
 }
@@ -65,14 +144,15 @@ uint16_t ff_mlp_checksum16(const uint8_t *buf, unsigned int buf_size)
 {
     uint16_t crc;
 
-    crc = av_crc(crc_2D, 0, buf, buf_size - 2);
+    /* The stored checksum is little-endian. */
+    crc = bswap_16(crc_dsp.crc(&crc_2D, 0, buf, buf_size - 2));
     crc ^= AV_RL16(buf + buf_size - 2);
     return crc;
 }
 
 uint8_t ff_mlp_checksum8(const uint8_t *buf, unsigned int buf_size)
 {
-    uint8_t checksum = av_crc(crc_63, 0x3c, buf, buf_size - 1); // crc_63[0xa2] == 0x3c
+    uint8_t checksum = crc_dsp.crc(&crc_63, 0x3c, buf, buf_size - 1); // crc_63[0xa2] == 0x3c
     checksum ^= buf[buf_size-1];
     return checksum;
 }
@@ -82,8 +162,8 @@ uint8_t ff_mlp_restart_checksum(const uint8_t *buf, unsigned int bit_size)
     int i;
     int num_bytes = (bit_size + 2) / 8;
 
-    int crc = crc_1D[buf[0] & 0x3f];
-    crc = av_crc(crc_1D, crc, buf + 1, num_bytes - 2);
+    int crc = crc_1D.table[0][buf[0] & 0x3f];
+    crc = crc_dsp.crc(&crc_1D, crc, buf + 1, num_bytes - 2);
     crc ^= buf[num_bytes - 1];
 
     for (i = 0; i < ((bit_size + 2) & 7); i++) {
@@ -98,18 +178,5 @@ uint8_t ff_mlp_restart_checksum(const uint8_t *buf, unsigned int bit_size)
 
 uint8_t ff_mlp_calculate_parity(const uint8_t *buf, unsigned int buf_size)
 {
-    uint32_t scratch = 0;
-    const uint8_t *buf_end = buf + buf_size;
-
-    for (; ((intptr_t) buf & 3) && buf < buf_end; buf++)
-        scratch ^= *buf;
-    for (; buf < buf_end - 3; buf += 4)
-        scratch ^= *((const uint32_t*)buf);
-
-    scratch = xor_32_to_8(scratch);
-
-    for (; buf < buf_end; buf++)
-        scratch ^= *buf;
-
-    return scratch;
+    return crc_dsp.calculate_parity(buf, buf_size);
 }
@@ -96,9 +96,42 @@ typedef struct {
  */
 extern const uint8_t ff_mlp_huffman_tables[3][18][2];
 
+/** An MSB-first CRC with a generator of at most 16 bits. The C version runs
+ *  on slice-by-8 tables; the PCLMULQDQ version folds the buffer 16 bytes at
+ *  a time with the fold constants and finishes with a Barrett reduction.
+ */
+typedef struct MLPCRC {
+    int      bits;
+    uint32_t poly;              ///< generator, including its x^bits term
+    uint16_t table[8][256];     ///< table[i][b] = b * x^(8 * i + bits) mod poly
+    uint64_t fold_16[2];        ///< x^128 and x^192 mod poly
+    uint64_t fold_64[2];        ///< x^512 and x^576 mod poly
+    uint64_t reduce;            ///< x^64 mod poly
+    uint64_t barrett;           ///< floor(x^(64 + bits) / poly) without its x^64 term
+} MLPCRC;
+
+typedef struct MLPCRCContext {
+    uint32_t (*crc)(const MLPCRC *ctx, uint32_t crc, const uint8_t *buf, size_t buf_size);
+    uint8_t  (*calculate_parity)(const uint8_t *buf, unsigned int buf_size);
+} MLPCRCContext;
+
+void ff_mlp_init_crc_x86(MLPCRCContext *c);
+
+/** Outcome of the checks carried in the stream, kept for the caller to
+ *  report instead of only being logged.
+ */
+typedef struct MLPIntegrity {
+    unsigned int access_units;      ///< access units whose header parity was verified
+    unsigned int parity_errors;     ///< failed access unit and substream parity checks
+    unsigned int checksums;         ///< restart header and substream checksums verified
+    unsigned int checksum_errors;
+    unsigned int lossless_checks;   ///< decoded output verified against a restart header
+    unsigned int lossless_errors;
+} MLPIntegrity;
+
 /** MLP uses checksums that seem to be based on the standard CRC algorithm, but
  *  are not (in implementation terms, the table lookup and XOR are reversed).
- *  We can implement this behavior using a standard av_crc on all but the
+ *  We can implement this behavior using a standard CRC on all but the
  *  last element, then XOR that with the last element.
  */
 uint8_t  ff_mlp_checksum8 (const uint8_t *buf, unsigned int buf_size);
@@ -109,9 +142,7 @@ uint16_t ff_mlp_checksum16(const uint8_t *buf, unsigned int buf_size);
  */
 uint8_t ff_mlp_restart_checksum(const uint8_t *buf, unsigned int bit_size);
 
-/** XOR together all the bytes of a buffer.
- *  Does this belong in dspcontext?
- */
+/** XOR together all the bytes of a buffer. */
 uint8_t ff_mlp_calculate_parity(const uint8_t *buf, unsigned int buf_size);
 
 void ff_mlp_init_crc(void);
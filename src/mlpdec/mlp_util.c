@@ -245,87 +245,6 @@ int init_vlc_sparse(VLC *vlc, int nb_bits, int nb_codes,
     return 0;
 }
 
-/*****************************************************************************/
-/***   crc.c                                                               ***/
-/*****************************************************************************/
-
-/**
- * Initializes a CRC table.
- * @param ctx must be an array of size sizeof(AVCRC)*257 or sizeof(AVCRC)*1024
- * @param cts_size size of ctx in bytes
- * @param le If 1, the lowest bit represents the coefficient for the highest
- *           exponent of the corresponding polynomial (both for poly and
- *           actual CRC).
- *           If 0, you must swap the CRC parameter and the result of av_crc
- *           if you need the standard representation (can be simplified in
- *           most cases to e.g. bswap16):
- *           bswap_32(crc << (32-bits))
- * @param bits number of bits for the CRC
- * @param poly generator polynomial without the x**bits coefficient, in the
- *             representation as specified by le
- * @return <0 on failure
- */
-int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size){
-    int i, j;
-    uint32_t c;
-
-    if (bits < 8 || bits > 32 || poly >= (1LL<<bits))
-        return -1;
-    if (ctx_size != sizeof(AVCRC)*257 && ctx_size != sizeof(AVCRC)*1024)
-        return -1;
-
-    for (i = 0; i < 256; i++) {
-        if (le) {
-            for (c = i, j = 0; j < 8; j++)
-                c = (c>>1)^(poly & (-(c&1)));
-            ctx[i] = c;
-        } else {
-            for (c = i << 24, j = 0; j < 8; j++)
-                c = (c<<1) ^ ((poly<<(32-bits)) & (((int32_t)c)>>31) );
-            ctx[i] = bswap_32(c);
-        }
-    }
-    ctx[256]=1;
-#if !CONFIG_SMALL
-    if(ctx_size >= sizeof(AVCRC)*1024)
-        for (i = 0; i < 256; i++)
-            for(j=0; j<3; j++)
-                ctx[256*(j+1) + i]= (ctx[256*j + i]>>8) ^ ctx[ ctx[256*j + i]&0xFF ];
-#endif
-
-    return 0;
-}
-
-/**
- * Calculates the CRC of a block.
- * @param crc CRC of previous blocks if any or initial value for CRC
- * @return CRC updated with the data from the given block
- *
- * @see av_crc_init() "le" parameter
- */
-uint32_t av_crc(const AVCRC *ctx, uint32_t crc, const uint8_t *buffer, size_t length){
-    const uint8_t *end= buffer+length;
-
-#if !CONFIG_SMALL
-    if(!ctx[256]) {
-        while(((intptr_t) buffer & 3) && buffer < end)
-            crc = ctx[((uint8_t)crc) ^ *buffer++] ^ (crc >> 8);
-
-        while(buffer<end-3){
-            crc ^= le2me_32(*(const uint32_t*)buffer); buffer+=4;
-            crc =  ctx[3*256 + ( crc     &0xFF)]
-                  ^ctx[2*256 + ((crc>>8 )&0xFF)]
-                  ^ctx[1*256 + ((crc>>16)&0xFF)]
-                  ^ctx[0*256 + ((crc>>24)     )];
-        }
-    }
-#endif
-    while(buffer<end)
-        crc = ctx[((uint8_t)crc) ^ *buffer++] ^ (crc >> 8);
-
-    return crc;
-}
-
 /*****************************************************************************/
 /***   log.h                                                               ***/
 /*****************************************************************************/
@@ -492,6 +411,3 @@ void* ff_realloc_static(void* ptr, unsigned int size) {
 void dsputil_init(DSPContext* p, AVCodecContext *avctx) {
 	 ff_mlp_init(p, avctx);
 }
-
-void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx) {
-}
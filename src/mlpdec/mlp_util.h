@@ -83,6 +83,11 @@ static inline uint64_t bswap_64(uint64_t x) {
 #define FFMAX(a, b) ((a) > (b) ? (a) : (b))
 #define FFMIN(a, b) ((a) > (b) ? (b) : (a))
 #define av_cold
+#if defined(_MSC_VER)
+#define DECLARE_ALIGNED(n,t,v) __declspec(align(n)) t v
+#else
+#define DECLARE_ALIGNED(n,t,v) t __attribute__ ((aligned (n))) v
+#endif
 
 /*****************************************************************************/
 /***   intreadwrite.h                                                      ***/
@@ -588,25 +593,6 @@ static inline int get_vlc2(GetBitContext *s, VLC_TYPE (*table)[2],
     return code;
 }
 
-/*****************************************************************************/
-/***   crc.h                                                               ***/
-/*****************************************************************************/
-
-typedef uint32_t AVCRC;
-
-typedef enum {
-	AV_CRC_8_ATM,
-	AV_CRC_16_ANSI,
-	AV_CRC_16_CCITT,
-	AV_CRC_32_IEEE,
-	AV_CRC_32_IEEE_LE,  /* reversed bitorder version of AV_CRC_32_IEEE */
-	AV_CRC_MAX,         /* not part of public API! don't use outside lavu */
-} AVCRCId;
-
-int av_crc_init(AVCRC* ctx, int le, int bits, uint32_t poly, int ctx_size);
-const AVCRC* av_crc_get_table(AVCRCId crc_id);
-uint32_t av_crc(const AVCRC* ctx, uint32_t start_crc, const uint8_t* buffer, size_t length);
-
 /*****************************************************************************/
 /***   log.h                                                               ***/
 /*****************************************************************************/
@@ -686,6 +672,15 @@ typedef struct DSPContext {
                                int firorder, int iirorder,
                                unsigned int filter_shift, int32_t mask, int blocksize,
                                int32_t *sample_buffer);
+    void (*mlp_rematrix_channel)(int32_t *samples, const int32_t *coeffs,
+                                 const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                                 int index, unsigned int dest_ch, uint16_t blockpos,
+                                 unsigned int maxchan, int matrix_noise_shift,
+                                 int access_unit_size_pow2, int32_t mask);
+    int32_t (*mlp_pack_output)(int32_t lossless_check_data, uint16_t blockpos,
+                               const int32_t *sample_buffer, void *data,
+                               const uint8_t *ch_assign, const int8_t *output_shift,
+                               unsigned int max_matrix_channel, int is32);
 } DSPContext;
 
 void dsputil_init(DSPContext* p, AVCodecContext *avctx);
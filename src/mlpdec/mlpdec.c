@@ -143,28 +143,47 @@ typedef struct MLPDecodeContext {
     int         filter_changed[MAX_CHANNELS][NUM_FILTERS];
 
     int8_t      noise_buffer[MAX_BLOCKSIZE_POW2];
-    int8_t      bypassed_lsbs[MAX_BLOCKSIZE][MAX_CHANNELS];
-    int32_t     sample_buffer[MAX_BLOCKSIZE][MAX_CHANNELS];
+    //! Channel-planar, each row is a whole number of cache lines.
+    DECLARE_ALIGNED(64, int8_t, bypassed_lsbs)[MAX_MATRICES][MAX_BLOCKSIZE];
+    DECLARE_ALIGNED(64, int32_t, sample_buffer)[MAX_CHANNELS][MAX_BLOCKSIZE];
 
     DSPContext  dsp;
+
+    //! Parity, checksum and lossless check results since the decoder was set up.
+    MLPIntegrity integrity;
 } MLPDecodeContext;
 
-static VLC huff_vlc[3];
+/** Residual VLC lookup: symbol and code length for every VLC_BITS-bit prefix,
+ *  a zero length marks an invalid code. */
+typedef struct MLPHuffEntry {
+    int8_t      symbol;
+    uint8_t     length;
+} MLPHuffEntry;
+
+static MLPHuffEntry huff_lut[3][1 << VLC_BITS];
 
 /** Initialize static data, constant between all invocations of the codec. */
 
 static av_cold void init_static(void)
 {
-    if (!huff_vlc[0].bits) {
-        INIT_VLC_STATIC(&huff_vlc[0], VLC_BITS, 18,
-                    &ff_mlp_huffman_tables[0][0][1], 2, 1,
-                    &ff_mlp_huffman_tables[0][0][0], 2, 1, 512);
-        INIT_VLC_STATIC(&huff_vlc[1], VLC_BITS, 16,
-                    &ff_mlp_huffman_tables[1][0][1], 2, 1,
-                    &ff_mlp_huffman_tables[1][0][0], 2, 1, 512);
-        INIT_VLC_STATIC(&huff_vlc[2], VLC_BITS, 15,
-                    &ff_mlp_huffman_tables[2][0][1], 2, 1,
-                    &ff_mlp_huffman_tables[2][0][0], 2, 1, 512);
+    static const int huff_codes[3] = { 18, 16, 15 };
+    int book, sym, i;
+
+    if (!huff_lut[0][(1 << VLC_BITS) - 1].length) {
+        for (book = 0; book < 3; book++) {
+            for (i = 0; i < 1 << VLC_BITS; i++) {
+                huff_lut[book][i].symbol = -1;
+                huff_lut[book][i].length = 0;
+            }
+            for (sym = 0; sym < huff_codes[book]; sym++) {
+                int code = ff_mlp_huffman_tables[book][sym][0];
+                int len  = ff_mlp_huffman_tables[book][sym][1];
+                for (i = 0; i < 1 << (VLC_BITS - len); i++) {
+                    huff_lut[book][(code << (VLC_BITS - len)) | i].symbol = sym;
+                    huff_lut[book][(code << (VLC_BITS - len)) | i].length = len;
+                }
+            }
+        }
     }
 
     ff_mlp_init_crc();
@@ -188,18 +207,75 @@ static inline int32_t calculate_sign_huff(MLPDecodeContext *m,
     return sign_huff_offset;
 }
 
+/** Bit reader for the residual loop. The cache holds the next bits MSB first
+ *  and is topped up to at least 57 bits, enough for the bypassed LSBs of one
+ *  sample or for one residual: a VLC_BITS code plus up to 24 LSBs. */
+typedef struct MLPBitReader {
+    const uint8_t *buffer, *ptr, *end;
+    uint64_t    cache;
+    int         left;
+} MLPBitReader;
+
+static inline void mlp_br_refill(MLPBitReader *br)
+{
+    if (br->end - br->ptr >= 8) {
+        uint64_t bits;
+        memcpy(&bits, br->ptr, sizeof(bits));
+        br->cache |= be2me_64(bits) >> br->left;
+        br->ptr   += (63 - br->left) >> 3;
+        br->left  |= 56;
+    } else {
+        /* zeros past the end, the bit count still tells how far it was read */
+        while (br->left <= 56) {
+            br->cache |= (uint64_t) (br->ptr < br->end ? *br->ptr : 0) << (56 - br->left);
+            br->ptr++;
+            br->left += 8;
+        }
+    }
+}
+
+static inline void mlp_br_init(MLPBitReader *br, GetBitContext *gbp)
+{
+    int index = get_bits_count(gbp);
+
+    br->buffer = gbp->buffer;
+    br->ptr    = gbp->buffer + (index >> 3);
+    br->end    = gbp->buffer_end;
+    br->cache  = 0;
+    br->left   = 0;
+    mlp_br_refill(br);
+    br->cache <<= index & 7;
+    br->left   -= index & 7;
+}
+
+static inline void mlp_br_close(MLPBitReader *br, GetBitContext *gbp)
+{
+    skip_bits_long(gbp, (int) (br->ptr - br->buffer) * 8 - br->left - get_bits_count(gbp));
+}
+
+static inline void mlp_br_skip(MLPBitReader *br, int n)
+{
+    br->cache <<= n;
+    br->left   -= n;
+}
+
 /** Read a sample, consisting of either, both or neither of entropy-coded MSBs
- *  and plain LSBs. */
+ *  and plain LSBs. The VLC and the LSBs that follow it are taken from one
+ *  look at the cache. */
 
-static inline int read_huff_channels(MLPDecodeContext *m, GetBitContext *gbp,
+static inline int read_huff_channels(MLPDecodeContext *m, MLPBitReader *br,
                                      unsigned int substr, unsigned int pos)
 {
     SubStream *s = &m->substream[substr];
     unsigned int mat, channel;
 
+    if (br->left < MAX_MATRICES)
+        mlp_br_refill(br);
     for (mat = 0; mat < s->num_primitive_matrices; mat++)
-        if (s->lsb_bypass[mat])
-            m->bypassed_lsbs[pos + s->blockpos][mat] = get_bits1(gbp);
+        if (s->lsb_bypass[mat]) {
+            m->bypassed_lsbs[mat][pos + s->blockpos] = (int8_t) (br->cache >> 63);
+            mlp_br_skip(br, 1);
+        }
 
     for (channel = s->min_channel; channel <= s->max_channel; channel++) {
         ChannelParams *cp = &m->channel_params[channel];
@@ -207,21 +283,29 @@ static inline int read_huff_channels(MLPDecodeContext *m, GetBitContext *gbp,
         int quant_step_size = s->quant_step_size[channel];
         int lsb_bits = cp->huff_lsbs - quant_step_size;
         int result = 0;
+        int length = 0;
 
-        if (codebook > 0)
-            result = get_vlc2(gbp, huff_vlc[codebook-1].table,
-                            VLC_BITS, (9 + VLC_BITS - 1) / VLC_BITS);
+        if (br->left < VLC_BITS + 24)
+            mlp_br_refill(br);
 
-        if (result < 0)
-            return -1;
+        if (codebook > 0) {
+            const MLPHuffEntry *e = &huff_lut[codebook-1][br->cache >> (64 - VLC_BITS)];
+            if (!e->length)
+                return -1;
+            result = e->symbol;
+            length = e->length;
+        }
 
-        if (lsb_bits > 0)
-            result = (result << lsb_bits) + get_bits(gbp, lsb_bits);
+        if (lsb_bits > 0) {
+            result  = (result << lsb_bits) + (int) ((br->cache << length) >> (64 - lsb_bits));
+            length += lsb_bits;
+        }
+        mlp_br_skip(br, length);
 
         result  += cp->sign_huff_offset;
         result <<= quant_step_size;
 
-        m->sample_buffer[pos + s->blockpos][channel] = result;
+        m->sample_buffer[channel][pos + s->blockpos] = result;
     }
 
     return 0;
@@ -416,10 +500,13 @@ static int read_restart_header(MLPDecodeContext *m, GetBitContext *gbp,
     if (substr == m->max_decoded_substream
         && s->lossless_check_data != 0xffffffff) {
         tmp = xor_32_to_8(s->lossless_check_data);
-        if (tmp != lossless_check)
+        m->integrity.lossless_checks++;
+        if (tmp != lossless_check) {
+            m->integrity.lossless_errors++;
             av_log(m->avctx, AV_LOG_WARNING,
                    "Lossless check failed - expected %02x, calculated %02x.\n",
                    lossless_check, tmp);
+        }
     }
 
     skip_bits(gbp, 16);
@@ -439,8 +526,11 @@ static int read_restart_header(MLPDecodeContext *m, GetBitContext *gbp,
 
     checksum = ff_mlp_restart_checksum(buf, get_bits_count(gbp) - start_count);
 
-    if (checksum != get_bits(gbp, 8))
+    m->integrity.checksums++;
+    if (checksum != get_bits(gbp, 8)) {
+        m->integrity.checksum_errors++;
         av_log(m->avctx, AV_LOG_ERROR, "restart header checksum error\n");
+    }
 
     /* Set default decoding parameters. */
     s->param_presence_flags   = 0xff;
@@ -738,7 +828,7 @@ static void filter_channel(MLPDecodeContext *m, unsigned int substr,
     m->dsp.mlp_filter_channel(firbuf, fircoeff,
                               fir->order, iir->order,
                               filter_shift, mask, s->blocksize,
-                              &m->sample_buffer[s->blockpos][channel]);
+                              &m->sample_buffer[channel][s->blockpos]);
 
     memcpy(fir->state, firbuf - s->blocksize, MAX_FIR_ORDER * sizeof(int32_t));
     memcpy(iir->state, iirbuf - s->blocksize, MAX_IIR_ORDER * sizeof(int32_t));
@@ -750,7 +840,8 @@ static int read_block_data(MLPDecodeContext *m, GetBitContext *gbp,
                            unsigned int substr)
 {
     SubStream *s = &m->substream[substr];
-    unsigned int i, ch, expected_stream_pos = 0;
+    MLPBitReader br;
+    unsigned int i, ch, mat, expected_stream_pos = 0;
 
     if (s->data_check_present) {
         expected_stream_pos  = get_bits_count(gbp);
@@ -764,12 +855,15 @@ static int read_block_data(MLPDecodeContext *m, GetBitContext *gbp,
         return -1;
     }
 
-    memset(&m->bypassed_lsbs[s->blockpos][0], 0,
-           s->blocksize * sizeof(m->bypassed_lsbs[0]));
+    for (mat = 0; mat < MAX_MATRICES; mat++)
+        memset(&m->bypassed_lsbs[mat][s->blockpos], 0,
+               s->blocksize * sizeof(m->bypassed_lsbs[0][0]));
 
+    mlp_br_init(&br, gbp);
     for (i = 0; i < s->blocksize; i++)
-        if (read_huff_channels(m, gbp, substr, i) < 0)
+        if (read_huff_channels(m, &br, substr, i) < 0)
             return -1;
+    mlp_br_close(&br, gbp);
 
     for (ch = s->min_channel; ch <= s->max_channel; ch++)
         filter_channel(m, substr, ch);
@@ -825,8 +919,8 @@ static void generate_2_noise_channels(MLPDecodeContext *m, unsigned int substr)
 
     for (i = 0; i < s->blockpos; i++) {
         uint16_t seed_shr7 = seed >> 7;
-        m->sample_buffer[i][maxchan+1] = ((int8_t)(seed >> 15)) << s->noise_shift;
-        m->sample_buffer[i][maxchan+2] = ((int8_t) seed_shr7)   << s->noise_shift;
+        m->sample_buffer[maxchan+1][i] = ((int8_t)(seed >> 15)) << s->noise_shift;
+        m->sample_buffer[maxchan+2][i] = ((int8_t) seed_shr7)   << s->noise_shift;
 
         seed = (seed << 16) ^ seed_shr7 ^ (seed_shr7 << 5);
     }
@@ -858,7 +952,7 @@ static void fill_noise_buffer(MLPDecodeContext *m, unsigned int substr)
 static void rematrix_channels(MLPDecodeContext *m, unsigned int substr)
 {
     SubStream *s = &m->substream[substr];
-    unsigned int mat, src_ch, i;
+    unsigned int mat;
     unsigned int maxchan;
 
     maxchan = s->max_matrix_channel;
@@ -870,31 +964,19 @@ static void rematrix_channels(MLPDecodeContext *m, unsigned int substr)
     }
 
     for (mat = 0; mat < s->num_primitive_matrices; mat++) {
-        int matrix_noise_shift = s->matrix_noise_shift[mat];
         unsigned int dest_ch = s->matrix_out_ch[mat];
-        int32_t mask = MSB_MASK(s->quant_step_size[dest_ch]);
-        int32_t *coeffs = s->matrix_coeff[mat];
-        int index  = s->num_primitive_matrices - mat;
-        int index2 = 2 * index + 1;
-
-        /* TODO: DSPContext? */
 
-        for (i = 0; i < s->blockpos; i++) {
-            int32_t bypassed_lsb = m->bypassed_lsbs[i][mat];
-            int32_t *samples = m->sample_buffer[i];
-            int64_t accum = 0;
-
-            for (src_ch = 0; src_ch <= maxchan; src_ch++)
-                accum += (int64_t) samples[src_ch] * coeffs[src_ch];
-
-            if (matrix_noise_shift) {
-                index &= m->access_unit_size_pow2 - 1;
-                accum += m->noise_buffer[index] << (matrix_noise_shift + 7);
-                index += index2;
-            }
-
-            samples[dest_ch] = ((accum >> 14) & mask) + bypassed_lsb;
-        }
+        m->dsp.mlp_rematrix_channel(&m->sample_buffer[0][0],
+                                    s->matrix_coeff[mat],
+                                    &m->bypassed_lsbs[mat][0],
+                                    m->noise_buffer,
+                                    s->num_primitive_matrices - mat,
+                                    dest_ch,
+                                    s->blockpos,
+                                    maxchan,
+                                    s->matrix_noise_shift[mat],
+                                    m->access_unit_size_pow2,
+                                    MSB_MASK(s->quant_step_size[dest_ch]));
     }
 }
 
@@ -904,25 +986,20 @@ static int output_data_internal(MLPDecodeContext *m, unsigned int substr,
                                 uint8_t *data, unsigned int *data_size, int is32)
 {
     SubStream *s = &m->substream[substr];
-    unsigned int i, out_ch = 0;
-    int32_t *data_32 = (int32_t*) data;
-    int16_t *data_16 = (int16_t*) data;
 
     if (*data_size < (s->max_channel + 1) * s->blockpos * (is32 ? 4 : 2))
         return -1;
 
-    for (i = 0; i < s->blockpos; i++) {
-        for (out_ch = 0; out_ch <= s->max_matrix_channel; out_ch++) {
-            int mat_ch = s->ch_assign[out_ch];
-            int32_t sample = m->sample_buffer[i][mat_ch]
-                          << s->output_shift[mat_ch];
-            s->lossless_check_data ^= (sample & 0xffffff) << mat_ch;
-            if (is32) *data_32++ = sample << 8;
-            else      *data_16++ = sample >> 8;
-        }
-    }
+    s->lossless_check_data = m->dsp.mlp_pack_output(s->lossless_check_data,
+                                                    s->blockpos,
+                                                    &m->sample_buffer[0][0],
+                                                    data,
+                                                    s->ch_assign,
+                                                    s->output_shift,
+                                                    s->max_matrix_channel,
+                                                    is32);
 
-    *data_size = i * out_ch * (is32 ? 4 : 2);
+    *data_size = s->blockpos * (s->max_matrix_channel + 1) * (is32 ? 4 : 2);
 
     return 0;
 }
@@ -1035,7 +1112,9 @@ static int read_access_unit(AVCodecContext *avctx, void* data, int *data_size,
     parity_bits  = ff_mlp_calculate_parity(buf, 4);
     parity_bits ^= ff_mlp_calculate_parity(buf + header_size, substr_header_size);
 
+    m->integrity.access_units++;
     if ((((parity_bits >> 4) ^ parity_bits) & 0xF) != 0xF) {
+        m->integrity.parity_errors++;
         av_log(avctx, AV_LOG_ERROR, "Parity check failed.\n");
         goto error;
     }
@@ -1103,10 +1182,15 @@ static int read_access_unit(AVCodecContext *avctx, void* data, int *data_size,
             parity   = ff_mlp_calculate_parity(buf, substream_data_len[substr] - 2);
             checksum = ff_mlp_checksum8       (buf, substream_data_len[substr] - 2);
 
-            if ((get_bits(&gb, 8) ^ parity) != 0xa9    )
+            m->integrity.checksums++;
+            if ((get_bits(&gb, 8) ^ parity) != 0xa9    ) {
+                m->integrity.parity_errors++;
                 av_log(m->avctx, AV_LOG_ERROR, "Substream %d parity check failed.\n", substr);
-            if ( get_bits(&gb, 8)           != checksum)
+            }
+            if ( get_bits(&gb, 8)           != checksum) {
+                m->integrity.checksum_errors++;
                 av_log(m->avctx, AV_LOG_ERROR, "Substream %d checksum failed.\n"    , substr);
+            }
         }
 
         if (substream_data_len[substr] * 8 != get_bits_count(&gb))
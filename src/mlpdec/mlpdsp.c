@@ -50,16 +50,67 @@ static void ff_mlp_filter_channel(int32_t *state, const int32_t *coeff,
         *--firbuf = result;
         *--iirbuf = result - accum;
 
-        *sample_buffer = result;
-        sample_buffer += MAX_CHANNELS;
+        *sample_buffer++ = result;
     }
 }
 
+/** samples and bypassed_lsbs are channel-planar, a row is MAX_BLOCKSIZE long */
+static void ff_mlp_rematrix_channel(int32_t *samples, const int32_t *coeffs,
+                                    const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                                    int index, unsigned int dest_ch, uint16_t blockpos,
+                                    unsigned int maxchan, int matrix_noise_shift,
+                                    int access_unit_size_pow2, int32_t mask)
+{
+    unsigned int src_ch, i;
+    int index2 = 2 * index + 1;
+
+    for (i = 0; i < blockpos; i++) {
+        int64_t accum = 0;
+
+        for (src_ch = 0; src_ch <= maxchan; src_ch++)
+            accum += (int64_t) samples[src_ch * MAX_BLOCKSIZE + i] * coeffs[src_ch];
+
+        if (matrix_noise_shift) {
+            index &= access_unit_size_pow2 - 1;
+            accum += noise_buffer[index] << (matrix_noise_shift + 7);
+            index += index2;
+        }
+
+        samples[dest_ch * MAX_BLOCKSIZE + i] = ((accum >> 14) & mask) + bypassed_lsbs[i];
+    }
+}
+
+/** Interleave the planar samples into the output, returning the updated lossless check. */
+static int32_t ff_mlp_pack_output(int32_t lossless_check_data, uint16_t blockpos,
+                                  const int32_t *sample_buffer, void *data,
+                                  const uint8_t *ch_assign, const int8_t *output_shift,
+                                  unsigned int max_matrix_channel, int is32)
+{
+    unsigned int i, out_ch;
+    int32_t *data_32 = (int32_t *) data;
+    int16_t *data_16 = (int16_t *) data;
+
+    for (i = 0; i < blockpos; i++) {
+        for (out_ch = 0; out_ch <= max_matrix_channel; out_ch++) {
+            int mat_ch = ch_assign[out_ch];
+            int32_t sample = sample_buffer[mat_ch * MAX_BLOCKSIZE + i]
+                          << output_shift[mat_ch];
+            lossless_check_data ^= (sample & 0xffffff) << mat_ch;
+            if (is32) *data_32++ = sample << 8;
+            else      *data_16++ = sample >> 8;
+        }
+    }
+
+    return lossless_check_data;
+}
+
 void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx);
 
 void ff_mlp_init(DSPContext* c, AVCodecContext *avctx)
 {
     c->mlp_filter_channel = ff_mlp_filter_channel;
+    c->mlp_rematrix_channel = ff_mlp_rematrix_channel;
+    c->mlp_pack_output = ff_mlp_pack_output;
     if (ARCH_X86)
         ff_mlp_init_x86(c, avctx);
 }
@@ -0,0 +1,472 @@
+/*
+ * MLP DSP functions x86-optimized
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include <intrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#include "libavcodec/mlp.h"
+#include "dsputil.h"
+
+/**
+ * Every output sample feeds the next one, so the filter cannot be run across
+ * samples. What can be taken off that chain is everything but the newest
+ * output and IIR state: while sample i is finished in scalar code, a pmuldq
+ * dot product of the older history against the remaining coefficients gives
+ * the part of the sum that sample i + 1 needs. The history stays in
+ * registers, newest first, coefficients past the filter order are zero and
+ * the products are summed in 64 bits exactly as the C version does.
+ */
+static inline void mlp_filter_channel_body_sse4(int32_t *state, const int32_t *coeff,
+                                                int firorder, int iirorder,
+                                                unsigned int filter_shift, int32_t mask, int blocksize,
+                                                int32_t *sample_buffer, const int has_iir)
+{
+    int32_t *firbuf = state;
+    int32_t *iirbuf = state + MAX_BLOCKSIZE + MAX_FIR_ORDER;
+    int32_t fircoeff[MAX_FIR_ORDER + 4] = { 0 };
+    int32_t iircoeff[MAX_IIR_ORDER + 4] = { 0 };
+    __m128i fir0, fir1, iir0;
+    __m128i fir0_even, fir0_odd, fir1_even, fir1_odd, iir0_even, iir0_odd;
+    int64_t older;
+    int32_t firnew, iirnew;
+    int i;
+
+    for (i = 0; i < firorder; i++)
+        fircoeff[i] = coeff[i];
+    for (i = 0; i < iirorder; i++)
+        iircoeff[i] = coeff[MAX_FIR_ORDER + i];
+    fir0_even = _mm_loadu_si128((const __m128i *)&fircoeff[1]);
+    fir1_even = _mm_loadu_si128((const __m128i *)&fircoeff[5]);
+    iir0_even = _mm_loadu_si128((const __m128i *)&iircoeff[1]);
+    fir0_odd  = _mm_srli_epi64(fir0_even, 32);
+    fir1_odd  = _mm_srli_epi64(fir1_even, 32);
+    iir0_odd  = _mm_srli_epi64(iir0_even, 32);
+
+    older = 0;
+    for (i = 1; i < MAX_FIR_ORDER; i++)
+        older += (int64_t) firbuf[i] * fircoeff[i];
+    for (i = 1; i < MAX_IIR_ORDER; i++)
+        older += (int64_t) iirbuf[i] * iircoeff[i];
+    firnew = firbuf[0];
+    iirnew = iirbuf[0];
+    fir0 = _mm_loadu_si128((const __m128i *)&firbuf[0]);
+    fir1 = _mm_loadu_si128((const __m128i *)&firbuf[4]);
+    iir0 = _mm_loadu_si128((const __m128i *)&iirbuf[0]);
+
+    for (i = 0; i < blocksize; i++) {
+        __m128i next;
+        int64_t accum;
+        int32_t residual = *sample_buffer;
+        int32_t result;
+
+        next = _mm_add_epi64(_mm_mul_epi32(fir0, fir0_even), _mm_mul_epi32(_mm_srli_epi64(fir0, 32), fir0_odd));
+        next = _mm_add_epi64(next, _mm_mul_epi32(fir1, fir1_even));
+        next = _mm_add_epi64(next, _mm_mul_epi32(_mm_srli_epi64(fir1, 32), fir1_odd));
+        if (has_iir) {
+            next = _mm_add_epi64(next, _mm_mul_epi32(iir0, iir0_even));
+            next = _mm_add_epi64(next, _mm_mul_epi32(_mm_srli_epi64(iir0, 32), iir0_odd));
+        }
+        next = _mm_add_epi64(next, _mm_unpackhi_epi64(next, next));
+
+        accum = older + (int64_t) firnew * fircoeff[0];
+        if (has_iir)
+            accum += (int64_t) iirnew * iircoeff[0];
+        accum  = accum >> filter_shift;
+        result = (int32_t)(accum + residual) & mask;
+        firnew = result;
+        iirnew = (int32_t)(result - accum);
+
+        fir1 = _mm_alignr_epi8(fir1, fir0, 12);
+        fir0 = _mm_or_si128(_mm_slli_si128(fir0, 4), _mm_cvtsi32_si128(firnew));
+        iir0 = _mm_or_si128(_mm_slli_si128(iir0, 4), _mm_cvtsi32_si128(iirnew));
+        _mm_storel_epi64((__m128i *)&older, next);
+
+        *sample_buffer++ = result;
+    }
+
+    /* the caller only reads back the newest MAX_FIR_ORDER / MAX_IIR_ORDER entries */
+    _mm_storeu_si128((__m128i *)&firbuf[-blocksize + 0], fir0);
+    _mm_storeu_si128((__m128i *)&firbuf[-blocksize + 4], fir1);
+    _mm_storeu_si128((__m128i *)&iirbuf[-blocksize], iir0);
+}
+
+static void mlp_filter_channel_sse4(int32_t *state, const int32_t *coeff,
+                                    int firorder, int iirorder,
+                                    unsigned int filter_shift, int32_t mask, int blocksize,
+                                    int32_t *sample_buffer)
+{
+    if (iirorder)
+        mlp_filter_channel_body_sse4(state, coeff, firorder, iirorder, filter_shift, mask, blocksize, sample_buffer, 1);
+    else
+        mlp_filter_channel_body_sse4(state, coeff, firorder, iirorder, filter_shift, mask, blocksize, sample_buffer, 0);
+}
+
+/**
+ * Samples are independent within one primitive matrix and the buffer is
+ * channel-planar, so four sample positions are loaded from every channel row
+ * and multiplied by the broadcast coefficient: pmuldq on the even and odd
+ * positions keeps all sums in 64 bits. Noise is added before the 2.14 shift,
+ * the same as the C version.
+ */
+static void mlp_rematrix_channel_sse4(int32_t *samples, const int32_t *coeffs,
+                                     const int8_t *bypassed_lsbs, const int8_t *noise_buffer,
+                                     int index, unsigned int dest_ch, uint16_t blockpos,
+                                     unsigned int maxchan, int matrix_noise_shift,
+                                     int access_unit_size_pow2, int32_t mask)
+{
+    __m128i matcoeff[MAX_CHANNELS];
+    __m128i vmask = _mm_set1_epi32(mask);
+    int32_t *dest = samples + dest_ch * MAX_BLOCKSIZE;
+    int index2 = 2 * index + 1;
+    unsigned int ch, i;
+
+    if (maxchan >= MAX_CHANNELS)
+        maxchan = MAX_CHANNELS - 1;
+    for (ch = 0; ch <= maxchan; ch++)
+        matcoeff[ch] = _mm_set1_epi32(coeffs[ch]);
+
+    for (i = 0; i + 4 <= blockpos; i += 4) {
+        __m128i accum_even = _mm_setzero_si128();
+        __m128i accum_odd  = _mm_setzero_si128();
+        __m128i accum;
+
+        for (ch = 0; ch <= maxchan; ch++) {
+            __m128i x = _mm_loadu_si128((const __m128i *)&samples[ch * MAX_BLOCKSIZE + i]);
+            accum_even = _mm_add_epi64(accum_even, _mm_mul_epi32(x, matcoeff[ch]));
+            accum_odd  = _mm_add_epi64(accum_odd,  _mm_mul_epi32(_mm_srli_epi64(x, 32), matcoeff[ch]));
+        }
+
+        if (matrix_noise_shift) {
+            int32_t noise[4];
+            int n;
+            for (n = 0; n < 4; n++) {
+                index &= access_unit_size_pow2 - 1;
+                noise[n] = noise_buffer[index] << (matrix_noise_shift + 7);
+                index += index2;
+            }
+            accum_even = _mm_add_epi64(accum_even, _mm_cvtepi32_epi64(_mm_set_epi32(0, 0, noise[2], noise[0])));
+            accum_odd  = _mm_add_epi64(accum_odd,  _mm_cvtepi32_epi64(_mm_set_epi32(0, 0, noise[3], noise[1])));
+        }
+
+        /* low dwords of the shifted even sums, odd sums moved up into the high dwords */
+        accum = _mm_blend_epi16(_mm_srli_epi64(accum_even, 14), _mm_slli_epi64(accum_odd, 32 - 14), 0xcc);
+        accum = _mm_add_epi32(_mm_and_si128(accum, vmask),
+                              _mm_cvtepi8_epi32(_mm_cvtsi32_si128(*(const int32_t *)&bypassed_lsbs[i])));
+        _mm_storeu_si128((__m128i *)&dest[i], accum);
+    }
+
+    for (; i < blockpos; i++) {
+        int64_t accum = 0;
+
+        for (ch = 0; ch <= maxchan; ch++)
+            accum += (int64_t) samples[ch * MAX_BLOCKSIZE + i] * coeffs[ch];
+
+        if (matrix_noise_shift) {
+            index &= access_unit_size_pow2 - 1;
+            accum += noise_buffer[index] << (matrix_noise_shift + 7);
+            index += index2;
+        }
+
+        dest[i] = ((accum >> 14) & mask) + bypassed_lsbs[i];
+    }
+}
+
+static inline __m128i mlp_pack_scale(__m128i x, int is32)
+{
+    if (is32)
+        return _mm_slli_epi32(x, 8);
+    /* keep the low 16 bits of sample >> 8 so that packssdw cannot saturate */
+    return _mm_srai_epi32(_mm_slli_epi32(x, 8), 16);
+}
+
+static inline void mlp_pack_store4(void *data, size_t pos, __m128i x, int is32)
+{
+    if (is32)
+        _mm_storeu_si128((__m128i *)((int32_t *)data + pos), x);
+    else
+        _mm_storel_epi64((__m128i *)((int16_t *)data + pos), _mm_packs_epi32(x, x));
+}
+
+static inline void mlp_pack_store2(void *data, size_t pos, __m128i x, int is32)
+{
+    if (is32)
+        _mm_storel_epi64((__m128i *)((int32_t *)data + pos), x);
+    else
+        *(int32_t *)((int16_t *)data + pos) = _mm_cvtsi128_si32(_mm_packs_epi32(x, x));
+}
+
+static inline void mlp_pack_store1(void *data, size_t pos, int32_t x, int is32)
+{
+    if (is32)
+        ((int32_t *)data)[pos] = x;
+    else
+        ((int16_t *)data)[pos] = (int16_t)x;
+}
+
+/**
+ * Four sample positions of every output channel are loaded from the planar
+ * buffer, shifted and folded into a per-channel lossless check, then
+ * transposed four channels at a time into interleaved order. Since the check
+ * XORs values shifted by their channel, each channel can be folded alone and
+ * shifted once at the end.
+ */
+static inline int32_t mlp_pack_output_body_sse4(int32_t lossless_check_data, uint16_t blockpos,
+                                                const int32_t *sample_buffer, void *data,
+                                                const uint8_t *ch_assign, const int8_t *output_shift,
+                                                unsigned int max_matrix_channel, const int is32)
+{
+    const unsigned int channels = max_matrix_channel + 1;
+    const __m128i mask24 = _mm_set1_epi32(0xffffff);
+    __m128i check[MAX_CHANNELS];
+    __m128i shift[MAX_CHANNELS];
+    __m128i v[MAX_CHANNELS];
+    unsigned int i, ch;
+
+    for (ch = 0; ch < channels; ch++) {
+        check[ch] = _mm_setzero_si128();
+        shift[ch] = _mm_cvtsi32_si128(output_shift[ch_assign[ch]]);
+    }
+
+    for (i = 0; i + 4 <= blockpos; i += 4) {
+        size_t pos = (size_t)i * channels;
+
+        for (ch = 0; ch < channels; ch++) {
+            __m128i x = _mm_sll_epi32(_mm_loadu_si128((const __m128i *)&sample_buffer[ch_assign[ch] * MAX_BLOCKSIZE + i]), shift[ch]);
+            check[ch] = _mm_xor_si128(check[ch], _mm_and_si128(x, mask24));
+            v[ch] = mlp_pack_scale(x, is32);
+        }
+
+        if (channels == 2) {
+            mlp_pack_store4(data, pos + 0, _mm_unpacklo_epi32(v[0], v[1]), is32);
+            mlp_pack_store4(data, pos + 4, _mm_unpackhi_epi32(v[0], v[1]), is32);
+            continue;
+        }
+
+        for (ch = 0; ch + 4 <= channels; ch += 4) {
+            __m128i t0 = _mm_unpacklo_epi32(v[ch + 0], v[ch + 1]);
+            __m128i t1 = _mm_unpacklo_epi32(v[ch + 2], v[ch + 3]);
+            __m128i t2 = _mm_unpackhi_epi32(v[ch + 0], v[ch + 1]);
+            __m128i t3 = _mm_unpackhi_epi32(v[ch + 2], v[ch + 3]);
+            mlp_pack_store4(data, pos + 0 * channels + ch, _mm_unpacklo_epi64(t0, t1), is32);
+            mlp_pack_store4(data, pos + 1 * channels + ch, _mm_unpackhi_epi64(t0, t1), is32);
+            mlp_pack_store4(data, pos + 2 * channels + ch, _mm_unpacklo_epi64(t2, t3), is32);
+            mlp_pack_store4(data, pos + 3 * channels + ch, _mm_unpackhi_epi64(t2, t3), is32);
+        }
+        if (ch + 2 <= channels) {
+            __m128i lo = _mm_unpacklo_epi32(v[ch], v[ch + 1]);
+            __m128i hi = _mm_unpackhi_epi32(v[ch], v[ch + 1]);
+            mlp_pack_store2(data, pos + 0 * channels + ch, lo, is32);
+            mlp_pack_store2(data, pos + 1 * channels + ch, _mm_srli_si128(lo, 8), is32);
+            mlp_pack_store2(data, pos + 2 * channels + ch, hi, is32);
+            mlp_pack_store2(data, pos + 3 * channels + ch, _mm_srli_si128(hi, 8), is32);
+            ch += 2;
+        }
+        if (ch < channels) {
+            mlp_pack_store1(data, pos + 0 * channels + ch, _mm_cvtsi128_si32(v[ch]), is32);
+            mlp_pack_store1(data, pos + 1 * channels + ch, _mm_extract_epi32(v[ch], 1), is32);
+            mlp_pack_store1(data, pos + 2 * channels + ch, _mm_extract_epi32(v[ch], 2), is32);
+            mlp_pack_store1(data, pos + 3 * channels + ch, _mm_extract_epi32(v[ch], 3), is32);
+        }
+    }
+
+    for (ch = 0; ch < channels; ch++) {
+        __m128i x = _mm_xor_si128(check[ch], _mm_srli_si128(check[ch], 8));
+        x = _mm_xor_si128(x, _mm_srli_si128(x, 4));
+        lossless_check_data ^= _mm_cvtsi128_si32(x) << ch_assign[ch];
+    }
+
+    for (; i < blockpos; i++) {
+        for (ch = 0; ch < channels; ch++) {
+            int mat_ch = ch_assign[ch];
+            int32_t sample = sample_buffer[mat_ch * MAX_BLOCKSIZE + i] << output_shift[mat_ch];
+            lossless_check_data ^= (sample & 0xffffff) << mat_ch;
+            if (is32) ((int32_t *)data)[(size_t)i * channels + ch] = sample << 8;
+            else      ((int16_t *)data)[(size_t)i * channels + ch] = sample >> 8;
+        }
+    }
+
+    return lossless_check_data;
+}
+
+static int32_t mlp_pack_output_sse4(int32_t lossless_check_data, uint16_t blockpos,
+                                    const int32_t *sample_buffer, void *data,
+                                    const uint8_t *ch_assign, const int8_t *output_shift,
+                                    unsigned int max_matrix_channel, int is32)
+{
+    if (is32)
+        return mlp_pack_output_body_sse4(lossless_check_data, blockpos, sample_buffer, data, ch_assign, output_shift, max_matrix_channel, 1);
+    else
+        return mlp_pack_output_body_sse4(lossless_check_data, blockpos, sample_buffer, data, ch_assign, output_shift, max_matrix_channel, 0);
+}
+
+/**
+ * MSB-first CRC folding: a byte-reversed 16-byte block is a 128-bit
+ * polynomial whose top bit is the first message bit. Four blocks 64 bytes
+ * apart are folded in parallel, merged, reduced to 64 bits and finished with
+ * a Barrett reduction, which also takes the tail 8 bytes at a time.
+ */
+static inline __m128i crc_fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+/* x^bits times the 64-bit polynomial in the low half of v, mod poly; k holds barrett and poly. */
+static inline uint32_t crc_barrett(__m128i v, __m128i k, uint32_t mask)
+{
+    __m128i q = _mm_xor_si128(v, _mm_srli_si128(_mm_clmulepi64_si128(v, k, 0x00), 8));
+    return _mm_cvtsi128_si32(_mm_clmulepi64_si128(q, k, 0x10)) & mask;
+}
+
+static uint32_t mlp_crc_pclmul(const MLPCRC *ctx, uint32_t crc, const uint8_t *buf, size_t buf_size)
+{
+    const __m128i bswap128 = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i bswap64  = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1);
+    const uint32_t mask = (1 << ctx->bits) - 1;
+    uint64_t barrett[2];
+    __m128i kb, v;
+
+    barrett[0] = ctx->barrett;
+    barrett[1] = ctx->poly;
+    kb = _mm_loadu_si128((const __m128i *)barrett);
+
+    if (buf_size >= 16) {
+        __m128i x0, x1, x2, x3, k;
+
+        x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buf), bswap128);
+        x0 = _mm_xor_si128(x0, _mm_slli_si128(_mm_cvtsi32_si128(crc << (32 - ctx->bits)), 12));
+        buf += 16;
+        buf_size -= 16;
+
+        if (buf_size >= 112) {
+            x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf +  0)), bswap128);
+            x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 16)), bswap128);
+            x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 32)), bswap128);
+            buf += 48;
+            buf_size -= 48;
+
+            k = _mm_loadu_si128((const __m128i *)ctx->fold_64);
+            for (; buf_size >= 64; buf += 64, buf_size -= 64) {
+                x0 = _mm_xor_si128(crc_fold(x0, k), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf +  0)), bswap128));
+                x1 = _mm_xor_si128(crc_fold(x1, k), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 16)), bswap128));
+                x2 = _mm_xor_si128(crc_fold(x2, k), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 32)), bswap128));
+                x3 = _mm_xor_si128(crc_fold(x3, k), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 48)), bswap128));
+            }
+
+            k  = _mm_loadu_si128((const __m128i *)ctx->fold_16);
+            x1 = _mm_xor_si128(x1, crc_fold(x0, k));
+            x2 = _mm_xor_si128(x2, crc_fold(x1, k));
+            x0 = _mm_xor_si128(x3, crc_fold(x2, k));
+        }
+
+        k = _mm_loadu_si128((const __m128i *)ctx->fold_16);
+        for (; buf_size >= 16; buf += 16, buf_size -= 16)
+            x0 = _mm_xor_si128(crc_fold(x0, k), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buf), bswap128));
+
+        /* hi * x^64 + lo == hi * (x^64 mod poly) + lo, twice to fit 64 bits */
+        k  = _mm_loadl_epi64((const __m128i *)&ctx->reduce);
+        x1 = _mm_clmulepi64_si128(x0, k, 0x01);
+        x2 = _mm_clmulepi64_si128(x1, k, 0x01);
+        crc = crc_barrett(_mm_xor_si128(_mm_xor_si128(x0, x1), x2), kb, mask);
+    }
+
+    for (; buf_size >= 8; buf += 8, buf_size -= 8) {
+        v = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)buf), bswap64);
+        v = _mm_xor_si128(v, _mm_sll_epi64(_mm_cvtsi32_si128(crc), _mm_cvtsi32_si128(64 - ctx->bits)));
+        crc = crc_barrett(v, kb, mask);
+    }
+
+    if (buf_size > 0) {
+        uint8_t tail[8] = { 0 };
+        int shift = 8 * (int)buf_size - ctx->bits;
+        uint32_t carry = 0;
+
+        memcpy(tail + 8 - buf_size, buf, buf_size);
+        v = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)tail), bswap64);
+        if (shift >= 0) {
+            v = _mm_xor_si128(v, _mm_sll_epi64(_mm_cvtsi32_si128(crc), _mm_cvtsi32_si128(shift)));
+        } else {
+            /* fewer tail bits than CRC bits: the low end of crc is only shifted */
+            v = _mm_xor_si128(v, _mm_cvtsi32_si128(crc >> -shift));
+            carry = (crc << (8 * buf_size)) & mask;
+        }
+        crc = crc_barrett(v, kb, mask) ^ carry;
+    }
+
+    return crc;
+}
+
+static uint8_t mlp_calculate_parity_sse2(const uint8_t *buf, unsigned int buf_size)
+{
+    __m128i acc = _mm_setzero_si128();
+    uint32_t scratch;
+
+    for (; buf_size >= 16; buf += 16, buf_size -= 16)
+        acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)buf));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+    scratch = _mm_cvtsi128_si32(acc);
+
+    for (; buf_size > 0; buf_size--)
+        scratch ^= *buf++;
+
+    return xor_32_to_8(scratch);
+}
+
+static int cpu_has_sse2(void)
+{
+    int info[4];
+
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+}
+
+static int cpu_has_pclmul(void)
+{
+    int info[4];
+
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9));
+}
+
+static int cpu_has_sse41(void)
+{
+    int info[4];
+
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+
+void ff_mlp_init_x86(DSPContext* c, AVCodecContext *avctx)
+{
+    if (cpu_has_sse41()) {
+        c->mlp_filter_channel = mlp_filter_channel_sse4;
+        c->mlp_rematrix_channel = mlp_rematrix_channel_sse4;
+        c->mlp_pack_output = mlp_pack_output_sse4;
+    }
+}
+
+void ff_mlp_init_crc_x86(MLPCRCContext *c)
+{
+    if (cpu_has_sse2())
+        c->calculate_parity = mlp_calculate_parity_sse2;
+    if (cpu_has_pclmul())
+        c->crc = mlp_crc_pclmul;
+}
@@ -0,0 +1,89 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _BATCH_MEDIA_H_INCLUDED
+#define _BATCH_MEDIA_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define batch_fseek _fseeki64
+#define batch_ftell _ftelli64
+#else
+#define batch_fseek fseeko
+#define batch_ftell ftello
+#endif
+
+// Plain stdio counterpart of sacd_media_file_t, the batch tool has no foobar2000 filesystem
+class batch_media_t {
+	FILE*   m_file;
+	int64_t m_size;
+	int64_t m_bytes_read;
+public:
+	batch_media_t() {
+		m_file = nullptr;
+		m_size = 0;
+		m_bytes_read = 0;
+	}
+	~batch_media_t() {
+		close();
+	}
+	bool open(const char* p_path) {
+		close();
+		m_file = fopen(p_path, "rb");
+		if (!m_file) {
+			return false;
+		}
+		setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+		batch_fseek(m_file, 0, SEEK_END);
+		m_size = batch_ftell(m_file);
+		batch_fseek(m_file, 0, SEEK_SET);
+		return true;
+	}
+	void close() {
+		if (m_file) {
+			fclose(m_file);
+			m_file = nullptr;
+		}
+		m_size = 0;
+	}
+	bool seek(int64_t p_position) {
+		return batch_fseek(m_file, p_position, SEEK_SET) == 0;
+	}
+	int64_t skip(int64_t p_bytes) {
+		return batch_fseek(m_file, p_bytes, SEEK_CUR) == 0 ? p_bytes : 0;
+	}
+	int64_t get_position() {
+		return batch_ftell(m_file);
+	}
+	int64_t get_size() {
+		return m_size;
+	}
+	int64_t get_bytes_read() {
+		return m_bytes_read;
+	}
+	size_t read(void* p_data, size_t p_size) {
+		auto size = fread(p_data, 1, p_size, m_file);
+		m_bytes_read += size;
+		return size;
+	}
+};
+
+#endif
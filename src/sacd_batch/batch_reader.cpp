@@ -0,0 +1,561 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <string.h>
+#include <algorithm>
+#include "batch_reader.h"
+
+constexpr int DATA_TYPE_AUDIO       = 2;
+constexpr int AUDIO_FRAME_INFO_SIZE = 4;
+
+static inline uint16_t get_be16(const uint8_t* p) {
+	return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static inline uint32_t get_be32(const uint8_t* p) {
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static inline uint64_t get_be64(const uint8_t* p) {
+	return (uint64_t)get_be32(p) << 32 | get_be32(p + 4);
+}
+
+static inline uint32_t get_le32(const uint8_t* p) {
+	return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | (uint32_t)p[0];
+}
+
+static inline uint64_t get_le64(const uint8_t* p) {
+	return (uint64_t)get_le32(p + 4) << 32 | get_le32(p);
+}
+
+static string get_extension(const string& p_path) {
+	auto dot = p_path.find_last_of('.');
+	auto ext = dot != string::npos ? p_path.substr(dot + 1) : string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+	return ext;
+}
+
+unique_ptr<batch_reader_t> batch_reader_t::create(const string& p_path) {
+	auto ext = get_extension(p_path);
+	if (ext == "iso") {
+		return unique_ptr<batch_reader_t>(new batch_disc_t());
+	}
+	if (ext == "dff") {
+		return unique_ptr<batch_reader_t>(new batch_dsdiff_t());
+	}
+	if (ext == "dsf") {
+		return unique_ptr<batch_reader_t>(new batch_dsf_t());
+	}
+	return nullptr;
+}
+
+bool batch_reader_t::is_supported(const string& p_path) {
+	auto ext = get_extension(p_path);
+	return ext == "iso" || ext == "dff" || ext == "dsf";
+}
+
+bool batch_disc_t::open(const char* p_path) {
+	if (!m_file.open(p_path)) {
+		return false;
+	}
+	char sacdmtoc[8];
+	m_sector_size = 0;
+	if (m_file.seek((int64_t)BATCH_MASTER_TOC_LSN * BATCH_LSN_SIZE) && m_file.read(sacdmtoc, 8) == 8 && memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
+		m_sector_size = BATCH_LSN_SIZE;
+		m_buffer = m_sector_buffer;
+	}
+	if (m_file.seek((int64_t)BATCH_MASTER_TOC_LSN * BATCH_PSN_SIZE + 12) && m_file.read(sacdmtoc, 8) == 8 && memcmp(sacdmtoc, "SACDMTOC", 8) == 0) {
+		m_sector_size = BATCH_PSN_SIZE;
+		m_buffer = m_sector_buffer + 12;
+	}
+	if (m_sector_size == 0) {
+		return false;
+	}
+	uint8_t master_toc[BATCH_LSN_SIZE];
+	if (!read_blocks(BATCH_MASTER_TOC_LSN, 1, master_toc)) {
+		return false;
+	}
+	auto area_1_toc_1_start = get_be32(master_toc + 64);
+	auto area_2_toc_1_start = get_be32(master_toc + 72);
+	auto area_1_toc_size = get_be16(master_toc + 84);
+	auto area_2_toc_size = get_be16(master_toc + 86);
+	if (area_1_toc_1_start) {
+		read_area_toc(area_1_toc_1_start, area_1_toc_size);
+	}
+	if (area_2_toc_1_start) {
+		read_area_toc(area_2_toc_1_start, area_2_toc_size);
+	}
+	std::stable_sort(m_tracks.begin(), m_tracks.end(), [](const batch_track_t& a, const batch_track_t& b) { return a.area < b.area; });
+	m_frame.resize(BATCH_MAX_FRAME_SIZE);
+	return !m_tracks.empty();
+}
+
+bool batch_disc_t::select_track(size_t p_track_index) {
+	if (p_track_index >= m_tracks.size()) {
+		return false;
+	}
+	m_track_index = p_track_index;
+	auto& track = m_tracks[p_track_index];
+	m_track_current_lsn = (uint32_t)track.start;
+	m_track_end_lsn = (uint32_t)(track.start + track.length);
+	reset_frame();
+	return m_file.seek((int64_t)m_track_current_lsn * m_sector_size);
+}
+
+bool batch_disc_t::read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type) {
+	m_sector_bad_reads = 0;
+	while (m_track_current_lsn < m_track_end_lsn) {
+		if (m_sector_bad_reads > 0) {
+			reset_frame();
+			*p_frame_type = frame_type_e::INVALID;
+			return true;
+		}
+		if (m_packet_info_idx == m_packet_info_count) {
+			// obtain the next sector data block
+			m_buffer_offset = 0;
+			m_packet_info_idx = 0;
+			m_packet_info_count = 0;
+			auto read_bytes = m_file.read(m_sector_buffer, m_sector_size);
+			m_track_current_lsn++;
+			if (read_bytes != m_sector_size) {
+				m_sector_bad_reads++;
+				continue;
+			}
+			auto header = m_buffer[m_buffer_offset++];
+			auto frame_info_count = (header >> 2) & 7;
+			m_sector_dst_encoded = (header & 1) != 0;
+			m_packet_info_count = (header >> 5) & 7;
+			for (auto i = 0; i < m_packet_info_count; i++) {
+				auto packet_info = m_buffer + m_buffer_offset;
+				m_packet_info[i].frame_start = ((packet_info[0] >> 7) & 1) != 0;
+				m_packet_info[i].data_type = (packet_info[0] >> 3) & 7;
+				m_packet_info[i].packet_length = (packet_info[0] & 7) << 8 | packet_info[1];
+				m_buffer_offset += 2;
+			}
+			m_buffer_offset += (m_sector_dst_encoded ? AUDIO_FRAME_INFO_SIZE : AUDIO_FRAME_INFO_SIZE - 1) * frame_info_count;
+		}
+		while (m_packet_info_idx < m_packet_info_count && m_sector_bad_reads == 0) {
+			auto& packet = m_packet_info[m_packet_info_idx];
+			if (packet.data_type == DATA_TYPE_AUDIO) {
+				if (m_frame_started) {
+					if (packet.frame_start) {
+						if (m_frame_size > *p_frame_size) {
+							m_sector_bad_reads++;
+							continue;
+						}
+						memcpy(p_frame_data, m_frame.data(), m_frame_size);
+						*p_frame_size = m_frame_size;
+						*p_frame_type = m_frame_dst_encoded ? frame_type_e::DST : frame_type_e::DSD;
+						m_frame_started = false;
+						return true;
+					}
+				}
+				else if (packet.frame_start) {
+					m_frame_size = 0;
+					m_frame_dst_encoded = m_sector_dst_encoded;
+					m_frame_started = true;
+				}
+				if (m_frame_started) {
+					if (m_frame_size + packet.packet_length > m_frame.size() || m_buffer_offset + packet.packet_length > BATCH_LSN_SIZE) {
+						m_sector_bad_reads++;
+						continue;
+					}
+					memcpy(m_frame.data() + m_frame_size, m_buffer + m_buffer_offset, packet.packet_length);
+					m_frame_size += packet.packet_length;
+				}
+			}
+			m_buffer_offset += packet.packet_length;
+			m_packet_info_idx++;
+		}
+	}
+	if (m_frame_started) {
+		m_frame_started = false;
+		if (m_sector_bad_reads > 0 || m_frame_size > *p_frame_size) {
+			reset_frame();
+			*p_frame_type = frame_type_e::INVALID;
+			return true;
+		}
+		memcpy(p_frame_data, m_frame.data(), m_frame_size);
+		*p_frame_size = m_frame_size;
+		*p_frame_type = m_frame_dst_encoded ? frame_type_e::DST : frame_type_e::DSD;
+		return true;
+	}
+	*p_frame_type = frame_type_e::INVALID;
+	return false;
+}
+
+bool batch_disc_t::read_blocks(uint32_t p_lsn, uint32_t p_count, uint8_t* p_data) {
+	if (m_sector_size == BATCH_LSN_SIZE) {
+		return m_file.seek((int64_t)p_lsn * BATCH_LSN_SIZE) && m_file.read(p_data, (size_t)p_count * BATCH_LSN_SIZE) == (size_t)p_count * BATCH_LSN_SIZE;
+	}
+	for (uint32_t i = 0; i < p_count; i++) {
+		if (!(m_file.seek((int64_t)(p_lsn + i) * BATCH_PSN_SIZE + 12) && m_file.read(p_data + i * BATCH_LSN_SIZE, BATCH_LSN_SIZE) == BATCH_LSN_SIZE)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Field offsets follow area_toc_t, area_tracklist_offset_t and area_tracklist_time_t in scarletbook.h
+bool batch_disc_t::read_area_toc(uint32_t p_lsn, uint32_t p_count) {
+	vector<uint8_t> area_data((size_t)p_count * BATCH_LSN_SIZE);
+	if (area_data.empty() || !read_blocks(p_lsn, p_count, area_data.data())) {
+		return false;
+	}
+	auto area_toc = area_data.data();
+	if (memcmp(area_toc, "TWOCHTOC", 8) != 0 && memcmp(area_toc, "MULCHTOC", 8) != 0) {
+		return false;
+	}
+	auto area_size = (size_t)get_be16(area_toc + 10) * BATCH_LSN_SIZE;
+	auto frame_format = area_toc[21] & 0x0f;
+	auto channel_count = area_toc[32];
+	auto loudspeaker_config = area_toc[33] & 0x1f;
+	auto track_count = area_toc[69];
+	const uint8_t* tracklist_offset = nullptr;
+	const uint8_t* tracklist_time = nullptr;
+	auto p = area_toc + BATCH_LSN_SIZE;
+	while (p + BATCH_LSN_SIZE <= area_toc + std::min(area_size, area_data.size())) {
+		if (memcmp(p, "SACDTTxt", 8) == 0) {
+			p += BATCH_LSN_SIZE;
+		}
+		else if (memcmp(p, "SACD_IGL", 8) == 0) {
+			p += BATCH_LSN_SIZE * 2;
+		}
+		else if (memcmp(p, "SACD_ACC", 8) == 0) {
+			p += BATCH_LSN_SIZE * 32;
+		}
+		else if (memcmp(p, "SACDTRL1", 8) == 0) {
+			tracklist_offset = p;
+			p += BATCH_LSN_SIZE;
+		}
+		else if (memcmp(p, "SACDTRL2", 8) == 0) {
+			tracklist_time = p;
+			p += BATCH_LSN_SIZE;
+		}
+		else {
+			break;
+		}
+	}
+	if (!tracklist_offset) {
+		return false;
+	}
+	for (auto i = 0; i < track_count; i++) {
+		batch_track_t track;
+		track.area = (channel_count == 2 && loudspeaker_config == 0) ? AREA_TWOCH : AREA_MULCH;
+		track.number = i + 1;
+		track.channels = channel_count;
+		track.loudspeaker_config = loudspeaker_config;
+		track.samplerate = BATCH_SACD_FREQUENCY;
+		track.framerate = BATCH_SACD_FRAMERATE;
+		track.dst_encoded = frame_format == 0;
+		track.start = get_be32(tracklist_offset + 8 + 4 * i);
+		track.length = get_be32(tracklist_offset + 8 + 4 * 255 + 4 * i);
+		if (tracklist_time) {
+			auto t = tracklist_time + 8 + 4 * 255 + 4 * i;
+			track.duration = t[0] * 60.0 + t[1] + t[2] / 75.0;
+		}
+		m_tracks.push_back(track);
+	}
+	return true;
+}
+
+void batch_disc_t::reset_frame() {
+	m_buffer_offset = 0;
+	m_packet_info_idx = 0;
+	m_packet_info_count = 0;
+	m_frame_size = 0;
+	m_frame_started = false;
+}
+
+bool batch_dsdiff_t::open(const char* p_path) {
+	if (!m_file.open(p_path)) {
+		return false;
+	}
+	uint8_t ck[12];
+	uint8_t id[4];
+	if (!(m_file.read(ck, sizeof(ck)) == sizeof(ck) && memcmp(ck, "FRM8", 4) == 0)) {
+		return false;
+	}
+	if (!(m_file.read(id, sizeof(id)) == sizeof(id) && memcmp(id, "DSD ", 4) == 0)) {
+		return false;
+	}
+	auto frm8_end = get_be64(ck + 4) + sizeof(ck);
+	batch_track_t track;
+	track.number = 1;
+	track.framerate = BATCH_SACD_FRAMERATE;
+	int64_t pos;
+	while ((pos = m_file.get_position()) >= 0 && (uint64_t)pos < frm8_end && m_file.read(ck, sizeof(ck)) == sizeof(ck)) {
+		auto ck_size = get_be64(ck + 4);
+		if (memcmp(ck, "PROP", 4) == 0) {
+			if (!(m_file.read(id, sizeof(id)) == sizeof(id) && memcmp(id, "SND ", 4) == 0)) {
+				return false;
+			}
+			auto prop_end = m_file.get_position() - (int64_t)sizeof(id) + (int64_t)ck_size;
+			while (m_file.get_position() < prop_end && m_file.read(ck, sizeof(ck)) == sizeof(ck)) {
+				auto prop_size = get_be64(ck + 4);
+				uint8_t prop[4];
+				auto prop_read = std::min(prop_size, (uint64_t)sizeof(prop));
+				if (m_file.read(prop, (size_t)prop_read) != prop_read) {
+					return false;
+				}
+				if (memcmp(ck, "FS  ", 4) == 0 && prop_read == 4) {
+					track.samplerate = (int)get_be32(prop);
+				}
+				else if (memcmp(ck, "CHNL", 4) == 0 && prop_read >= 2) {
+					track.channels = get_be16(prop);
+					switch (track.channels) {
+					case 1:
+						track.loudspeaker_config = 5;
+						break;
+					case 2:
+						track.loudspeaker_config = 0;
+						break;
+					case 3:
+						track.loudspeaker_config = 6;
+						break;
+					case 4:
+						track.loudspeaker_config = 1;
+						break;
+					case 5:
+						track.loudspeaker_config = 3;
+						break;
+					case 6:
+						track.loudspeaker_config = 4;
+						break;
+					default:
+						track.loudspeaker_config = 65535;
+						break;
+					}
+				}
+				else if (memcmp(ck, "CMPR", 4) == 0 && prop_read == 4) {
+					track.dst_encoded = memcmp(prop, "DST ", 4) == 0;
+				}
+				else if (memcmp(ck, "LSCO", 4) == 0 && prop_read >= 2) {
+					track.loudspeaker_config = get_be16(prop);
+				}
+				m_file.skip((int64_t)(prop_size - prop_read));
+				m_file.skip(m_file.get_position() & 1);
+			}
+		}
+		else if (memcmp(ck, "DSD ", 4) == 0) {
+			track.start = m_file.get_position();
+			track.length = ck_size;
+			m_file.skip((int64_t)ck_size);
+		}
+		else if (memcmp(ck, "DST ", 4) == 0) {
+			uint8_t frte[18];
+			if (!(m_file.read(frte, sizeof(frte)) == sizeof(frte) && memcmp(frte, "FRTE", 4) == 0 && get_be64(frte + 4) == 6)) {
+				return false;
+			}
+			track.start = m_file.get_position();
+			track.length = ck_size - sizeof(frte);
+			track.duration = (double)get_be32(frte + 12) / std::max<int>(get_be16(frte + 16), 1);
+			track.framerate = get_be16(frte + 16);
+			m_file.seek((int64_t)(track.start + track.length));
+		}
+		else {
+			m_file.skip((int64_t)ck_size);
+		}
+		m_file.skip(m_file.get_position() & 1);
+	}
+	if (track.channels <= 0 || track.samplerate <= 0 || track.framerate <= 0 || track.length == 0) {
+		return false;
+	}
+	if (!track.dst_encoded) {
+		track.duration = (double)(track.length / track.channels) * 8 / track.samplerate;
+	}
+	track.area = track.channels <= 2 ? AREA_TWOCH : AREA_MULCH;
+	m_frame_size = (size_t)(track.samplerate / 8 / track.framerate * track.channels);
+	m_tracks.push_back(track);
+	return true;
+}
+
+bool batch_dsdiff_t::select_track(size_t p_track_index) {
+	if (p_track_index >= m_tracks.size()) {
+		return false;
+	}
+	m_track_index = p_track_index;
+	m_track_end = m_tracks[p_track_index].start + m_tracks[p_track_index].length;
+	return m_file.seek((int64_t)m_tracks[p_track_index].start);
+}
+
+bool batch_dsdiff_t::read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type) {
+	auto& track = m_tracks[m_track_index];
+	if (track.dst_encoded) {
+		uint8_t ck[12];
+		while ((uint64_t)m_file.get_position() < m_track_end && m_file.read(ck, sizeof(ck)) == sizeof(ck)) {
+			auto ck_size = get_be64(ck + 4);
+			if (memcmp(ck, "DSTF", 4) == 0) {
+				if (ck_size > *p_frame_size || m_file.read(p_frame_data, (size_t)ck_size) != ck_size) {
+					break;
+				}
+				m_file.skip(ck_size & 1);
+				*p_frame_size = (size_t)ck_size;
+				*p_frame_type = frame_type_e::DST;
+				return true;
+			}
+			if (ck_size > track.length) {
+				break;
+			}
+			m_file.skip((int64_t)ck_size);
+			m_file.skip(ck_size & 1);
+		}
+	}
+	else {
+		auto position = m_file.get_position();
+		auto frame_size = (size_t)std::min((int64_t)std::min(*p_frame_size, m_frame_size), std::max((int64_t)0, (int64_t)m_track_end - position));
+		if (frame_size > 0) {
+			frame_size = m_file.read(p_frame_data, frame_size);
+			frame_size -= frame_size % track.channels;
+			if (frame_size > 0) {
+				*p_frame_size = frame_size;
+				*p_frame_type = frame_type_e::DSD;
+				return true;
+			}
+		}
+	}
+	*p_frame_type = frame_type_e::INVALID;
+	return false;
+}
+
+batch_dsf_t::batch_dsf_t() {
+	for (int i = 0; i < 256; i++) {
+		m_swap_bits[i] = 0;
+		for (int j = 0; j < 8; j++) {
+			m_swap_bits[i] |= ((i >> j) & 1) << (7 - j);
+		}
+	}
+}
+
+bool batch_dsf_t::open(const char* p_path) {
+	if (!m_file.open(p_path)) {
+		return false;
+	}
+	uint8_t dsd[28];
+	if (!(m_file.read(dsd, sizeof(dsd)) == sizeof(dsd) && memcmp(dsd, "DSD ", 4) == 0 && get_le64(dsd + 4) == 28)) {
+		return false;
+	}
+	uint8_t fmt[52];
+	if (!(m_file.read(fmt, sizeof(fmt)) == sizeof(fmt) && memcmp(fmt, "fmt ", 4) == 0 && get_le32(fmt + 16) == 0)) {
+		return false;
+	}
+	batch_track_t track;
+	switch (get_le32(fmt + 20)) {
+	case 1:
+		track.loudspeaker_config = 5;
+		break;
+	case 2:
+		track.loudspeaker_config = 0;
+		break;
+	case 3:
+		track.loudspeaker_config = 6;
+		break;
+	case 4:
+		track.loudspeaker_config = 1;
+		break;
+	case 5:
+		track.loudspeaker_config = 2;
+		break;
+	case 6:
+		track.loudspeaker_config = 3;
+		break;
+	case 7:
+		track.loudspeaker_config = 4;
+		break;
+	default:
+		track.loudspeaker_config = 65535;
+		break;
+	}
+	track.channels = (int)get_le32(fmt + 24);
+	track.samplerate = (int)get_le32(fmt + 28);
+	track.framerate = BATCH_SACD_FRAMERATE;
+	switch (get_le32(fmt + 32)) {
+	case 1:
+		m_is_lsb = true;
+		break;
+	case 8:
+		m_is_lsb = false;
+		break;
+	default:
+		return false;
+	}
+	auto sample_count = get_le64(fmt + 36);
+	m_block_size = (int)get_le32(fmt + 44);
+	if (track.channels < 1 || track.samplerate <= 0 || m_block_size <= 0) {
+		return false;
+	}
+	if (!m_file.seek(sizeof(dsd) + get_le64(fmt + 4))) {
+		return false;
+	}
+	uint8_t ck[12];
+	if (!(m_file.read(ck, sizeof(ck)) == sizeof(ck) && memcmp(ck, "data", 4) == 0)) {
+		return false;
+	}
+	track.area = track.channels <= 2 ? AREA_TWOCH : AREA_MULCH;
+	track.number = 1;
+	track.duration = (double)sample_count / track.samplerate;
+	track.start = m_file.get_position();
+	track.length = sample_count / 8;
+	m_block_data.resize((size_t)m_block_size * track.channels);
+	m_tracks.push_back(track);
+	return true;
+}
+
+bool batch_dsf_t::select_track(size_t p_track_index) {
+	if (p_track_index >= m_tracks.size()) {
+		return false;
+	}
+	m_track_index = p_track_index;
+	m_sample_in_block = 0;
+	m_block_data_end = 0;
+	m_samples_left = (int64_t)m_tracks[p_track_index].length;
+	return m_file.seek((int64_t)m_tracks[p_track_index].start);
+}
+
+// Channel blocks are interleaved into byte-per-channel DSD frames, LSB first files are bit reversed on the way
+bool batch_dsf_t::read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type) {
+	auto& track = m_tracks[m_track_index];
+	auto channels = track.channels;
+	auto samples = std::min((int)*p_frame_size / channels, track.samplerate / 8 / track.framerate);
+	auto samples_read = 0;
+	while (samples_read < samples) {
+		if (m_sample_in_block >= m_block_data_end) {
+			if (m_samples_left <= 0 || m_file.read(m_block_data.data(), m_block_data.size()) != m_block_data.size()) {
+				break;
+			}
+			m_block_data_end = (int)std::min((int64_t)m_block_size, m_samples_left);
+			m_samples_left -= m_block_data_end;
+			m_sample_in_block = 0;
+			continue;
+		}
+		auto block_samples = std::min(samples - samples_read, m_block_data_end - m_sample_in_block);
+		auto out_data = p_frame_data + samples_read * channels;
+		for (auto ch = 0; ch < channels; ch++) {
+			auto inp_data = m_block_data.data() + ch * m_block_size + m_sample_in_block;
+			for (auto s = 0; s < block_samples; s++) {
+				out_data[s * channels + ch] = m_is_lsb ? m_swap_bits[inp_data[s]] : inp_data[s];
+			}
+		}
+		m_sample_in_block += block_samples;
+		samples_read += block_samples;
+	}
+	*p_frame_size = samples_read * channels;
+	*p_frame_type = samples_read > 0 ? frame_type_e::DSD : frame_type_e::INVALID;
+	return samples_read > 0;
+}
@@ -0,0 +1,147 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _BATCH_READER_H_INCLUDED
+#define _BATCH_READER_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "batch_media.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+constexpr int BATCH_LSN_SIZE       = 2048;
+constexpr int BATCH_PSN_SIZE       = 2064;
+constexpr int BATCH_MASTER_TOC_LSN = 510;
+constexpr int BATCH_MAX_FRAME_SIZE = 1024 * 64;
+constexpr int BATCH_SACD_FRAMERATE = 75;
+constexpr int BATCH_SACD_FREQUENCY = 2822400;
+
+enum class frame_type_e {
+	INVALID = -1,
+	DSD     = 0,
+	DST     = 1
+};
+
+enum area_id_e {
+	AREA_NULL  = 0,
+	AREA_TWOCH = 1 << 0,
+	AREA_MULCH = 1 << 1,
+	AREA_BOTH  = AREA_TWOCH | AREA_MULCH
+};
+
+class batch_track_t {
+public:
+	area_id_e area = AREA_NULL;
+	int       number = 0;             // 1-based within the area
+	int       channels = 0;
+	int       loudspeaker_config = 0;
+	int       samplerate = 0;
+	int       framerate = 0;
+	bool      dst_encoded = false;
+	double    duration = 0.0;
+	uint64_t  start = 0;              // LSN on a disc image, byte offset in DSDIFF/DSF
+	uint64_t  length = 0;             // LSNs on a disc image, bytes in DSDIFF/DSF
+};
+
+// SDK free versions of sacd_disc_t, sacd_dsdiff_t and sacd_dsf_t, only what is needed to pull frames out of a track
+class batch_reader_t {
+protected:
+	batch_media_t         m_file;
+	vector<batch_track_t> m_tracks;
+	size_t                m_track_index = 0;
+public:
+	static unique_ptr<batch_reader_t> create(const string& p_path);
+	static bool is_supported(const string& p_path);
+	virtual ~batch_reader_t() {};
+	virtual bool open(const char* p_path) = 0;
+	virtual bool select_track(size_t p_track_index) = 0;
+	virtual bool read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type) = 0;
+	const vector<batch_track_t>& get_tracks() const {
+		return m_tracks;
+	}
+	const batch_track_t& get_track() const {
+		return m_tracks[m_track_index];
+	}
+	int64_t get_bytes_read() {
+		return m_file.get_bytes_read();
+	}
+};
+
+class batch_disc_t : public batch_reader_t {
+	class packet_info_t {
+	public:
+		bool     frame_start;
+		int      data_type;
+		uint32_t packet_length;
+	};
+	uint32_t        m_sector_size = 0;
+	uint8_t         m_sector_buffer[BATCH_PSN_SIZE];
+	uint8_t*        m_buffer = m_sector_buffer;
+	uint32_t        m_buffer_offset = 0;
+	uint32_t        m_track_end_lsn = 0;
+	uint32_t        m_track_current_lsn = 0;
+	bool            m_sector_dst_encoded = false;
+	int             m_packet_info_count = 0;
+	int             m_packet_info_idx = 0;
+	packet_info_t   m_packet_info[7];
+	vector<uint8_t> m_frame;
+	size_t          m_frame_size = 0;
+	bool            m_frame_started = false;
+	bool            m_frame_dst_encoded = false;
+	int             m_sector_bad_reads = 0;
+public:
+	bool open(const char* p_path);
+	bool select_track(size_t p_track_index);
+	bool read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type);
+private:
+	bool read_blocks(uint32_t p_lsn, uint32_t p_count, uint8_t* p_data);
+	bool read_area_toc(uint32_t p_lsn, uint32_t p_count);
+	void reset_frame();
+};
+
+// Only the audio chunk is used, DIIN track marks are not split (extract the ISO directly for per track output)
+class batch_dsdiff_t : public batch_reader_t {
+	uint64_t m_track_end = 0;
+	size_t   m_frame_size = 0;
+public:
+	bool open(const char* p_path);
+	bool select_track(size_t p_track_index);
+	bool read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type);
+};
+
+class batch_dsf_t : public batch_reader_t {
+	vector<uint8_t> m_block_data;
+	int             m_block_size = 0;
+	int             m_sample_in_block = 0;
+	int             m_block_data_end = 0;
+	int64_t         m_samples_left = 0;
+	bool            m_is_lsb = false;
+	uint8_t         m_swap_bits[256];
+public:
+	batch_dsf_t();
+	bool open(const char* p_path);
+	bool select_track(size_t p_track_index);
+	bool read_frame(uint8_t* p_frame_data, size_t* p_frame_size, frame_type_e* p_frame_type);
+};
+
+#endif
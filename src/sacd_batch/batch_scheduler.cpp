@@ -0,0 +1,301 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include "batch_scheduler.h"
+#include "dst_decoder_mt.h"
+#include "DSDPCMConverterEngine.h"
+
+namespace fs = std::filesystem;
+using std::thread;
+
+constexpr int BATCH_MIN_DECIMATION = 8;
+constexpr int BATCH_MAX_DECIMATION = 1024;
+
+static double get_seconds_since(std::chrono::steady_clock::time_point p_start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - p_start).count();
+}
+
+batch_scheduler_t::batch_scheduler_t(const batch_options_t& p_options) : m_options(p_options) {
+}
+
+bool batch_scheduler_t::add_input(const string& p_path) {
+	std::error_code ec;
+	if (fs::is_directory(p_path, ec)) {
+		vector<string> paths;
+		for (auto& entry : fs::recursive_directory_iterator(p_path, ec)) {
+			if (entry.is_regular_file() && batch_reader_t::is_supported(entry.path().string())) {
+				paths.push_back(entry.path().string());
+			}
+		}
+		std::sort(paths.begin(), paths.end());
+		auto ok = true;
+		for (auto& path : paths) {
+			ok = add_input(path) && ok;
+		}
+		return ok;
+	}
+	auto reader = batch_reader_t::create(p_path);
+	if (!reader || !reader->open(p_path.c_str())) {
+		fprintf(stderr, "Cannot open '%s'\n", p_path.c_str());
+		return false;
+	}
+	auto is_disc = dynamic_cast<batch_disc_t*>(reader.get()) != nullptr;
+	auto ext = m_options.format == output_format_e::WAV ? ".wav" : ".raw";
+	auto stem = fs::path(p_path).stem().string();
+	auto& tracks = reader->get_tracks();
+	for (size_t i = 0; i < tracks.size(); i++) {
+		if (!(tracks[i].area & m_options.area)) {
+			continue;
+		}
+		char name[32];
+		snprintf(name, sizeof(name), " - %s - %02d", tracks[i].area == AREA_TWOCH ? "2CH" : "MCH", tracks[i].number);
+		auto job = std::make_unique<batch_job_t>();
+		job->input_path = p_path;
+		job->track_index = i;
+		job->track = tracks[i];
+		auto base = stem + (is_disc ? name : "");
+		job->output_path = (fs::path(m_options.output_dir) / (base + ext)).string();
+		for (auto n = 2; has_output_path(job->output_path); n++) {
+			job->output_path = (fs::path(m_options.output_dir) / (base + " (" + std::to_string(n) + ")" + ext)).string();
+		}
+		m_jobs.push_back(std::move(job));
+	}
+	return true;
+}
+
+bool batch_scheduler_t::has_output_path(const string& p_path) const {
+	return std::any_of(m_jobs.begin(), m_jobs.end(), [&p_path](const unique_ptr<batch_job_t>& job) {
+		return job->output_path == p_path;
+	});
+}
+
+int batch_scheduler_t::get_max_channels() const {
+	auto channels = 1;
+	for (auto& job : m_jobs) {
+		channels = std::max(channels, job->track.channels);
+	}
+	return channels;
+}
+
+// DST decoder threads plus one DSD2PCM slot thread per channel
+int batch_scheduler_t::get_job_threads() const {
+	return (m_options.dst_threads > 0 ? m_options.dst_threads : BATCH_MIN_DST_THREADS) + get_max_channels();
+}
+
+int batch_scheduler_t::get_worker_count() const {
+	auto hw_threads = (int)std::max(1u, thread::hardware_concurrency());
+	auto workers = m_options.jobs > 0 ? m_options.jobs : std::max(1, hw_threads / get_job_threads());
+	return std::max(1, std::min(workers, (int)m_jobs.size()));
+}
+
+bool batch_scheduler_t::run() {
+	auto worker_count = get_worker_count();
+	if (m_options.dst_threads <= 0) {
+		// a lone disc gets the whole machine, a full batch is already parallel across files
+		auto hw_threads = (int)std::max(1u, thread::hardware_concurrency());
+		m_options.dst_threads = std::max(BATCH_MIN_DST_THREADS, hw_threads / worker_count - get_max_channels());
+	}
+	fs::create_directories(m_options.output_dir);
+	auto start = std::chrono::steady_clock::now();
+	vector<thread> workers;
+	for (auto i = 0; i < worker_count; i++) {
+		workers.emplace_back(&batch_scheduler_t::worker, this);
+	}
+	auto finished = [this]() {
+		return std::all_of(m_jobs.begin(), m_jobs.end(), [](const unique_ptr<batch_job_t>& job) {
+			return job->state >= (int)job_state_e::DONE;
+		});
+	};
+	auto next_report = BATCH_REPORT_INTERVAL_MS / 1000.0;
+	while (!finished()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(BATCH_POLL_INTERVAL_MS));
+		if (get_seconds_since(start) >= next_report) {
+			report(get_seconds_since(start), false);
+			next_report += BATCH_REPORT_INTERVAL_MS / 1000.0;
+		}
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	report(get_seconds_since(start), true);
+	return std::none_of(m_jobs.begin(), m_jobs.end(), [](const unique_ptr<batch_job_t>& job) {
+		return job->state == (int)job_state_e::FAILED;
+	});
+}
+
+void batch_scheduler_t::worker() {
+	size_t job_index;
+	while ((job_index = m_next_job++) < m_jobs.size()) {
+		auto& job = *m_jobs[job_index];
+		auto start = std::chrono::steady_clock::now();
+		job.state = (int)job_state_e::RUNNING;
+		run_job(job);
+		job.seconds = get_seconds_since(start);
+		if (job.state == (int)job_state_e::FAILED) {
+			remove(job.output_path.c_str());
+		}
+	}
+}
+
+// Same frame loop as input_sacd_t::decode_run_internal: DST frames go round the decoder slots, the converter
+// delay is dropped from the head and flushed from the tail
+void batch_scheduler_t::run_job(batch_job_t& p_job) {
+	auto fail = [&p_job](const char* p_error) {
+		p_job.error = p_error;
+		p_job.state = (int)job_state_e::FAILED;
+	};
+	auto reader = batch_reader_t::create(p_job.input_path);
+	if (!reader || !reader->open(p_job.input_path.c_str()) || !reader->select_track(p_job.track_index)) {
+		fail("cannot open input");
+		return;
+	}
+	auto channels = p_job.track.channels;
+	auto dsd_samplerate = p_job.track.samplerate;
+	auto framerate = p_job.track.framerate;
+	auto pcm_samplerate = m_options.pcm_samplerate;
+	auto decimation = dsd_samplerate / pcm_samplerate;
+	if (dsd_samplerate % pcm_samplerate != 0 || decimation < BATCH_MIN_DECIMATION || decimation > BATCH_MAX_DECIMATION || (decimation & (decimation - 1)) != 0) {
+		fail("unsupported PCM samplerate for this DSD samplerate");
+		return;
+	}
+	auto dsd_frame_size = (size_t)(dsd_samplerate / 8 / framerate * channels);
+	auto frame_capacity = std::max((size_t)BATCH_MAX_FRAME_SIZE, dsd_frame_size);
+	auto dst_threads = m_options.dst_threads;
+	vector<uint8_t> dst_buf(frame_capacity * dst_threads);
+	vector<uint8_t> dsd_buf(dsd_frame_size * dst_threads);
+	unique_ptr<dst_decoder_t> dst_decoder;
+	DSDPCMConverterEngine converter;
+	converter.set_gain(m_options.gain_dB);
+	if (converter.init(channels, framerate, dsd_samplerate, pcm_samplerate, conv_type_e::DSDPCM_CONV_MULTISTAGE, false, nullptr, 0) < 0) {
+		fail("cannot initialize DSD2PCM converter");
+		return;
+	}
+	auto pcm_frame_samples = pcm_samplerate / framerate;
+	vector<float> pcm_buf(pcm_frame_samples * channels);
+	auto delay = converter.get_delay();
+	auto remove_samples = std::min(delay > 0.0f ? (int)(delay + 0.5f) : 0, pcm_frame_samples - 1);
+	auto append_samples = remove_samples;
+	batch_writer_t writer;
+	if (!writer.open(p_job.output_path.c_str(), m_options.format, channels, pcm_samplerate, batch_writer_t::get_channel_mask(p_job.track.loudspeaker_config, channels))) {
+		fail("cannot create output");
+		return;
+	}
+	for (;;) {
+		auto slot_nr = dst_decoder ? dst_decoder->get_slot_nr() : 0;
+		auto dsd_data = dsd_buf.data() + dsd_frame_size * slot_nr;
+		size_t dsd_size = 0;
+		auto frame_data = dst_buf.data() + frame_capacity * slot_nr;
+		auto frame_size = frame_capacity;
+		frame_type_e frame_type;
+		auto has_frame = reader->read_frame(frame_data, &frame_size, &frame_type);
+		if (has_frame) {
+			switch (frame_type) {
+			case frame_type_e::DSD:
+				dsd_data = frame_data;
+				dsd_size = frame_size;
+				break;
+			case frame_type_e::DST:
+				if (!dst_decoder) {
+					dst_decoder = std::make_unique<dst_decoder_t>(dst_threads);
+					if (dst_decoder->init(channels, dsd_samplerate, framerate) != 0) {
+						fail("cannot initialize DST decoder");
+						return;
+					}
+				}
+				dst_decoder->decode(frame_data, frame_size, &dsd_data, &dsd_size);
+				break;
+			default:
+				p_job.dropped_frames++;
+				break;
+			}
+		}
+		else if (dst_decoder) {
+			dst_decoder->decode(nullptr, 0, &dsd_data, &dsd_size);
+		}
+		p_job.bytes_read = reader->get_bytes_read();
+		if (!has_frame && !dsd_size) {
+			break;
+		}
+		if (dsd_size) {
+			auto pcm_samples = converter.convert(dsd_data, (int)dsd_size, pcm_buf.data()) / channels;
+			if (pcm_samples > remove_samples && !writer.write(pcm_buf.data() + remove_samples * channels, pcm_samples - remove_samples)) {
+				fail("write error");
+				return;
+			}
+			remove_samples = 0;
+			p_job.frames_done++;
+		}
+	}
+	if (append_samples > 0 && converter.is_convert_called()) {
+		converter.convert(nullptr, 0, pcm_buf.data());
+		if (!writer.write(pcm_buf.data(), append_samples)) {
+			fail("write error");
+			return;
+		}
+	}
+	p_job.clipped_samples = writer.get_clipped();
+	if (!writer.close()) {
+		fail("write error");
+		return;
+	}
+	p_job.state = (int)job_state_e::DONE;
+}
+
+void batch_scheduler_t::report(double p_elapsed, bool p_final) {
+	size_t done = 0;
+	size_t failed = 0;
+	double audio_seconds = 0.0;
+	int64_t bytes_read = 0;
+	int64_t frames_done = 0;
+	int64_t frame_count = 0;
+	for (auto& job : m_jobs) {
+		auto state = (job_state_e)job->state.load();
+		done += state == job_state_e::DONE ? 1 : 0;
+		failed += state == job_state_e::FAILED ? 1 : 0;
+		audio_seconds += (double)job->frames_done / job->track.framerate;
+		bytes_read += job->bytes_read;
+		frames_done += job->frames_done;
+		frame_count += job->get_frame_count();
+	}
+	auto speed = p_elapsed > 0.0 ? audio_seconds / p_elapsed : 0.0;
+	auto throughput = p_elapsed > 0.0 ? bytes_read / p_elapsed / (1024.0 * 1024.0) : 0.0;
+	if (!p_final) {
+		fprintf(stderr, "[%zu/%zu] %3.0f%%, %.1f s of audio, %.1fx realtime, %.1f MB/s\n", done + failed, m_jobs.size(), frame_count > 0 ? std::min(100.0, 100.0 * frames_done / frame_count) : 0.0, audio_seconds, speed, throughput);
+		return;
+	}
+	for (auto& job : m_jobs) {
+		if (job->state == (int)job_state_e::FAILED) {
+			fprintf(stderr, "FAILED %s: %s\n", job->output_path.c_str(), job->error.c_str());
+			continue;
+		}
+		fprintf(stderr, "%s: %.1f s in %.1f s (%.1fx)", job->output_path.c_str(), (double)job->frames_done / job->track.framerate, job->seconds, job->seconds > 0.0 ? (double)job->frames_done / job->track.framerate / job->seconds : 0.0);
+		if (job->dropped_frames > 0) {
+			fprintf(stderr, ", %llu bad frames", (unsigned long long)job->dropped_frames);
+		}
+		if (job->clipped_samples > 0) {
+			fprintf(stderr, ", %llu clipped samples", (unsigned long long)job->clipped_samples);
+		}
+		fprintf(stderr, "\n");
+	}
+	fprintf(stderr, "Converted %zu of %zu tracks (%zu failed), %.1f s of audio in %.1f s, %.1fx realtime, %.1f MB/s\n", done, m_jobs.size(), failed, audio_seconds, p_elapsed, speed, throughput);
+}
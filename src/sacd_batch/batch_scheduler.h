@@ -0,0 +1,99 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _BATCH_SCHEDULER_H_INCLUDED
+#define _BATCH_SCHEDULER_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "batch_reader.h"
+#include "batch_writer.h"
+
+using std::atomic;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+constexpr int BATCH_REPORT_INTERVAL_MS = 1000;
+constexpr int BATCH_POLL_INTERVAL_MS   = 50;
+constexpr int BATCH_MIN_DST_THREADS    = 2;
+
+enum class job_state_e {
+	PENDING = 0,
+	RUNNING = 1,
+	DONE    = 2,
+	FAILED  = 3
+};
+
+class batch_options_t {
+public:
+	int             pcm_samplerate = 88200;
+	int             jobs = 0;             // 0 = hardware threads divided by the threads a job keeps busy
+	int             dst_threads = 0;      // 0 = hardware threads left per job after its converter threads, at least BATCH_MIN_DST_THREADS
+	int             area = AREA_BOTH;
+	float           gain_dB = 0.0f;
+	output_format_e format = output_format_e::WAV;
+	string          output_dir = ".";
+};
+
+// One track of one input file, written to one output file
+class batch_job_t {
+public:
+	string            input_path;
+	size_t            track_index = 0;
+	batch_track_t     track;
+	string            output_path;
+	atomic<int>       state{(int)job_state_e::PENDING};
+	atomic<int64_t>   frames_done{0};
+	atomic<int64_t>   bytes_read{0};
+	uint64_t          dropped_frames = 0;
+	uint64_t          clipped_samples = 0;
+	double            seconds = 0.0;
+	string            error;
+	int64_t get_frame_count() const {
+		return (int64_t)(track.duration * track.framerate + 0.5);
+	}
+};
+
+// Runs jobs on a fixed set of workers, every job owns a DST decoder and a DSD2PCM engine with their slot threads.
+// The calling thread stays behind to print progress and the final summary.
+class batch_scheduler_t {
+	batch_options_t                 m_options;
+	vector<unique_ptr<batch_job_t>> m_jobs;
+	atomic<size_t>                  m_next_job{0};
+public:
+	batch_scheduler_t(const batch_options_t& p_options);
+	bool add_input(const string& p_path);
+	size_t get_job_count() const {
+		return m_jobs.size();
+	}
+	int get_worker_count() const;
+	bool run();
+private:
+	int get_max_channels() const;
+	int get_job_threads() const;
+	bool has_output_path(const string& p_path) const;
+	void worker();
+	void run_job(batch_job_t& p_job);
+	void report(double p_elapsed, bool p_final);
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <string.h>
+#include "batch_media.h"
+#include "batch_writer.h"
+
+constexpr uint32_t SPEAKER_FRONT_LEFT    = 0x01;
+constexpr uint32_t SPEAKER_FRONT_RIGHT   = 0x02;
+constexpr uint32_t SPEAKER_FRONT_CENTER  = 0x04;
+constexpr uint32_t SPEAKER_LOW_FREQUENCY = 0x08;
+constexpr uint32_t SPEAKER_BACK_LEFT     = 0x10;
+constexpr uint32_t SPEAKER_BACK_RIGHT    = 0x20;
+
+constexpr int      WAV_BITS_PER_SAMPLE   = 24;
+constexpr int      WAV_BYTES_PER_SAMPLE  = WAV_BITS_PER_SAMPLE / 8;
+constexpr int      WAV_HEADER_SIZE       = 12 + 36 + 48 + 8;            // RIFF + JUNK/ds64 + fmt (extensible) + data
+constexpr uint64_t WAV_RIFF_SIZE_MAX     = 0xffffffffULL;
+
+static const uint8_t ksdataformat_subtype_pcm[16] = {
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+};
+
+static inline uint8_t* put_le16(uint8_t* p, uint16_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static inline uint8_t* put_le32(uint8_t* p, uint32_t v) {
+	p = put_le16(p, (uint16_t)v);
+	return put_le16(p, (uint16_t)(v >> 16));
+}
+
+static inline uint8_t* put_le64(uint8_t* p, uint64_t v) {
+	p = put_le32(p, (uint32_t)v);
+	return put_le32(p, (uint32_t)(v >> 32));
+}
+
+static inline uint8_t* put_id(uint8_t* p, const char* id) {
+	memcpy(p, id, 4);
+	return p + 4;
+}
+
+uint32_t batch_writer_t::get_channel_mask(int p_loudspeaker_config, int p_channels) {
+	switch (p_loudspeaker_config) {
+	case 0:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+	case 1:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	case 2:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY;
+	case 3:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	case 4:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	case 5:
+		return SPEAKER_FRONT_CENTER;
+	case 6:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER;
+	}
+	switch (p_channels) {
+	case 1:
+		return SPEAKER_FRONT_CENTER;
+	case 2:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+	case 3:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER;
+	case 4:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	case 5:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	case 6:
+		return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT | SPEAKER_FRONT_CENTER | SPEAKER_LOW_FREQUENCY | SPEAKER_BACK_LEFT | SPEAKER_BACK_RIGHT;
+	}
+	return 0;
+}
+
+batch_writer_t::batch_writer_t() {
+	m_file = nullptr;
+	m_format = output_format_e::WAV;
+	m_channels = 0;
+	m_samplerate = 0;
+	m_channel_mask = 0;
+	m_data_size = 0;
+	m_clipped = 0;
+}
+
+batch_writer_t::~batch_writer_t() {
+	close();
+}
+
+bool batch_writer_t::open(const char* p_path, output_format_e p_format, int p_channels, int p_samplerate, uint32_t p_channel_mask) {
+	close();
+	m_file = fopen(p_path, "wb");
+	if (!m_file) {
+		return false;
+	}
+	setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+	m_format = p_format;
+	m_channels = p_channels;
+	m_samplerate = p_samplerate;
+	m_channel_mask = p_channel_mask;
+	m_data_size = 0;
+	m_clipped = 0;
+	return m_format == output_format_e::WAV ? write_header() : true;
+}
+
+bool batch_writer_t::write(const float* p_data, size_t p_samples) {
+	auto values = p_samples * m_channels;
+	m_buffer.resize(values * WAV_BYTES_PER_SAMPLE);
+	auto out = m_buffer.data();
+	for (size_t i = 0; i < values; i++) {
+		auto v = p_data[i] * 8388608.0f;
+		int32_t s;
+		if (v >= 8388607.0f) {
+			s = 8388607;
+			m_clipped++;
+		}
+		else if (v <= -8388608.0f) {
+			s = -8388608;
+			m_clipped++;
+		}
+		else {
+			s = (int32_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+		}
+		out[0] = (uint8_t)s;
+		out[1] = (uint8_t)(s >> 8);
+		out[2] = (uint8_t)(s >> 16);
+		out += WAV_BYTES_PER_SAMPLE;
+	}
+	if (fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+		return false;
+	}
+	m_data_size += m_buffer.size();
+	return true;
+}
+
+bool batch_writer_t::close() {
+	if (!m_file) {
+		return true;
+	}
+	auto ok = true;
+	if (m_format == output_format_e::WAV) {
+		if (m_data_size & 1) {
+			ok = fputc(0, m_file) != EOF;
+		}
+		ok = ok && batch_fseek(m_file, 0, SEEK_SET) == 0 && write_header();
+	}
+	ok = (fclose(m_file) == 0) && ok;
+	m_file = nullptr;
+	return ok;
+}
+
+bool batch_writer_t::write_header() {
+	uint8_t header[WAV_HEADER_SIZE];
+	auto riff_size = (uint64_t)WAV_HEADER_SIZE - 8 + m_data_size + (m_data_size & 1);
+	auto is_rf64 = riff_size > WAV_RIFF_SIZE_MAX;
+	auto block_align = m_channels * WAV_BYTES_PER_SAMPLE;
+	auto p = header;
+	p = put_id(p, is_rf64 ? "RF64" : "RIFF");
+	p = put_le32(p, is_rf64 ? 0xffffffff : (uint32_t)riff_size);
+	p = put_id(p, "WAVE");
+	p = put_id(p, is_rf64 ? "ds64" : "JUNK");
+	p = put_le32(p, 28);
+	p = put_le64(p, is_rf64 ? riff_size : 0);
+	p = put_le64(p, is_rf64 ? m_data_size : 0);
+	p = put_le64(p, is_rf64 ? m_data_size / block_align : 0);
+	p = put_le32(p, 0);
+	p = put_id(p, "fmt ");
+	p = put_le32(p, 40);
+	p = put_le16(p, 0xfffe);
+	p = put_le16(p, (uint16_t)m_channels);
+	p = put_le32(p, (uint32_t)m_samplerate);
+	p = put_le32(p, (uint32_t)(m_samplerate * block_align));
+	p = put_le16(p, (uint16_t)block_align);
+	p = put_le16(p, WAV_BITS_PER_SAMPLE);
+	p = put_le16(p, 22);
+	p = put_le16(p, WAV_BITS_PER_SAMPLE);
+	p = put_le32(p, m_channel_mask);
+	memcpy(p, ksdataformat_subtype_pcm, sizeof(ksdataformat_subtype_pcm));
+	p += sizeof(ksdataformat_subtype_pcm);
+	p = put_id(p, "data");
+	p = put_le32(p, is_rf64 ? 0xffffffff : (uint32_t)m_data_size);
+	return fwrite(header, 1, sizeof(header), m_file) == sizeof(header);
+}
@@ -0,0 +1,59 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef _BATCH_WRITER_H_INCLUDED
+#define _BATCH_WRITER_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+using std::vector;
+
+enum class output_format_e {
+	WAV = 0,
+	RAW = 1
+};
+
+// 24-bit PCM sink. WAV files keep a JUNK chunk in front of "fmt " that becomes "ds64" (RF64) once the data
+// outgrows 4GB, RAW is headerless interleaved s24le ready to be piped into an external FLAC encoder.
+class batch_writer_t {
+	FILE*           m_file;
+	output_format_e m_format;
+	int             m_channels;
+	int             m_samplerate;
+	uint32_t        m_channel_mask;
+	uint64_t        m_data_size;
+	vector<uint8_t> m_buffer;
+	uint64_t        m_clipped;
+public:
+	static uint32_t get_channel_mask(int p_loudspeaker_config, int p_channels);
+	batch_writer_t();
+	~batch_writer_t();
+	bool open(const char* p_path, output_format_e p_format, int p_channels, int p_samplerate, uint32_t p_channel_mask);
+	bool write(const float* p_data, size_t p_samples);
+	bool close();
+	uint64_t get_clipped() const {
+		return m_clipped;
+	}
+private:
+	bool write_header();
+};
+
+#endif
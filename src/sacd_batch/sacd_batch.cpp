@@ -0,0 +1,114 @@
+/*
+* SACD Decoder plugin
+* Copyright (c) 2011-2020 Maxim V.Anisiutkin <maxim.anisiutkin@gmail.com>
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation; either
+* version 2.1 of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with FFmpeg; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Headless SACD ISO/DSDIFF/DSF to PCM converter, needs neither foobar2000 nor its SDK. Build from this directory with
+// g++ -std=c++17 -O2 -pthread -I. -I../libdstdec -I../libdstdec/decoder -I../libdstdec/binding -I../libdsdpcm *.cpp ../libdstdec/decoder/decoder.cpp ../libdstdec/binding/dst_decoder_mt.cpp ../libdsdpcm/DSDPCMConverterEngine.cpp -o sacd_batch
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include "batch_scheduler.h"
+
+static std::mutex g_console_mutex;
+
+void console_vfprintf(FILE* file, const char* fmt, va_list vl) {
+	std::lock_guard<std::mutex> lock(g_console_mutex);
+	vfprintf(file ? file : stderr, fmt, vl);
+	fputc('\n', file ? file : stderr);
+}
+
+void console_fprintf(FILE* file, const char* fmt, ...) {
+	va_list vl;
+	va_start(vl, fmt);
+	console_vfprintf(file, fmt, vl);
+	va_end(vl);
+}
+
+static void print_usage() {
+	fprintf(stderr,
+		"Usage: sacd_batch [options] <iso|dff|dsf|directory>...\n"
+		"  -o <dir>        output directory (default: .)\n"
+		"  -r <rate>       PCM samplerate, 44100 * 2^n or 48000 * 2^n dividing the DSD rate (default: 88200)\n"
+		"  -a <2ch|mch>    convert one area of a disc image only (default: both)\n"
+		"  -g <dB>         gain applied by the DSD2PCM filters (default: 0)\n"
+		"  -f <wav|raw>    24-bit WAV/RF64 or headerless s24le (default: wav)\n"
+		"  -j <jobs>       tracks converted in parallel (default: hardware threads / threads per job)\n"
+		"  -t <threads>    DST decoder threads per job (default: hardware threads / jobs - channels, at least 2)\n"
+	);
+}
+
+int main(int argc, char* argv[]) {
+	batch_options_t options;
+	vector<string> inputs;
+	for (auto i = 1; i < argc; i++) {
+		string arg = argv[i];
+		auto has_value = i + 1 < argc;
+		if (arg == "-o" && has_value) {
+			options.output_dir = argv[++i];
+		}
+		else if (arg == "-r" && has_value) {
+			options.pcm_samplerate = atoi(argv[++i]);
+		}
+		else if (arg == "-a" && has_value) {
+			string area = argv[++i];
+			options.area = (area == "2ch") ? AREA_TWOCH : (area == "mch") ? AREA_MULCH : AREA_NULL;
+		}
+		else if (arg == "-g" && has_value) {
+			options.gain_dB = (float)atof(argv[++i]);
+		}
+		else if (arg == "-f" && has_value) {
+			string format = argv[++i];
+			if (format != "wav" && format != "raw") {
+				print_usage();
+				return 1;
+			}
+			options.format = (format == "raw") ? output_format_e::RAW : output_format_e::WAV;
+		}
+		else if (arg == "-j" && has_value) {
+			options.jobs = atoi(argv[++i]);
+		}
+		else if (arg == "-t" && has_value) {
+			options.dst_threads = atoi(argv[++i]);
+		}
+		else if (arg[0] == '-') {
+			print_usage();
+			return 1;
+		}
+		else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || options.pcm_samplerate <= 0 || options.area == AREA_NULL) {
+		print_usage();
+		return 1;
+	}
+	batch_scheduler_t scheduler(options);
+	auto inputs_ok = true;
+	for (auto& input : inputs) {
+		inputs_ok = scheduler.add_input(input) && inputs_ok;
+	}
+	if (scheduler.get_job_count() == 0) {
+		fprintf(stderr, "Nothing to convert\n");
+		return 1;
+	}
+	fprintf(stderr, "Converting %zu tracks on %d workers\n", scheduler.get_job_count(), scheduler.get_worker_count());
+	return (scheduler.run() && inputs_ok) ? 0 : 2;
+}